@@ -0,0 +1,317 @@
+// Rebuilds the text of a RenderCore binary log, see BinaryLog.hpp for the file layout.
+//     blog_decoder <file.blog>
+// Lines are printed in time order as "[ms since open] [thread] [file:line] text".
+
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "BinaryLog.hpp"
+#include "spdlog/fmt/fmt.h"
+#include "spdlog/fmt/bundled/args.h"
+
+struct Site
+{
+    uint32_t line;
+    std::vector<uint8_t> types;
+    std::string file;
+    std::string format;
+};
+
+struct Line
+{
+    uint64_t ticks;
+    uint16_t thread;
+    std::string text;
+};
+
+// bounds checked cursor over a chunk payload
+class Reader
+{
+  public:
+    Reader(const char *begin, const char *end) : mP(begin), mEnd(end)
+    {
+    }
+
+    bool Has(size_t n) const
+    {
+        return static_cast<size_t>(mEnd - mP) >= n;
+    }
+
+    bool AtEnd() const
+    {
+        return mP >= mEnd;
+    }
+
+    template <typename T> bool Read(T &v)
+    {
+        if (!Has(sizeof(T)))
+        {
+            return false;
+        }
+        memcpy(&v, mP, sizeof(T));
+        mP += sizeof(T);
+        return true;
+    }
+
+    // splits the next len bytes off into their own reader
+    bool ReadChunk(size_t len, Reader &chunk)
+    {
+        if (!Has(len))
+        {
+            return false;
+        }
+        chunk = Reader(mP, mP + len);
+        mP += len;
+        return true;
+    }
+
+    bool ReadString(size_t len, std::string &s)
+    {
+        if (!Has(len))
+        {
+            return false;
+        }
+        s.assign(mP, len);
+        mP += len;
+        return true;
+    }
+
+  private:
+    const char *mP;
+    const char *mEnd;
+};
+
+static bool ReadSite(Reader &reader, std::map<uint32_t, Site> &sites)
+{
+    uint32_t id;
+    Site site;
+    uint8_t count;
+    if (!reader.Read(id) || !reader.Read(site.line) || !reader.Read(count))
+    {
+        return false;
+    }
+    site.types.resize(count);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (!reader.Read(site.types[i]))
+        {
+            return false;
+        }
+    }
+    uint16_t fileLen, formatLen;
+    if (!reader.Read(fileLen) || !reader.ReadString(fileLen, site.file) || !reader.Read(formatLen) ||
+        !reader.ReadString(formatLen, site.format))
+    {
+        return false;
+    }
+    sites[id] = site;
+    return true;
+}
+
+static bool ReadArgs(Reader &reader, const Site &site, fmt::dynamic_format_arg_store<fmt::format_context> &store)
+{
+    for (uint8_t type : site.types)
+    {
+        switch (static_cast<BinaryArgType>(type))
+        {
+        case BinaryArgType::I64: {
+            int64_t v;
+            if (!reader.Read(v))
+                return false;
+            store.push_back(v);
+            break;
+        }
+        case BinaryArgType::U64: {
+            uint64_t v;
+            if (!reader.Read(v))
+                return false;
+            store.push_back(v);
+            break;
+        }
+        case BinaryArgType::F64: {
+            double v;
+            if (!reader.Read(v))
+                return false;
+            store.push_back(v);
+            break;
+        }
+        case BinaryArgType::Ptr: {
+            uint64_t v;
+            if (!reader.Read(v))
+                return false;
+            store.push_back(reinterpret_cast<const void *>(static_cast<uintptr_t>(v)));
+            break;
+        }
+        case BinaryArgType::Str: {
+            uint8_t len;
+            std::string v;
+            if (!reader.Read(len) || !reader.ReadString(len, v))
+                return false;
+            store.push_back(v);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ReadEvents(Reader &reader, const std::map<uint32_t, Site> &sites, std::vector<Line> &lines)
+{
+    uint16_t thread;
+    if (!reader.Read(thread))
+    {
+        return false;
+    }
+
+    while (!reader.AtEnd())
+    {
+        uint32_t id;
+        uint64_t ticks;
+        if (!reader.Read(id) || !reader.Read(ticks))
+        {
+            return false;
+        }
+        // records have no length, an unknown site makes the rest of the chunk unreadable
+        auto site = sites.find(id);
+        if (site == sites.end())
+        {
+            fprintf(stderr, "unknown site %u, skipping the rest of thread %u's chunk\n", id, thread);
+            return false;
+        }
+
+        fmt::dynamic_format_arg_store<fmt::format_context> store;
+        if (!ReadArgs(reader, site->second, store))
+        {
+            return false;
+        }
+
+        Line line = {ticks, thread, {}};
+        try
+        {
+            line.text = fmt::vformat(site->second.format, store);
+        }
+        catch (const fmt::format_error &e)
+        {
+            line.text = site->second.format + " <format error: " + e.what() + ">";
+        }
+        std::string location = site->second.file;
+        size_t slash = location.find_last_of("/\\");
+        if (slash != std::string::npos)
+        {
+            location = location.substr(slash + 1);
+        }
+        line.text = fmt::format("[{}:{}] {}", location, site->second.line, line.text);
+        lines.push_back(std::move(line));
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s <file.blog>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (file == nullptr)
+    {
+        fprintf(stderr, "cannot open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::vector<char> data;
+    char buffer[64 * 1024];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    fclose(file);
+
+    if (data.size() < sizeof(BinaryLogMagic) || memcmp(data.data(), BinaryLogMagic, sizeof(BinaryLogMagic)) != 0)
+    {
+        fprintf(stderr, "%s is not a binary log\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    // sites and calibrations first, events may be written before a later site chunk of another thread
+    std::map<uint32_t, Site> sites;
+    std::vector<std::pair<uint64_t, uint64_t>> calibrations;
+    std::vector<Reader> events;
+
+    Reader reader(data.data() + sizeof(BinaryLogMagic), data.data() + data.size());
+    while (!reader.AtEnd())
+    {
+        uint8_t kind;
+        uint32_t size;
+        if (!reader.Read(kind) || !reader.Read(size) || !reader.Has(size))
+        {
+            fprintf(stderr, "truncated chunk, the log was probably not closed\n");
+            break;
+        }
+        Reader chunk(nullptr, nullptr);
+        reader.ReadChunk(size, chunk);
+
+        bool ok = true;
+        switch (static_cast<BinaryLogChunk>(kind))
+        {
+        case BinaryLogChunk::Site:
+            ok = ReadSite(chunk, sites);
+            break;
+        case BinaryLogChunk::Calibration: {
+            uint64_t ticks, ns;
+            ok = chunk.Read(ticks) && chunk.Read(ns);
+            if (ok)
+            {
+                calibrations.emplace_back(ticks, ns);
+            }
+            break;
+        }
+        case BinaryLogChunk::Events:
+            events.push_back(chunk);
+            break;
+        default:
+            fprintf(stderr, "skipping unknown chunk kind %u\n", kind);
+            break;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "malformed chunk of kind %u\n", kind);
+        }
+    }
+
+    std::vector<Line> lines;
+    for (Reader &chunk : events)
+    {
+        ReadEvents(chunk, sites, lines);
+    }
+    std::stable_sort(lines.begin(), lines.end(), [](const Line &a, const Line &b) { return a.ticks < b.ticks; });
+
+    // ticks to ns through the first and last calibration, ticks are already ns without a TSC
+    double origin = calibrations.empty() ? (lines.empty() ? 0.0 : static_cast<double>(lines[0].ticks))
+                                         : static_cast<double>(calibrations.front().first);
+    double nsPerTick = 1.0;
+    if (calibrations.size() >= 2 && calibrations.back().first > calibrations.front().first)
+    {
+        nsPerTick = static_cast<double>(calibrations.back().second - calibrations.front().second) /
+                    static_cast<double>(calibrations.back().first - calibrations.front().first);
+    }
+    else if (!calibrations.empty())
+    {
+        fprintf(stderr, "only one calibration point, times are in raw ticks\n");
+    }
+
+    for (const Line &line : lines)
+    {
+        double ms = (static_cast<double>(line.ticks) - origin) * nsPerTick / 1e6;
+        printf("[%12.6f] [%u] %s\n", ms, line.thread, line.text.c_str());
+    }
+    return EXIT_SUCCESS;
+}
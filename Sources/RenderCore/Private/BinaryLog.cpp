@@ -0,0 +1,252 @@
+#include "BinaryLog.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+// chunk kind, chunk size and thread index precede the records of an events chunk
+static const size_t EventsHeaderSize = 1 + 4 + 2;
+static const size_t ThreadBufferSize = 64 * 1024;
+
+struct BinaryLogThreadBuffer
+{
+    uint16_t thread;
+    size_t used;
+    std::vector<char> data;
+};
+
+struct BinaryLogState
+{
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::vector<char>> pending;
+    std::vector<std::vector<char>> spare;
+    std::vector<std::shared_ptr<BinaryLogThreadBuffer>> buffers;
+    // site chunks of every registered site, ids stay valid across files so each file starts with
+    // all of them
+    std::vector<std::vector<char>> sites;
+    uint32_t nextSite = 1;
+    bool stop = false;
+    FILE *file = nullptr;
+    std::thread writer;
+};
+
+std::atomic<bool> BinaryLog::sOpen(false);
+
+static BinaryLogState &State()
+{
+    static BinaryLogState state;
+    return state;
+}
+
+static void PutChunkHeader(std::vector<char> &chunk, BinaryLogChunk kind)
+{
+    uint32_t size = static_cast<uint32_t>(chunk.size() - 5);
+    chunk[0] = static_cast<char>(kind);
+    memcpy(&chunk[1], &size, 4);
+}
+
+static void ResetThreadBuffer(BinaryLogThreadBuffer &buffer)
+{
+    buffer.used = EventsHeaderSize;
+    memcpy(&buffer.data[5], &buffer.thread, 2);
+}
+
+// caller holds the state mutex
+static void HandOff(BinaryLogState &state, BinaryLogThreadBuffer &buffer)
+{
+    if (buffer.used == EventsHeaderSize)
+    {
+        return;
+    }
+
+    // swap the full buffer out instead of copying it, the writer recycles it afterwards
+    std::vector<char> chunk;
+    if (!state.spare.empty())
+    {
+        chunk = std::move(state.spare.back());
+        state.spare.pop_back();
+    }
+    chunk.resize(ThreadBufferSize);
+    chunk.swap(buffer.data);
+    chunk.resize(buffer.used);
+
+    PutChunkHeader(chunk, BinaryLogChunk::Events);
+    state.pending.push_back(std::move(chunk));
+    state.cond.notify_one();
+    ResetThreadBuffer(buffer);
+}
+
+static void PushCalibration(BinaryLogState &state)
+{
+    std::vector<char> chunk(5 + 16);
+    uint64_t ticks = BinaryLog::Ticks();
+    uint64_t ns = BinaryLog::SteadyNs();
+    memcpy(&chunk[5], &ticks, 8);
+    memcpy(&chunk[13], &ns, 8);
+    PutChunkHeader(chunk, BinaryLogChunk::Calibration);
+    state.pending.push_back(std::move(chunk));
+    state.cond.notify_one();
+}
+
+static void WriterLoop(BinaryLogState *state)
+{
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true)
+    {
+        state->cond.wait(lock, [state] { return state->stop || !state->pending.empty(); });
+        while (!state->pending.empty())
+        {
+            std::vector<char> chunk = std::move(state->pending.front());
+            state->pending.pop_front();
+
+            lock.unlock();
+            fwrite(chunk.data(), 1, chunk.size(), state->file);
+            lock.lock();
+
+            if (chunk.capacity() >= ThreadBufferSize)
+            {
+                state->spare.push_back(std::move(chunk));
+            }
+        }
+        if (state->stop)
+        {
+            return;
+        }
+    }
+}
+
+uint64_t BinaryLog::SteadyNs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+bool BinaryLog::Open(const std::string &path)
+{
+    BinaryLogState &state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.file != nullptr)
+    {
+        return false;
+    }
+
+    state.file = fopen(path.c_str(), "wb");
+    if (state.file == nullptr)
+    {
+        return false;
+    }
+    fwrite(BinaryLogMagic, 1, sizeof(BinaryLogMagic), state.file);
+
+    // sites registered for earlier files keep their ids, the decoder only knows the sites
+    // written to this one
+    for (const auto &site : state.sites)
+    {
+        state.pending.push_back(site);
+    }
+    state.stop = false;
+    PushCalibration(state);
+    state.writer = std::thread(WriterLoop, &state);
+    sOpen.store(true, std::memory_order_release);
+    return true;
+}
+
+void BinaryLog::Close()
+{
+    BinaryLogState &state = State();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.file == nullptr)
+        {
+            return;
+        }
+
+        sOpen.store(false, std::memory_order_release);
+        for (auto &buffer : state.buffers)
+        {
+            HandOff(state, *buffer);
+        }
+        PushCalibration(state);
+        state.stop = true;
+        state.cond.notify_one();
+    }
+
+    state.writer.join();
+    fclose(state.file);
+    state.file = nullptr;
+}
+
+char *BinaryLog::reserve(size_t size)
+{
+    // the registry owns the buffer, so it outlives its thread and is flushed by Close
+    thread_local BinaryLogThreadBuffer *buffer = nullptr;
+    if (buffer == nullptr)
+    {
+        BinaryLogState &state = State();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        auto owned = std::make_shared<BinaryLogThreadBuffer>();
+        owned->thread = static_cast<uint16_t>(state.buffers.size());
+        owned->data.resize(ThreadBufferSize);
+        ResetThreadBuffer(*owned);
+        state.buffers.push_back(owned);
+        buffer = owned.get();
+    }
+
+    if (buffer->used + size > buffer->data.size())
+    {
+        BinaryLogState &state = State();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        HandOff(state, *buffer);
+    }
+
+    char *p = &buffer->data[buffer->used];
+    buffer->used += size;
+    return p;
+}
+
+uint32_t BinaryLog::registerSite(BinaryLogSite &site, const uint8_t *types, size_t count)
+{
+    BinaryLogState &state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if (id != 0)
+    {
+        return id;
+    }
+    id = state.nextSite++;
+
+    uint16_t fileLen = static_cast<uint16_t>(strlen(site.file));
+    uint16_t formatLen = static_cast<uint16_t>(strlen(site.format));
+    std::vector<char> chunk(5 + 4 + 4 + 1 + count + 2 + fileLen + 2 + formatLen);
+    char *p = &chunk[5];
+    memcpy(p, &id, 4);
+    memcpy(p + 4, &site.line, 4);
+    p += 8;
+    *p++ = static_cast<char>(count);
+    memcpy(p, types, count);
+    p += count;
+    memcpy(p, &fileLen, 2);
+    memcpy(p + 2, site.file, fileLen);
+    p += 2 + fileLen;
+    memcpy(p, &formatLen, 2);
+    memcpy(p + 2, site.format, formatLen);
+
+    PutChunkHeader(chunk, BinaryLogChunk::Site);
+    state.sites.push_back(chunk);
+    if (state.file != nullptr)
+    {
+        state.pending.push_back(std::move(chunk));
+        state.cond.notify_one();
+    }
+
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
@@ -0,0 +1,231 @@
+#ifndef VULKAN_CORE_BINARY_LOG_H
+#define VULKAN_CORE_BINARY_LOG_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BINARY_LOG_USE_TSC 1
+#endif
+
+// Binary log for hot paths. A BLOG call copies its call site id, a timestamp and the raw
+// argument bytes into a per-thread buffer; the format string is stored once per call site and
+// the text is only rebuilt offline by blog_decoder. Full buffers are handed to a writer thread.
+//
+// File layout: BinaryLogMagic, then chunks of { uint8 kind, uint32 size, payload }.
+//   Site:        uint32 id, uint32 line, uint8 argCount, uint8 types[argCount],
+//                uint16 fileLen, file, uint16 formatLen, format
+//   Events:      uint16 thread, then records of { uint32 id, uint64 ticks, args }
+//   Calibration: uint64 ticks, uint64 steady clock ns
+
+static const char BinaryLogMagic[8] = {'R', 'C', 'B', 'L', 'O', 'G', '1', '\0'};
+
+enum class BinaryLogChunk : uint8_t
+{
+    Site = 1,
+    Events = 2,
+    Calibration = 3,
+};
+
+enum class BinaryArgType : uint8_t
+{
+    I64 = 1,
+    U64 = 2,
+    F64 = 3,
+    Str = 4,
+    Ptr = 5,
+};
+
+// strings longer than this are cut, the hot path should log ids rather than text
+static const size_t BinaryLogMaxString = 255;
+
+struct BinaryLogSite
+{
+    const char *format;
+    const char *file;
+    uint32_t line;
+    std::atomic<uint32_t> id;
+};
+
+template <typename T, typename Enable = void> struct BinaryArg;
+
+template <typename T> struct BinaryArg<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    static const BinaryArgType type = std::is_signed<T>::value ? BinaryArgType::I64 : BinaryArgType::U64;
+    static size_t Size(T)
+    {
+        return 8;
+    }
+    static char *Write(char *p, T v)
+    {
+        if (std::is_signed<T>::value)
+        {
+            int64_t w = static_cast<int64_t>(v);
+            memcpy(p, &w, 8);
+        }
+        else
+        {
+            uint64_t w = static_cast<uint64_t>(v);
+            memcpy(p, &w, 8);
+        }
+        return p + 8;
+    }
+};
+
+template <typename T> struct BinaryArg<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+    static const BinaryArgType type = BinaryArgType::I64;
+    static size_t Size(T)
+    {
+        return 8;
+    }
+    static char *Write(char *p, T v)
+    {
+        int64_t w = static_cast<int64_t>(v);
+        memcpy(p, &w, 8);
+        return p + 8;
+    }
+};
+
+template <typename T> struct BinaryArg<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static const BinaryArgType type = BinaryArgType::F64;
+    static size_t Size(T)
+    {
+        return 8;
+    }
+    static char *Write(char *p, T v)
+    {
+        double w = static_cast<double>(v);
+        memcpy(p, &w, 8);
+        return p + 8;
+    }
+};
+
+template <> struct BinaryArg<const char *>
+{
+    static const BinaryArgType type = BinaryArgType::Str;
+    static size_t Size(const char *v)
+    {
+        size_t len = v ? strlen(v) : 0;
+        return 1 + (len > BinaryLogMaxString ? BinaryLogMaxString : len);
+    }
+    static char *Write(char *p, const char *v)
+    {
+        size_t len = Size(v) - 1;
+        *p++ = static_cast<char>(len);
+        memcpy(p, v, len);
+        return p + len;
+    }
+};
+
+template <> struct BinaryArg<char *> : BinaryArg<const char *>
+{
+};
+
+template <typename T> struct BinaryArg<T *, typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value>::type>
+{
+    static const BinaryArgType type = BinaryArgType::Ptr;
+    static size_t Size(const T *)
+    {
+        return 8;
+    }
+    static char *Write(char *p, const T *v)
+    {
+        uint64_t w = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v));
+        memcpy(p, &w, 8);
+        return p + 8;
+    }
+};
+
+class BinaryLog
+{
+  public:
+    // start writing to path, returns false if the file cannot be created
+    static bool Open(const std::string &path);
+    // flush every thread's buffer and close the file, call once logging threads are idle
+    static void Close();
+
+    static bool IsOpen()
+    {
+        return sOpen.load(std::memory_order_relaxed);
+    }
+
+    static inline uint64_t Ticks()
+    {
+#ifdef BINARY_LOG_USE_TSC
+        return __rdtsc();
+#else
+        return SteadyNs();
+#endif
+    }
+
+    static uint64_t SteadyNs();
+
+    template <typename... Args> static void Write(BinaryLogSite &site, const Args &...args)
+    {
+        if (!IsOpen())
+        {
+            return;
+        }
+
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (id == 0)
+        {
+            const uint8_t types[] = {0, static_cast<uint8_t>(BinaryArg<typename std::decay<const Args>::type>::type)...};
+            id = registerSite(site, types + 1, sizeof...(Args));
+        }
+
+        size_t size = 4 + 8 + argsSize(args...);
+        char *p = reserve(size);
+        memcpy(p, &id, 4);
+        uint64_t ticks = Ticks();
+        memcpy(p + 4, &ticks, 8);
+        writeArgs(p + 12, args...);
+    }
+
+  private:
+    static size_t argsSize()
+    {
+        return 0;
+    }
+
+    template <typename T, typename... Rest> static size_t argsSize(const T &v, const Rest &...rest)
+    {
+        typedef typename std::decay<const T>::type Decayed;
+        return BinaryArg<Decayed>::Size(static_cast<Decayed>(v)) + argsSize(rest...);
+    }
+
+    static void writeArgs(char *)
+    {
+    }
+
+    template <typename T, typename... Rest> static void writeArgs(char *p, const T &v, const Rest &...rest)
+    {
+        typedef typename std::decay<const T>::type Decayed;
+        writeArgs(BinaryArg<Decayed>::Write(p, static_cast<Decayed>(v)), rest...);
+    }
+
+    // returns size bytes in the calling thread's buffer, handing the buffer off first if it is full
+    static char *reserve(size_t size);
+    static uint32_t registerSite(BinaryLogSite &site, const uint8_t *types, size_t count);
+
+    static std::atomic<bool> sOpen;
+};
+
+#define BLOG(format, ...)                                                                                              \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        static BinaryLogSite blogSite = {format, __FILE__, __LINE__, {0}};                                           \
+        BinaryLog::Write(blogSite, ##__VA_ARGS__);                                                                     \
+    } while (0)
+
+#endif // VULKAN_CORE_BINARY_LOG_H
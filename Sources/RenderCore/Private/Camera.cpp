@@ -0,0 +1,134 @@
+#include "Camera.hpp"
+
+#include <string.h>
+
+#include "SimdMath.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+static const uint32_t DirtyAll = 0xF;
+
+Camera::Camera()
+    : mFovY(0.0f), mAspect(1.0f), mNear(0.1f), mFar(100.0f), mPerspective(false), mEye(0.0f), mCenter(0.0f),
+      mUp(0.0f, 1.0f, 0.0f), mLookAt(false), mProjection(1.0f), mView(1.0f), mModel(1.0f), mClip(VulkanClip()),
+      mClipProjection(1.0f), mViewProjection(1.0f), mMVP(1.0f), mDirty(DirtyAll), mVersion(1)
+{
+}
+
+Camera::Camera(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model, const glm::mat4 &clip)
+    : Camera()
+{
+    mProjection = projection;
+    mView = view;
+    mModel = model;
+    mClip = clip;
+}
+
+glm::mat4 Camera::VulkanClip()
+{
+    // flips y and maps depth from [-1, 1] to [0, 1]
+    return glm::mat4(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.5f, 1.0f);
+}
+
+void Camera::SetProjection(const glm::mat4 &projection)
+{
+    mProjection = projection;
+    mPerspective = false;
+    markDirty(DirtyProjection | DirtyViewProjection | DirtyMVP);
+}
+
+void Camera::SetPerspective(float fovY, float aspect, float zNear, float zFar)
+{
+    mFovY = fovY;
+    mAspect = aspect;
+    mNear = zNear;
+    mFar = zFar;
+    mPerspective = true;
+    markDirty(DirtyProjection | DirtyViewProjection | DirtyMVP);
+}
+
+void Camera::SetView(const glm::mat4 &view)
+{
+    mView = view;
+    mLookAt = false;
+    // the view is already final, only the products are stale
+    markDirty(DirtyViewProjection | DirtyMVP);
+}
+
+void Camera::LookAt(const glm::vec3 &eye, const glm::vec3 &center, const glm::vec3 &up)
+{
+    mEye = eye;
+    mCenter = center;
+    mUp = up;
+    mLookAt = true;
+    markDirty(DirtyView | DirtyViewProjection | DirtyMVP);
+}
+
+void Camera::SetModel(const glm::mat4 &model)
+{
+    mModel = model;
+    markDirty(DirtyMVP);
+}
+
+void Camera::SetClip(const glm::mat4 &clip)
+{
+    mClip = clip;
+    markDirty(DirtyProjection | DirtyViewProjection | DirtyMVP);
+}
+
+const glm::mat4 &Camera::GetProjection()
+{
+    if (mDirty & DirtyProjection)
+    {
+        if (mPerspective)
+        {
+            mProjection = glm::perspective(mFovY, mAspect, mNear, mFar);
+        }
+        MultiplyMat4(mClip, mProjection, mClipProjection);
+        mDirty &= ~DirtyProjection;
+    }
+    return mProjection;
+}
+
+const glm::mat4 &Camera::GetView()
+{
+    if (mDirty & DirtyView)
+    {
+        if (mLookAt)
+        {
+            mView = glm::lookAt(mEye, mCenter, mUp);
+        }
+        mDirty &= ~DirtyView;
+    }
+    return mView;
+}
+
+const glm::mat4 &Camera::GetViewProjection()
+{
+    if (mDirty & DirtyViewProjection)
+    {
+        GetProjection();
+        MultiplyMat4(mClipProjection, GetView(), mViewProjection);
+        mDirty &= ~DirtyViewProjection;
+    }
+    return mViewProjection;
+}
+
+const glm::mat4 &Camera::GetMVP()
+{
+    if (mDirty & DirtyMVP)
+    {
+        MultiplyMat4(GetViewProjection(), mModel, mMVP);
+        mDirty &= ~DirtyMVP;
+    }
+    return mMVP;
+}
+
+Frustum Camera::GetFrustum()
+{
+    return Frustum::FromViewProjection(GetViewProjection());
+}
+
+void Camera::WriteMVP(void *dst)
+{
+    memcpy(dst, &GetMVP()[0][0], sizeof(glm::mat4));
+}
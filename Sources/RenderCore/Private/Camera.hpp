@@ -1,48 +1,92 @@
-#ifndef CAMERA_H
-#define CAMERA_H
+#ifndef VULKAN_CORE_CAMERA_H
+#define VULKAN_CORE_CAMERA_H
 
+#include "FrustumCuller.hpp"
 #include "glm/glm.hpp"
 
+#include <stdint.h>
+
+// Projection, view and model matrices with the products shaders need. Setters only mark what
+// they invalidate; a product is rebuilt the first time it is read after one of its inputs
+// changed, so a camera that did not move costs nothing per frame. GetVersion changes with every
+// edit, uniform writers compare it to skip uploads of an unchanged mvp.
 class Camera
 {
   public:
-    explicit Camera(glm::mat4 projection, glm::mat4 view, glm::mat4 model, glm::mat4 clip){}
+    Camera();
+    Camera(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model, const glm::mat4 &clip);
+
+    void SetProjection(const glm::mat4 &projection);
+    // fovY in radians, evaluated lazily
+    void SetPerspective(float fovY, float aspect, float zNear, float zFar);
+    void SetView(const glm::mat4 &view);
+    // evaluated lazily
+    void LookAt(const glm::vec3 &eye, const glm::vec3 &center, const glm::vec3 &up);
+    void SetModel(const glm::mat4 &model);
+    // maps GL clip space to Vulkan's, VulkanClip() by default
+    void SetClip(const glm::mat4 &clip);
 
-    bool SetProjection(glm::mat4 projection)
+    const glm::mat4 &GetProjection();
+    const glm::mat4 &GetView();
+    const glm::mat4 &GetModel() const
     {
-        mProjection = projection;
-        updateMVP();
+        return mModel;
     }
+    // clip * projection * view
+    const glm::mat4 &GetViewProjection();
+    // clip * projection * view * model
+    const glm::mat4 &GetMVP();
+    // culling planes of the current view projection
+    Frustum GetFrustum();
 
-    bool SetView(glm::mat4 view)
+    uint64_t GetVersion() const
     {
-        mView = view;
-        updateMVP();
+        return mVersion;
     }
 
-    bool SetModel(glm::mat4 model)
+    // copies the mvp to dst, which may be mapped uniform memory
+    void WriteMVP(void *dst);
+
+    static glm::mat4 VulkanClip();
+
+  private:
+    enum DirtyFlags : uint32_t
     {
-        mModel = model;
-        updateMVP();
-    }
-	
-    bool SetClip(glm::mat4 clip)
+        DirtyProjection = 1 << 0,
+        DirtyView = 1 << 1,
+        DirtyViewProjection = 1 << 2,
+        DirtyMVP = 1 << 3,
+    };
+
+    void markDirty(uint32_t flags)
     {
-        mClip = clip;
-        updateMVP();
+        mDirty |= flags;
+        mVersion++;
     }
 
-  private:
-	float mWidth;
-	float mHeight;
-	float mFOV;
-	float mNear;
-	float mFar;
-    glm::mat4 mProjection;
+    float mFovY;
+    float mAspect;
+    float mNear;
+    float mFar;
+    bool mPerspective;
+
+    glm::vec3 mEye;
+    glm::vec3 mCenter;
+    glm::vec3 mUp;
+    bool mLookAt;
 
+    glm::mat4 mProjection;
     glm::mat4 mView;
     glm::mat4 mModel;
     glm::mat4 mClip;
+
+    // clip * projection, only rebuilt when one of the two changes
+    glm::mat4 mClipProjection;
+    glm::mat4 mViewProjection;
+    glm::mat4 mMVP;
+
+    uint32_t mDirty;
+    uint64_t mVersion;
 };
 
-#endif
\ No newline at end of file
+#endif // VULKAN_CORE_CAMERA_H
@@ -0,0 +1,77 @@
+#include "CpuFeatures.hpp"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+static bool DetectAvx2()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool fma = (info[2] & (1 << 12)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    // the os has to save the ymm registers too
+    if (!fma || !osxsave || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool CpuSupportsAvx2()
+{
+    static const bool supported = DetectAvx2();
+    return supported;
+}
+
+static bool DetectAvx512()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    // ymm plus the opmask and both halves of the zmm registers
+    if (!osxsave || (_xgetbv(0) & 0xE6) != 0xE6)
+    {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 16)) != 0;
+#else
+    return false;
+#endif
+}
+
+bool CpuSupportsAvx512()
+{
+    static const bool supported = DetectAvx512();
+    return supported;
+}
+
+const char *GetSimdIsaName(SimdIsa isa)
+{
+    switch (isa)
+    {
+    case SimdIsa::Sse2:
+        return "SSE2";
+    case SimdIsa::Avx2:
+        return "AVX2";
+    case SimdIsa::Avx512:
+        return "AVX-512";
+    case SimdIsa::Neon:
+        return "NEON";
+    default:
+        return "scalar";
+    }
+}
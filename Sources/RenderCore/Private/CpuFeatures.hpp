@@ -0,0 +1,21 @@
+#ifndef VULKAN_CORE_CPU_FEATURES_H
+#define VULKAN_CORE_CPU_FEATURES_H
+
+// Runtime checks that gate the *Avx2.cpp and *Avx512.cpp kernels, evaluated once and cached.
+bool CpuSupportsAvx2();
+// AVX-512 foundation with the zmm state enabled by the os
+bool CpuSupportsAvx512();
+
+// instruction sets of the SIMD kernel tables, see SimdDispatch
+enum class SimdIsa
+{
+    Scalar,
+    Sse2,
+    Avx2,
+    Avx512,
+    Neon,
+};
+
+const char *GetSimdIsaName(SimdIsa isa);
+
+#endif // VULKAN_CORE_CPU_FEATURES_H
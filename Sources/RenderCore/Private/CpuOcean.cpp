@@ -0,0 +1,370 @@
+#include "CpuOcean.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#include "CpuProfiler.hpp"
+#include "FftKernels.hpp"
+#include "SimdDispatch.hpp"
+#include "TaskPool.hpp"
+
+using namespace RENDERCORE_LANES_NAMESPACE;
+
+static SimdDispatch<FftKernels> sDispatch(MakeFftKernels<ScalarLanes>, MakeFftKernels<DefaultLanes>,
+                                          GetAvx2FftKernels, GetAvx512FftKernels);
+
+static const FftKernels &Kernels()
+{
+    return sDispatch.Get();
+}
+
+// two strips to ping-pong between
+struct StripScratch
+{
+    std::vector<float> storage;
+    FftStrip strips[2];
+
+    void Reserve(size_t floats)
+    {
+        if (storage.size() >= floats * 4)
+        {
+            return;
+        }
+        storage.resize(floats * 4);
+        for (int i = 0; i < 2; i++)
+        {
+            strips[i].re = storage.data() + floats * (2 * i);
+            strips[i].im = storage.data() + floats * (2 * i + 1);
+        }
+    }
+};
+
+static thread_local StripScratch tScratch;
+
+// square blocks of the in place transpose, both blocks of a swapped pair stay in L1
+static const uint32_t TransposeBlock = 32;
+
+CpuOcean::CpuOcean(const OceanSettings &settings) : mSettings(settings), mLogSize(0)
+{
+    const uint32_t n = mSettings.size;
+    assert(n >= 16 && n <= 1024 && (n & (n - 1)) == 0);
+    assert(mSettings.cascadeCount >= 1 && mSettings.cascadeCount <= OceanSettings::MaxCascades);
+    while ((1u << mLogSize) < n)
+    {
+        mLogSize++;
+    }
+
+    size_t area = static_cast<size_t>(n) * n;
+    mPlaneCount = static_cast<size_t>(mSettings.cascadeCount) * OceanFieldCount;
+    mSpectrum.resize(area * mSettings.cascadeCount);
+    for (uint32_t cascade = 0; cascade < mSettings.cascadeCount; cascade++)
+    {
+        GenerateOceanSpectrum(mSettings, cascade, mSpectrum.data() + area * cascade);
+    }
+
+    // frequencies are whole multiples of the loop frequency, so one table of rotations per
+    // update replaces a sine and cosine per texel
+    const float quantum = 2.0f * 3.14159265358979f / mSettings.loopPeriod;
+    uint32_t highest = 0;
+    mFrequency.resize(mSpectrum.size());
+    for (size_t i = 0; i < mSpectrum.size(); i++)
+    {
+        mFrequency[i] = static_cast<uint32_t>(lroundf(mSpectrum[i].k.z / quantum));
+        highest = mFrequency[i] > highest ? mFrequency[i] : highest;
+    }
+    if (highest < area / 16)
+    {
+        mRotation.resize(2 * (static_cast<size_t>(highest) + 1));
+    }
+    else
+    {
+        mFrequency.clear();
+    }
+
+    // twiddles in double so the table is as exact as float allows
+    for (uint32_t span = (mLogSize & 1) != 0 ? 2 : 1; span < n; span *= 4)
+    {
+        mStageTwiddles.push_back(mTwiddles.size());
+        for (uint32_t k = 0; k < span; k++)
+        {
+            double angle = 2.0 * 3.14159265358979323846 * k / (4.0 * span);
+            for (int r = 1; r <= 3; r++)
+            {
+                mTwiddles.push_back(static_cast<float>(cos(angle * r)));
+                mTwiddles.push_back(static_cast<float>(sin(angle * r)));
+            }
+        }
+    }
+
+    mRe.resize(area * mPlaneCount);
+    mIm.resize(area * mPlaneCount);
+    mDisplacement.resize(area * mSettings.cascadeCount);
+    mNormal.resize(area * mSettings.cascadeCount);
+}
+
+void CpuOcean::SetChoppiness(float choppiness)
+{
+    mSettings.choppiness = choppiness;
+}
+
+void CpuOcean::Update(double seconds)
+{
+    CPU_ZONE("CpuOcean::Update");
+
+    // the transposes make the second column pass run along the rows and restore the layout
+    advanceSpectrum(WrapOceanTime(mSettings, seconds));
+    transformColumns();
+    transpose();
+    transformColumns();
+    transpose();
+    resolve();
+}
+
+// OceanSpectrum.comp, except that the rotations come from the table when there is one
+void CpuOcean::advanceSpectrum(float time)
+{
+    const uint32_t n = mSettings.size;
+    const size_t area = static_cast<size_t>(n) * n;
+    const double step = 2.0 * 3.14159265358979323846 / mSettings.loopPeriod * time;
+    for (size_t m = 0; m < mRotation.size() / 2; m++)
+    {
+        mRotation[2 * m] = static_cast<float>(cos(step * m));
+        mRotation[2 * m + 1] = static_cast<float>(sin(step * m));
+    }
+
+    TaskPool::Instance().ParallelFor(mSettings.cascadeCount * n, 16, [&](size_t begin, size_t end) {
+        for (size_t line = begin; line < end; line++)
+        {
+            uint32_t cascade = static_cast<uint32_t>(line / n);
+            size_t row = (line % n) * n;
+            const OceanSpectrumTexel *texels = mSpectrum.data() + area * cascade + row;
+            const uint32_t *frequency = mFrequency.empty() ? nullptr : mFrequency.data() + area * cascade + row;
+            float *re[OceanFieldCount];
+            float *im[OceanFieldCount];
+            for (uint32_t field = 0; field < OceanFieldCount; field++)
+            {
+                re[field] = mRe.data() + plane(cascade, field) + row;
+                im[field] = mIm.data() + plane(cascade, field) + row;
+            }
+
+            for (uint32_t x = 0; x < n; x++)
+            {
+                const OceanSpectrumTexel &texel = texels[x];
+                float c;
+                float s;
+                if (frequency != nullptr)
+                {
+                    c = mRotation[2 * frequency[x]];
+                    s = mRotation[2 * frequency[x] + 1];
+                }
+                else
+                {
+                    float phase = texel.k.z * time;
+                    c = cosf(phase);
+                    s = sinf(phase);
+                }
+                // h0(k) e^(i phase) + conj(h0(-k)) e^(-i phase)
+                float hr = (texel.h0.x * c - texel.h0.y * s) + (texel.h0.z * c + texel.h0.w * s);
+                float hi = (texel.h0.x * s + texel.h0.y * c) + (texel.h0.w * c - texel.h0.z * s);
+
+                float kx = texel.k.x;
+                float kz = texel.k.y;
+                float invK = texel.k.w;
+                // i h scaled: (-hi, hr) * s
+                float sxr = -hi * kx, sxi = hr * kx;
+                float szr = -hi * kz, szi = hr * kz;
+                float dxr = -hi * (-kx * invK), dxi = hr * (-kx * invK);
+                float dzr = -hi * (-kz * invK), dzi = hr * (-kz * invK);
+                float dxdxr = hr * (kx * kx * invK), dxdxi = hi * (kx * kx * invK);
+                float dzdzr = hr * (kz * kz * invK), dzdzi = hi * (kz * kz * invK);
+                float dxdzr = hr * (kx * kz * invK), dxdzi = hi * (kx * kz * invK);
+
+                // a + i b
+                re[0][x] = hr + -sxi;
+                im[0][x] = hi + sxr;
+                re[1][x] = szr + -dxi;
+                im[1][x] = szi + dxr;
+                re[2][x] = dzr + -dxdxi;
+                im[2][x] = dzi + dxdxr;
+                re[3][x] = dzdzr + -dxdzi;
+                im[3][x] = dzdzi + dxdzr;
+            }
+        }
+    });
+}
+
+void CpuOcean::transformColumns()
+{
+    const uint32_t n = mSettings.size;
+    const size_t area = static_cast<size_t>(n) * n;
+    const size_t stripsPerPlane = n / StripWidth;
+    const FftKernels &kernels = Kernels();
+    TaskPool::Instance().ParallelFor(mPlaneCount * stripsPerPlane, 4, [&](size_t begin, size_t end) {
+        StripScratch &scratch = tScratch;
+        scratch.Reserve(area / stripsPerPlane);
+        for (size_t strip = begin; strip < end; strip++)
+        {
+            size_t first = (strip / stripsPerPlane) * area + (strip % stripsPerPlane) * StripWidth;
+            float *re = mRe.data() + first;
+            float *im = mIm.data() + first;
+            for (uint32_t row = 0; row < n; row++)
+            {
+                memcpy(scratch.strips[0].re + row * StripWidth, re + static_cast<size_t>(row) * n,
+                       StripWidth * sizeof(float));
+                memcpy(scratch.strips[0].im + row * StripWidth, im + static_cast<size_t>(row) * n,
+                       StripWidth * sizeof(float));
+            }
+
+            int src = 0;
+            uint32_t span = 1;
+            if ((mLogSize & 1) != 0)
+            {
+                kernels.radix2(scratch.strips[src], scratch.strips[1 - src], n, StripWidth);
+                src = 1 - src;
+                span = 2;
+            }
+            for (size_t stage = 0; span < n; stage++, span *= 4)
+            {
+                kernels.radix4(scratch.strips[src], scratch.strips[1 - src], n, span, StripWidth,
+                               mTwiddles.data() + mStageTwiddles[stage]);
+                src = 1 - src;
+            }
+
+            for (uint32_t row = 0; row < n; row++)
+            {
+                memcpy(re + static_cast<size_t>(row) * n, scratch.strips[src].re + row * StripWidth,
+                       StripWidth * sizeof(float));
+                memcpy(im + static_cast<size_t>(row) * n, scratch.strips[src].im + row * StripWidth,
+                       StripWidth * sizeof(float));
+            }
+        }
+    });
+}
+
+void CpuOcean::transpose()
+{
+    const uint32_t n = mSettings.size;
+    const size_t area = static_cast<size_t>(n) * n;
+    const uint32_t block = n < TransposeBlock ? n : TransposeBlock;
+    const uint32_t blocks = n / block;
+    // One task per block row of a plane, it swaps the blocks right of the diagonal with their
+    // mirrors. Rows of a block are a power of two apart and would evict each other from L1 if
+    // walked down a column, so both blocks are copied out row by row and written back from the
+    // copies; only the copies are read across.
+    TaskPool::Instance().ParallelFor(mPlaneCount * blocks, 1, [&](size_t begin, size_t end) {
+        float a[TransposeBlock * TransposeBlock];
+        float b[TransposeBlock * TransposeBlock];
+        for (size_t task = begin; task < end; task++)
+        {
+            size_t first = (task / blocks) * area;
+            uint32_t by = static_cast<uint32_t>(task % blocks) * block;
+            for (float *p : {mRe.data() + first, mIm.data() + first})
+            {
+                for (uint32_t bx = by; bx < n; bx += block)
+                {
+                    float *pa = p + static_cast<size_t>(by) * n + bx;
+                    float *pb = p + static_cast<size_t>(bx) * n + by;
+                    for (uint32_t y = 0; y < block; y++)
+                    {
+                        memcpy(a + y * block, pa + static_cast<size_t>(y) * n, block * sizeof(float));
+                        memcpy(b + y * block, pb + static_cast<size_t>(y) * n, block * sizeof(float));
+                    }
+                    for (uint32_t y = 0; y < block; y++)
+                    {
+                        float *rowA = pa + static_cast<size_t>(y) * n;
+                        float *rowB = pb + static_cast<size_t>(y) * n;
+                        for (uint32_t x = 0; x < block; x++)
+                        {
+                            rowA[x] = b[x * block + y];
+                            rowB[x] = a[x * block + y];
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+// OceanResolve.comp, operation for operation
+void CpuOcean::resolve()
+{
+    const uint32_t n = mSettings.size;
+    const size_t area = static_cast<size_t>(n) * n;
+    const float lambda = mSettings.choppiness;
+    TaskPool::Instance().ParallelFor(mSettings.cascadeCount * n, 16, [&](size_t begin, size_t end) {
+        for (size_t line = begin; line < end; line++)
+        {
+            uint32_t cascade = static_cast<uint32_t>(line / n);
+            size_t row = (line % n) * n;
+            const float *re[OceanFieldCount];
+            const float *im[OceanFieldCount];
+            for (uint32_t field = 0; field < OceanFieldCount; field++)
+            {
+                re[field] = mRe.data() + plane(cascade, field) + row;
+                im[field] = mIm.data() + plane(cascade, field) + row;
+            }
+            glm::vec4 *displacement = mDisplacement.data() + area * cascade + row;
+            glm::vec4 *normal = mNormal.data() + area * cascade + row;
+
+            for (uint32_t x = 0; x < n; x++)
+            {
+                float jxx = 1.0f + lambda * im[2][x];
+                float jzz = 1.0f + lambda * re[3][x];
+                float jxz = lambda * im[3][x];
+                float jacobian = jxx * jzz - jxz * jxz;
+
+                // cross(tangentZ, tangentX) with tangentX = (jxx, dh/dx, jxz), tangentZ = (jxz, dh/dz, jzz)
+                float slopeX = im[0][x];
+                float slopeZ = re[1][x];
+                float nx = slopeZ * jxz - jzz * slopeX;
+                float ny = jzz * jxx - jxz * jxz;
+                float nz = jxz * slopeX - jxx * slopeZ;
+                float inv = 1.0f / sqrtf(nx * nx + ny * ny + nz * nz);
+
+                displacement[x] = glm::vec4(lambda * im[1][x], re[0][x], lambda * re[2][x], jacobian);
+                normal[x] = glm::vec4(nx * inv, ny * inv, nz * inv, 0.0f);
+            }
+        }
+    });
+}
+
+glm::vec3 CpuOcean::SampleDisplacement(float x, float z) const
+{
+    const uint32_t n = mSettings.size;
+    glm::vec3 sum(0.0f);
+    for (uint32_t cascade = 0; cascade < mSettings.cascadeCount; cascade++)
+    {
+        // linear filtering puts texel i's center at (i + 0.5) / n, repeat wraps the neighbours
+        float u = x / mSettings.patchSize[cascade] * n - 0.5f;
+        float v = z / mSettings.patchSize[cascade] * n - 0.5f;
+        float fu = floorf(u);
+        float fv = floorf(v);
+        float tu = u - fu;
+        float tv = v - fv;
+        uint32_t x0 = static_cast<uint32_t>(static_cast<int64_t>(fu) & (n - 1));
+        uint32_t z0 = static_cast<uint32_t>(static_cast<int64_t>(fv) & (n - 1));
+        uint32_t x1 = (x0 + 1) & (n - 1);
+        uint32_t z1 = (z0 + 1) & (n - 1);
+
+        const glm::vec4 *map = GetDisplacements(cascade);
+        glm::vec3 a = glm::vec3(map[z0 * n + x0]) * (1.0f - tu) + glm::vec3(map[z0 * n + x1]) * tu;
+        glm::vec3 b = glm::vec3(map[z1 * n + x0]) * (1.0f - tu) + glm::vec3(map[z1 * n + x1]) * tu;
+        sum = sum + a * (1.0f - tv) + b * tv;
+    }
+    return sum;
+}
+
+SimdIsa CpuOcean::GetIsa()
+{
+    return Kernels().isa;
+}
+
+const char *CpuOcean::GetIsaName()
+{
+    return GetSimdIsaName(GetIsa());
+}
+
+SimdIsa CpuOcean::LimitIsa(SimdIsa isa)
+{
+    return sDispatch.Limit(isa);
+}
@@ -0,0 +1,94 @@
+#ifndef VULKAN_CORE_CPU_OCEAN_H
+#define VULKAN_CORE_CPU_OCEAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "OceanSpectrum.hpp"
+#include "glm/glm.hpp"
+
+// Spectral ocean on the cpu, for headless validation and server side physics. It produces the
+// maps GpuOcean renders into its images, from the same initial amplitudes and in the same steps,
+// so the two agree to float rounding; the gpu evaluates its phases in float and stores half
+// floats, so its maps are the less precise of the two.
+//
+// Every field is a pair of real planes (real, imaginary parts) of size x size floats, and each
+// complex transform carries two real fields. The 2D inverse FFT runs as two passes of strips of
+// StripWidth columns transformed together, one per SIMD lane, with blocked transposes between
+// them so both passes read whole cache lines. Passes are spread over the TaskPool.
+class CpuOcean
+{
+  public:
+    // instruction set of the FFT stages, picked at first use; every one gives the same results as
+    // Scalar bit for bit
+    static SimdIsa GetIsa();
+    static const char *GetIsaName();
+    // see SimdDispatch::Limit
+    static SimdIsa LimitIsa(SimdIsa isa);
+
+    explicit CpuOcean(const OceanSettings &settings);
+
+    CpuOcean(const CpuOcean &) = delete;
+    CpuOcean &operator=(const CpuOcean &) = delete;
+
+    const OceanSettings &GetSettings() const
+    {
+        return mSettings;
+    }
+    void SetChoppiness(float choppiness);
+
+    // the surface at seconds, like GpuOcean::Update
+    void Update(double seconds);
+
+    // size * size texels of one cascade, laid out and encoded like the layers of GpuOcean's maps
+    const glm::vec4 *GetDisplacements(uint32_t cascade) const
+    {
+        return mDisplacement.data() + static_cast<size_t>(cascade) * mSettings.size * mSettings.size;
+    }
+    const glm::vec4 *GetNormals(uint32_t cascade) const
+    {
+        return mNormal.data() + static_cast<size_t>(cascade) * mSettings.size * mSettings.size;
+    }
+
+    // displacement at world (x, z) summed over the cascades, as a shader sampling the maps at
+    // xz / patchSize with GpuOcean's sampler would see it
+    glm::vec3 SampleDisplacement(float x, float z) const;
+
+    // columns per strip, a multiple of every lane width
+    static const uint32_t StripWidth = 16;
+
+  private:
+    size_t plane(uint32_t cascade, uint32_t field) const
+    {
+        return (static_cast<size_t>(cascade) * OceanFieldCount + field) * mSettings.size * mSettings.size;
+    }
+
+    void advanceSpectrum(float time);
+    // inverse FFT along the columns of every plane
+    void transformColumns();
+    void transpose();
+    void resolve();
+
+    OceanSettings mSettings;
+    uint32_t mLogSize;
+    size_t mPlaneCount;
+    std::vector<OceanSpectrumTexel> mSpectrum;
+    // angular frequency of every texel in multiples of 2 pi / loopPeriod, and e^(i m 2 pi t /
+    // loopPeriod) for every multiple m at the current time; empty when the table would not be
+    // much smaller than the spectrum
+    std::vector<uint32_t> mFrequency;
+    std::vector<float> mRotation;
+    // w, w^2, w^3 per radix 4 stage, see FftKernels
+    std::vector<float> mTwiddles;
+    std::vector<size_t> mStageTwiddles;
+
+    // [cascade][field] planes
+    std::vector<float> mRe;
+    std::vector<float> mIm;
+    std::vector<glm::vec4> mDisplacement;
+    std::vector<glm::vec4> mNormal;
+};
+
+#endif // VULKAN_CORE_CPU_OCEAN_H
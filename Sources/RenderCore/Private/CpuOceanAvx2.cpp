@@ -0,0 +1,23 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx2FftLanes
+
+#include "FftKernels.hpp"
+
+#if defined(__AVX2__)
+
+const FftKernels *GetAvx2FftKernels()
+{
+    static const FftKernels kernels =
+        Avx2FftLanes::MakeFftKernels<Avx2FftLanes::Avx2Lanes>(SimdIsa::Avx2);
+    return &kernels;
+}
+
+#else
+
+const FftKernels *GetAvx2FftKernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,23 @@
+// Built with AVX-512F enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx512FftLanes
+
+#include "FftKernels.hpp"
+
+#if defined(__AVX512F__)
+
+const FftKernels *GetAvx512FftKernels()
+{
+    static const FftKernels kernels =
+        Avx512FftLanes::MakeFftKernels<Avx512FftLanes::Avx512Lanes>(SimdIsa::Avx512);
+    return &kernels;
+}
+
+#else
+
+const FftKernels *GetAvx512FftKernels()
+{
+    return nullptr;
+}
+
+#endif
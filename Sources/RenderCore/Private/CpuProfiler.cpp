@@ -0,0 +1,240 @@
+#include "CpuProfiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+
+CpuProfiler::Scope::Scope(const char *name) : mName(name), mBeginNs(0)
+{
+    CpuProfiler &profiler = CpuProfiler::Instance();
+    if (profiler.IsEnabled())
+    {
+        profiler.threadBuffer().depth++;
+        mBeginNs = NowNs();
+    }
+}
+
+CpuProfiler::Scope::~Scope()
+{
+    if (mBeginNs != 0)
+    {
+        CpuProfiler::Instance().record(mName, mBeginNs, NowNs());
+    }
+}
+
+CpuProfiler &CpuProfiler::Instance()
+{
+    // never destroyed, threads joined by other static destructors still hand their buffers back
+    static CpuProfiler *instance = new CpuProfiler();
+    return *instance;
+}
+
+CpuProfiler::CpuProfiler() : mEnabled(true), mNextTid(1)
+{
+}
+
+uint64_t CpuProfiler::NowNs()
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+CpuProfiler::ThreadOwner::~ThreadOwner()
+{
+    if (buffer)
+    {
+        CpuProfiler::Instance().releaseBuffer(buffer);
+    }
+}
+
+CpuProfiler::ThreadBuffer &CpuProfiler::threadBuffer()
+{
+    thread_local ThreadOwner owner;
+    if (!owner.buffer)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        owner.buffer = acquireBuffer();
+    }
+    return *owner.buffer;
+}
+
+// zones of an exited thread that no trace or Clear has taken yet
+static bool HasPendingZones(uint64_t written, uint64_t cleared, uint64_t exported)
+{
+    return written > std::max(cleared, exported);
+}
+
+std::shared_ptr<CpuProfiler::ThreadBuffer> CpuProfiler::acquireBuffer()
+{
+    reclaimBuffers();
+
+    std::shared_ptr<ThreadBuffer> buffer;
+    if (!mSpare.empty())
+    {
+        buffer = std::move(mSpare.back());
+        mSpare.pop_back();
+    }
+    else
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.reset(new ZoneEvent[EventsPerThread]);
+    }
+
+    // tids are never reused, so the zones of a recycled buffer's old thread stay apart in traces
+    buffer->tid = mNextTid++;
+    buffer->name = "thread " + std::to_string(buffer->tid);
+    buffer->depth = 0;
+    buffer->started.store(0, std::memory_order_relaxed);
+    buffer->written.store(0, std::memory_order_relaxed);
+    buffer->cleared.store(0, std::memory_order_relaxed);
+    buffer->exported.store(0, std::memory_order_relaxed);
+    buffer->exited = false;
+    mBuffers.push_back(buffer);
+    return buffer;
+}
+
+void CpuProfiler::releaseBuffer(const std::shared_ptr<ThreadBuffer> &buffer)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    buffer->exited = true;
+    reclaimBuffers();
+}
+
+void CpuProfiler::reclaimBuffers()
+{
+    size_t exited = 0;
+    for (auto &buffer : mBuffers)
+    {
+        exited += buffer->exited ? 1 : 0;
+    }
+
+    // mBuffers is in creation order, so the oldest exited buffers are dropped first
+    size_t kept = 0;
+    for (size_t i = 0; i < mBuffers.size(); i++)
+    {
+        ThreadBuffer &buffer = *mBuffers[i];
+        bool pending = HasPendingZones(buffer.written.load(std::memory_order_relaxed),
+                                       buffer.cleared.load(std::memory_order_relaxed),
+                                       buffer.exported.load(std::memory_order_relaxed));
+        if (buffer.exited && (!pending || exited > MaxExitedBuffers))
+        {
+            exited--;
+            mSpare.push_back(std::move(mBuffers[i]));
+        }
+        else
+        {
+            mBuffers[kept++] = std::move(mBuffers[i]);
+        }
+    }
+    mBuffers.resize(kept);
+}
+
+void CpuProfiler::record(const char *name, uint64_t beginNs, uint64_t endNs)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    buffer.depth--;
+
+    // started is published before the event is touched, a dump that read the old event checks it
+    // afterwards
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.started.store(index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    ZoneEvent &event = buffer.events[index % EventsPerThread];
+    event.name.store(name, std::memory_order_relaxed);
+    event.beginNs.store(beginNs, std::memory_order_relaxed);
+    event.endNs.store(endNs, std::memory_order_relaxed);
+    event.depth.store(buffer.depth, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void CpuProfiler::SetThreadName(const char *name)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(mMutex);
+    buffer.name = name;
+}
+
+void CpuProfiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto &buffer : mBuffers)
+    {
+        buffer->cleared.store(buffer->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+    reclaimBuffers();
+}
+
+static void AppendEscaped(std::string &out, const char *s)
+{
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            out += '\\';
+        }
+        out += *s;
+    }
+}
+
+std::string CpuProfiler::ToChromeTrace() const
+{
+    std::string json = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+    bool first = true;
+    char buf[128];
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto &buffer : mBuffers)
+    {
+        json += first ? "\n" : ",\n";
+        first = false;
+        json += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " + std::to_string(buffer->tid) +
+                ", \"args\": {\"name\": \"";
+        AppendEscaped(json, buffer->name.c_str());
+        json += "\"}}";
+
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t begin = buffer->cleared.load(std::memory_order_relaxed);
+        if (written - begin > EventsPerThread)
+        {
+            begin = written - EventsPerThread;
+        }
+
+        for (uint64_t i = begin; i < written; i++)
+        {
+            const ZoneEvent &event = buffer->events[i % EventsPerThread];
+            const char *name = event.name.load(std::memory_order_relaxed);
+            uint64_t beginNs = event.beginNs.load(std::memory_order_relaxed);
+            uint64_t endNs = event.endNs.load(std::memory_order_relaxed);
+            // skip events the thread has lapped since written was read
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (buffer->started.load(std::memory_order_relaxed) > i + EventsPerThread)
+            {
+                continue;
+            }
+
+            json += ",\n{\"name\": \"";
+            AppendEscaped(json, name);
+            snprintf(buf, sizeof(buf), "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                     buffer->tid, static_cast<double>(beginNs) / 1000.0, static_cast<double>(endNs - beginNs) / 1000.0);
+            json += buf;
+        }
+        buffer->exported.store(written, std::memory_order_relaxed);
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::string &path) const
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::string json = ToChromeTrace();
+    bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+    fclose(file);
+    return ok;
+}
@@ -0,0 +1,128 @@
+#ifndef VULKAN_CORE_CPU_PROFILER_H
+#define VULKAN_CORE_CPU_PROFILER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Zone profiler for CPU work. Every thread writes completed zones into its own ring buffer
+// without locking; the buffers are only read when a trace is dumped. Zone names must be
+// string literals or otherwise outlive the profiler. Use the CPU_ZONE macros so that zones
+// vanish when RENDERCORE_PROFILER is not defined.
+//
+// The buffer of an exited thread is kept until a trace has exported its zones or Clear dropped
+// them, then handed to the next new thread. At most MaxExitedBuffers wait for that, beyond it
+// the oldest is reused anyway, so memory follows the number of live threads and not the number
+// ever created.
+class CpuProfiler
+{
+  public:
+    class Scope
+    {
+      public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        const char *mName;
+        uint64_t mBeginNs;
+    };
+
+    static CpuProfiler &Instance();
+
+    // std::chrono::steady_clock in nanoseconds, the same clock the gpu profiler calibrates to
+    static uint64_t NowNs();
+
+    void SetEnabled(bool enabled)
+    {
+        mEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IsEnabled() const
+    {
+        return mEnabled.load(std::memory_order_relaxed);
+    }
+
+    void SetThreadName(const char *name);
+
+    // drop everything recorded so far
+    void Clear();
+
+    // Chrome trace event json, also loadable by Perfetto. Zones overwritten while dumping are
+    // left out.
+    std::string ToChromeTrace() const;
+    bool WriteChromeTrace(const std::string &path) const;
+
+  private:
+    // atomics, so a dump may read an event while its thread overwrites it
+    struct ZoneEvent
+    {
+        std::atomic<const char *> name;
+        std::atomic<uint64_t> beginNs;
+        std::atomic<uint64_t> endNs;
+        std::atomic<uint32_t> depth;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t tid;
+        std::string name;
+        uint32_t depth;
+        std::unique_ptr<ZoneEvent[]> events;
+        // events the thread started to write and finished writing; event i is intact while
+        // started <= i + EventsPerThread
+        std::atomic<uint64_t> started;
+        std::atomic<uint64_t> written;
+        std::atomic<uint64_t> cleared;
+        // written when the last trace was made, exited is set once the thread is gone; both only
+        // change under mMutex
+        std::atomic<uint64_t> exported;
+        bool exited;
+    };
+
+    // hands the thread's buffer back when the thread exits
+    struct ThreadOwner
+    {
+        ~ThreadOwner();
+
+        std::shared_ptr<ThreadBuffer> buffer;
+    };
+
+    CpuProfiler();
+
+    ThreadBuffer &threadBuffer();
+    void record(const char *name, uint64_t beginNs, uint64_t endNs);
+    // caller holds mMutex
+    std::shared_ptr<ThreadBuffer> acquireBuffer();
+    void releaseBuffer(const std::shared_ptr<ThreadBuffer> &buffer);
+    void reclaimBuffers();
+
+    // events kept per thread before the oldest get overwritten
+    static const size_t EventsPerThread = 1 << 16;
+    // exited threads whose zones are kept for the next trace
+    static const size_t MaxExitedBuffers = 8;
+
+    std::atomic<bool> mEnabled;
+    mutable std::mutex mMutex;
+    uint32_t mNextTid;
+    std::vector<std::shared_ptr<ThreadBuffer>> mBuffers;
+    std::vector<std::shared_ptr<ThreadBuffer>> mSpare;
+};
+
+#ifdef RENDERCORE_PROFILER
+#define CPU_ZONE_CONCAT_INNER(a, b) a##b
+#define CPU_ZONE_CONCAT(a, b) CPU_ZONE_CONCAT_INNER(a, b)
+#define CPU_ZONE(name) CpuProfiler::Scope CPU_ZONE_CONCAT(cpuZone_, __LINE__)(name)
+#define CPU_THREAD_NAME(name) CpuProfiler::Instance().SetThreadName(name)
+#else
+#define CPU_ZONE(name)
+#define CPU_THREAD_NAME(name)
+#endif
+
+#endif // VULKAN_CORE_CPU_PROFILER_H
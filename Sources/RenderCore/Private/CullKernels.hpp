@@ -0,0 +1,142 @@
+#ifndef VULKAN_CORE_CULL_KERNELS_H
+#define VULKAN_CORE_CULL_KERNELS_H
+
+#include "FrustumCuller.hpp"
+#include "SimdLanes.hpp"
+
+// Kernel templates behind FrustumCuller, instantiated per ISA like TransformKernels. A kernel
+// culls [begin, end) and writes the visible indices to out, returning how many it wrote.
+
+struct CullKernels
+{
+    SimdIsa isa;
+    size_t (*spheres)(const Frustum &frustum, const SphereSoA &spheres, size_t begin, size_t end, uint32_t *out);
+    size_t (*aabbs)(const Frustum &frustum, const AabbSoA &boxes, size_t begin, size_t end, uint32_t *out);
+};
+
+// null when RenderCore was built without the matching translation unit
+const CullKernels *GetAvx2CullKernels();
+const CullKernels *GetAvx512CullKernels();
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+template <typename V> struct CullPlanes
+{
+    typename V::Type x[6], y[6], z[6], w[6];
+    // absolute normals, the projected half extent of a box is dot(|n|, extent)
+    typename V::Type absX[6], absY[6], absZ[6];
+
+    explicit CullPlanes(const Frustum &frustum)
+    {
+        for (int p = 0; p < 6; p++)
+        {
+            const glm::vec4 &plane = frustum.planes[p];
+            x[p] = V::Set1(plane.x);
+            y[p] = V::Set1(plane.y);
+            z[p] = V::Set1(plane.z);
+            w[p] = V::Set1(plane.w);
+            absX[p] = V::Set1(plane.x < 0.0f ? -plane.x : plane.x);
+            absY[p] = V::Set1(plane.y < 0.0f ? -plane.y : plane.y);
+            absZ[p] = V::Set1(plane.z < 0.0f ? -plane.z : plane.z);
+        }
+    }
+};
+
+// branch free append of the lanes set in visible
+inline size_t EmitVisible(uint32_t visible, size_t width, size_t first, uint32_t *out, size_t written)
+{
+    for (size_t lane = 0; lane < width; lane++)
+    {
+        out[written] = static_cast<uint32_t>(first + lane);
+        written += (visible >> lane) & 1;
+    }
+    return written;
+}
+
+template <typename V> uint32_t SphereBlock(const CullPlanes<V> &planes, const SphereSoA &s, size_t i)
+{
+    typedef typename V::Type T;
+    T x = V::Load(s.x + i);
+    T y = V::Load(s.y + i);
+    T z = V::Load(s.z + i);
+    T negRadius = V::Sub(V::Set1(0.0f), V::Load(s.radius + i));
+
+    T outside = V::Set1(0.0f);
+    for (int p = 0; p < 6; p++)
+    {
+        T distance = V::MulAdd(planes.x[p], x, V::MulAdd(planes.y[p], y, V::MulAdd(planes.z[p], z, planes.w[p])));
+        outside = V::OrMask(outside, V::Less(distance, negRadius));
+    }
+    return ~V::MoveMask(outside) & ((1u << V::Width) - 1);
+}
+
+template <typename V> uint32_t AabbBlock(const CullPlanes<V> &planes, const AabbSoA &b, size_t i)
+{
+    typedef typename V::Type T;
+    T x = V::Load(b.centerX + i);
+    T y = V::Load(b.centerY + i);
+    T z = V::Load(b.centerZ + i);
+    T ex = V::Load(b.extentX + i);
+    T ey = V::Load(b.extentY + i);
+    T ez = V::Load(b.extentZ + i);
+    T zero = V::Set1(0.0f);
+
+    T outside = zero;
+    for (int p = 0; p < 6; p++)
+    {
+        T distance = V::MulAdd(planes.x[p], x, V::MulAdd(planes.y[p], y, V::MulAdd(planes.z[p], z, planes.w[p])));
+        T radius = V::MulAdd(planes.absX[p], ex, V::MulAdd(planes.absY[p], ey, V::Mul(planes.absZ[p], ez)));
+        outside = V::OrMask(outside, V::Less(distance, V::Sub(zero, radius)));
+    }
+    return ~V::MoveMask(outside) & ((1u << V::Width) - 1);
+}
+
+template <typename V>
+size_t CullSpheresKernel(const Frustum &frustum, const SphereSoA &spheres, size_t begin, size_t end, uint32_t *out)
+{
+    CullPlanes<V> wide(frustum);
+    CullPlanes<ScalarLanes> narrow(frustum);
+    size_t written = 0;
+    size_t i = begin;
+    for (; i + V::Width <= end; i += V::Width)
+    {
+        written = EmitVisible(SphereBlock<V>(wide, spheres, i), V::Width, i, out, written);
+    }
+    for (; i < end; i++)
+    {
+        written = EmitVisible(SphereBlock<ScalarLanes>(narrow, spheres, i), 1, i, out, written);
+    }
+    return written;
+}
+
+template <typename V>
+size_t CullAabbsKernel(const Frustum &frustum, const AabbSoA &boxes, size_t begin, size_t end, uint32_t *out)
+{
+    CullPlanes<V> wide(frustum);
+    CullPlanes<ScalarLanes> narrow(frustum);
+    size_t written = 0;
+    size_t i = begin;
+    for (; i + V::Width <= end; i += V::Width)
+    {
+        written = EmitVisible(AabbBlock<V>(wide, boxes, i), V::Width, i, out, written);
+    }
+    for (; i < end; i++)
+    {
+        written = EmitVisible(AabbBlock<ScalarLanes>(narrow, boxes, i), 1, i, out, written);
+    }
+    return written;
+}
+
+template <typename V> CullKernels MakeCullKernels(SimdIsa isa)
+{
+    CullKernels kernels;
+    kernels.isa = isa;
+    kernels.spheres = CullSpheresKernel<V>;
+    kernels.aabbs = CullAabbsKernel<V>;
+    return kernels;
+}
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_CULL_KERNELS_H
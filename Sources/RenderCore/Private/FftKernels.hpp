@@ -0,0 +1,120 @@
+#ifndef VULKAN_CORE_FFT_KERNELS_H
+#define VULKAN_CORE_FFT_KERNELS_H
+
+#include <assert.h>
+
+#include "CpuOcean.hpp"
+#include "SimdLanes.hpp"
+
+// Inverse FFT stages behind CpuOcean, instantiated per ISA like WaterKernels. A strip is a block
+// of width independent transforms stored row by row, real and imaginary parts in separate
+// arrays, so every lane works on its own transform and twiddles are broadcast. The stages are
+// those of OceanFft.comp: Stockham autosort, radix 4 with a leading radix 2 stage for odd
+// log2(n). No MulAdd, so every ISA gives the scalar results bit for bit.
+
+struct FftStrip
+{
+    float *re;
+    float *im;
+};
+
+struct FftKernels
+{
+    SimdIsa isa;
+    // span 1 radix 2 stage of n points
+    void (*radix2)(const FftStrip &in, const FftStrip &out, size_t n, size_t width);
+    // radix 4 stage of n points combining transforms of span points; twiddles holds w, w^2 and
+    // w^3 as (re, im) pairs for every k below span
+    void (*radix4)(const FftStrip &in, const FftStrip &out, size_t n, size_t span, size_t width,
+                   const float *twiddles);
+};
+
+// null when RenderCore was built without the matching translation unit
+const FftKernels *GetAvx2FftKernels();
+const FftKernels *GetAvx512FftKernels();
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+template <typename V> void Radix2Kernel(const FftStrip &in, const FftStrip &out, size_t n, size_t width)
+{
+    assert(width % V::Width == 0);
+    for (size_t j = 0; j < n / 2; j++)
+    {
+        const size_t a = j * width;
+        const size_t b = (j + n / 2) * width;
+        const size_t o = 2 * j * width;
+        for (size_t c = 0; c < width; c += V::Width)
+        {
+            typename V::Type ar = V::Load(in.re + a + c), ai = V::Load(in.im + a + c);
+            typename V::Type br = V::Load(in.re + b + c), bi = V::Load(in.im + b + c);
+            V::Store(out.re + o + c, V::Add(ar, br));
+            V::Store(out.im + o + c, V::Add(ai, bi));
+            V::Store(out.re + o + width + c, V::Sub(ar, br));
+            V::Store(out.im + o + width + c, V::Sub(ai, bi));
+        }
+    }
+}
+
+template <typename V>
+void Radix4Kernel(const FftStrip &in, const FftStrip &out, size_t n, size_t span, size_t width, const float *twiddles)
+{
+    typedef typename V::Type T;
+    assert(width % V::Width == 0);
+    const size_t quarter = n / 4;
+    for (size_t j = 0; j < quarter; j++)
+    {
+        const size_t k = j % span;
+        const float *w = twiddles + k * 6;
+        const T w1r = V::Set1(w[0]), w1i = V::Set1(w[1]);
+        const T w2r = V::Set1(w[2]), w2i = V::Set1(w[3]);
+        const T w3r = V::Set1(w[4]), w3i = V::Set1(w[5]);
+        const size_t r0 = j * width;
+        const size_t r1 = (j + quarter) * width;
+        const size_t r2 = (j + 2 * quarter) * width;
+        const size_t r3 = (j + 3 * quarter) * width;
+        const size_t o0 = ((j - k) * 4 + k) * width;
+        const size_t o1 = o0 + span * width;
+        const size_t o2 = o1 + span * width;
+        const size_t o3 = o2 + span * width;
+        for (size_t c = 0; c < width; c += V::Width)
+        {
+            T v0r = V::Load(in.re + r0 + c), v0i = V::Load(in.im + r0 + c);
+            T xr = V::Load(in.re + r1 + c), xi = V::Load(in.im + r1 + c);
+            T v1r = V::Sub(V::Mul(xr, w1r), V::Mul(xi, w1i)), v1i = V::Add(V::Mul(xr, w1i), V::Mul(xi, w1r));
+            xr = V::Load(in.re + r2 + c);
+            xi = V::Load(in.im + r2 + c);
+            T v2r = V::Sub(V::Mul(xr, w2r), V::Mul(xi, w2i)), v2i = V::Add(V::Mul(xr, w2i), V::Mul(xi, w2r));
+            xr = V::Load(in.re + r3 + c);
+            xi = V::Load(in.im + r3 + c);
+            T v3r = V::Sub(V::Mul(xr, w3r), V::Mul(xi, w3i)), v3i = V::Add(V::Mul(xr, w3i), V::Mul(xi, w3r));
+
+            // inverse radix 4 butterfly, w = i
+            T a0r = V::Add(v0r, v2r), a0i = V::Add(v0i, v2i);
+            T a1r = V::Sub(v0r, v2r), a1i = V::Sub(v0i, v2i);
+            T a2r = V::Add(v1r, v3r), a2i = V::Add(v1i, v3i);
+            T a3r = V::Sub(v3i, v1i), a3i = V::Sub(v1r, v3r);
+            V::Store(out.re + o0 + c, V::Add(a0r, a2r));
+            V::Store(out.im + o0 + c, V::Add(a0i, a2i));
+            V::Store(out.re + o1 + c, V::Add(a1r, a3r));
+            V::Store(out.im + o1 + c, V::Add(a1i, a3i));
+            V::Store(out.re + o2 + c, V::Sub(a0r, a2r));
+            V::Store(out.im + o2 + c, V::Sub(a0i, a2i));
+            V::Store(out.re + o3 + c, V::Sub(a1r, a3r));
+            V::Store(out.im + o3 + c, V::Sub(a1i, a3i));
+        }
+    }
+}
+
+template <typename V> FftKernels MakeFftKernels(SimdIsa isa)
+{
+    FftKernels kernels;
+    kernels.isa = isa;
+    kernels.radix2 = Radix2Kernel<V>;
+    kernels.radix4 = Radix4Kernel<V>;
+    return kernels;
+}
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_FFT_KERNELS_H
@@ -0,0 +1,137 @@
+#include "FlightRecorder.hpp"
+
+#include <chrono>
+#include <inttypes.h>
+#include <stdio.h>
+
+static const char *GetFlightEventTypeString(FlightEventType type)
+{
+#define CASE(c)                                                                                                        \
+    case FlightEventType::c:                                                                                           \
+        return #c;
+
+    switch (type)
+    {
+        CASE(FrameBegin)
+        CASE(Allocation)
+        CASE(Free)
+        CASE(PipelineCreate)
+        CASE(ResourceCreate)
+        CASE(DeviceLost)
+        CASE(Marker)
+    default:
+        return "Unknown";
+    }
+
+#undef CASE
+}
+
+static uint16_t CurrentThreadIndex()
+{
+    static std::atomic<uint16_t> nextThread(0);
+    thread_local uint16_t thread = nextThread.fetch_add(1);
+    return thread;
+}
+
+FlightRecorder &FlightRecorder::Instance()
+{
+    static FlightRecorder instance;
+    return instance;
+}
+
+FlightRecorder::FlightRecorder() : mHead(0), mSlots(Capacity), mDumpPath("flight_recorder.log")
+{
+    for (auto &slot : mSlots)
+    {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+void FlightRecorder::Record(FlightEventType type, uint32_t arg0, uint64_t arg1, uint64_t arg2)
+{
+    uint64_t index = mHead.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = mSlots[index & (Capacity - 1)];
+
+    uint64_t timeNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+    uint64_t header = static_cast<uint64_t>(type) | (static_cast<uint64_t>(CurrentThreadIndex()) << 16) |
+                      (static_cast<uint64_t>(arg0) << 32);
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timeNs.store(timeNs, std::memory_order_relaxed);
+    slot.header.store(header, std::memory_order_relaxed);
+    slot.arg1.store(arg1, std::memory_order_relaxed);
+    slot.arg2.store(arg2, std::memory_order_relaxed);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+std::vector<FlightEvent> FlightRecorder::Snapshot() const
+{
+    uint64_t head = mHead.load(std::memory_order_acquire);
+    uint64_t begin = head > Capacity ? head - Capacity : 0;
+
+    std::vector<FlightEvent> events;
+    events.reserve(static_cast<size_t>(head - begin));
+    for (uint64_t index = begin; index < head; index++)
+    {
+        const Slot &slot = mSlots[index & (Capacity - 1)];
+
+        // skip slots that are mid-write or were already reused for a newer event
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != 2 * (index + 1))
+        {
+            continue;
+        }
+
+        FlightEvent event;
+        event.timeNs = slot.timeNs.load(std::memory_order_relaxed);
+        uint64_t header = slot.header.load(std::memory_order_relaxed);
+        event.arg1 = slot.arg1.load(std::memory_order_relaxed);
+        event.arg2 = slot.arg2.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+        {
+            continue;
+        }
+
+        event.type = static_cast<FlightEventType>(header & 0xffff);
+        event.thread = static_cast<uint16_t>((header >> 16) & 0xffff);
+        event.arg0 = static_cast<uint32_t>(header >> 32);
+        events.push_back(event);
+    }
+    return events;
+}
+
+void FlightRecorder::SetDumpPath(const std::string &path)
+{
+    mDumpPath = path;
+}
+
+bool FlightRecorder::Dump() const
+{
+    return Dump(mDumpPath);
+}
+
+bool FlightRecorder::Dump(const std::string &path) const
+{
+    std::vector<FlightEvent> events = Snapshot();
+
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    uint64_t lastNs = events.empty() ? 0 : events.back().timeNs;
+    fprintf(file, "# %zu events, time relative to the last one in ms\n", events.size());
+    for (auto &event : events)
+    {
+        fprintf(file, "%12.3f thread %2u %-14s %10u 0x%016" PRIx64 " %12" PRIu64 "\n",
+                -static_cast<double>(lastNs - event.timeNs) / 1e6, event.thread, GetFlightEventTypeString(event.type),
+                event.arg0, event.arg1, event.arg2);
+    }
+    fclose(file);
+    return true;
+}
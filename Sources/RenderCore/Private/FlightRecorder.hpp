@@ -0,0 +1,73 @@
+#ifndef VULKAN_CORE_FLIGHT_RECORDER_H
+#define VULKAN_CORE_FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum class FlightEventType : uint16_t
+{
+    FrameBegin,
+    Allocation,
+    Free,
+    PipelineCreate,
+    ResourceCreate,
+    DeviceLost,
+    Marker,
+};
+
+struct FlightEvent
+{
+    uint64_t timeNs;
+    FlightEventType type;
+    uint16_t thread;
+    uint32_t arg0;
+    uint64_t arg1;
+    uint64_t arg2;
+};
+
+// Always-on ring of the most recent render events. Recording is lock free and costs a few
+// atomic stores, nothing is formatted or written until Dump is called. PANIC dumps it
+// automatically, so the last events before a crash or device loss end up on disk.
+//
+// Allocation events carry (memory type index, VkDeviceMemory, size) and Free events (0,
+// VkDeviceMemory, size), so every free pairs with its allocation by handle and the memory still
+// live at a dump is the allocations without a later free.
+class FlightRecorder
+{
+  public:
+    static FlightRecorder &Instance();
+
+    void Record(FlightEventType type, uint32_t arg0 = 0, uint64_t arg1 = 0, uint64_t arg2 = 0);
+
+    // events still in the ring, oldest first
+    std::vector<FlightEvent> Snapshot() const;
+
+    void SetDumpPath(const std::string &path);
+    bool Dump() const;
+    bool Dump(const std::string &path) const;
+
+  private:
+    // a slot's sequence is odd while it is written and 2 * (index + 1) once it holds event index
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> timeNs;
+        std::atomic<uint64_t> header;
+        std::atomic<uint64_t> arg1;
+        std::atomic<uint64_t> arg2;
+    };
+
+    FlightRecorder();
+
+    static const uint64_t Capacity = 1 << 14;
+
+    std::atomic<uint64_t> mHead;
+    std::vector<Slot> mSlots;
+    std::string mDumpPath;
+};
+
+#define FLIGHT_RECORD(...) FlightRecorder::Instance().Record(__VA_ARGS__)
+
+#endif // VULKAN_CORE_FLIGHT_RECORDER_H
@@ -0,0 +1,105 @@
+#include "FrustumCuller.hpp"
+
+#include <string.h>
+
+#include "CpuProfiler.hpp"
+#include "CullKernels.hpp"
+#include "SimdDispatch.hpp"
+#include "TaskPool.hpp"
+
+using namespace RENDERCORE_LANES_NAMESPACE;
+
+// objects per task, a multiple of every lane width
+static const size_t CullGrain = 4096;
+
+static SimdDispatch<CullKernels> sDispatch(MakeCullKernels<ScalarLanes>, MakeCullKernels<DefaultLanes>,
+                                           GetAvx2CullKernels, GetAvx512CullKernels);
+
+static const CullKernels &Kernels()
+{
+    return sDispatch.Get();
+}
+
+// Every task writes its indices at its own offset into visible, the chunks are packed
+// together afterwards so the list stays in ascending order.
+template <typename Kernel> static size_t CullParallel(size_t count, std::vector<uint32_t> &visible, Kernel kernel)
+{
+    visible.resize(count);
+    size_t chunkCount = (count + CullGrain - 1) / CullGrain;
+    std::vector<size_t> written(chunkCount);
+
+    TaskPool::Instance().ParallelFor(count, CullGrain, [&](size_t begin, size_t end) {
+        written[begin / CullGrain] = kernel(begin, end, visible.data() + begin);
+    });
+
+    size_t total = 0;
+    for (size_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        if (total != chunk * CullGrain)
+        {
+            memmove(visible.data() + total, visible.data() + chunk * CullGrain, written[chunk] * sizeof(uint32_t));
+        }
+        total += written[chunk];
+    }
+    visible.resize(total);
+    return total;
+}
+
+Frustum Frustum::FromViewProjection(const glm::mat4 &viewProjection)
+{
+    glm::vec4 rows[4];
+    for (int row = 0; row < 4; row++)
+    {
+        rows[row] = glm::vec4(viewProjection[0][row], viewProjection[1][row], viewProjection[2][row],
+                              viewProjection[3][row]);
+    }
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    // clip space depth starts at 0, not -w
+    frustum.planes[4] = rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+    for (auto &plane : frustum.planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return frustum;
+}
+
+SimdIsa FrustumCuller::GetIsa()
+{
+    return Kernels().isa;
+}
+
+const char *FrustumCuller::GetIsaName()
+{
+    return GetSimdIsaName(GetIsa());
+}
+
+SimdIsa FrustumCuller::LimitIsa(SimdIsa isa)
+{
+    return sDispatch.Limit(isa);
+}
+
+size_t FrustumCuller::CullSpheres(const Frustum &frustum, const SphereSoA &spheres, size_t count,
+                                  std::vector<uint32_t> &visible)
+{
+    CPU_ZONE("FrustumCuller::CullSpheres");
+    auto kernel = Kernels().spheres;
+    return CullParallel(count, visible, [&](size_t begin, size_t end, uint32_t *out) {
+        return kernel(frustum, spheres, begin, end, out);
+    });
+}
+
+size_t FrustumCuller::CullAabbs(const Frustum &frustum, const AabbSoA &boxes, size_t count,
+                                std::vector<uint32_t> &visible)
+{
+    CPU_ZONE("FrustumCuller::CullAabbs");
+    auto kernel = Kernels().aabbs;
+    return CullParallel(count, visible, [&](size_t begin, size_t end, uint32_t *out) {
+        return kernel(frustum, boxes, begin, end, out);
+    });
+}
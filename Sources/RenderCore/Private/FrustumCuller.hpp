@@ -0,0 +1,58 @@
+#ifndef VULKAN_CORE_FRUSTUM_CULLER_H
+#define VULKAN_CORE_FRUSTUM_CULLER_H
+
+#include "CpuFeatures.hpp"
+#include "glm/glm.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Six normalized planes (xyz normal, w distance) with the normals pointing inside, in the order
+// left, right, bottom, top, near, far.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    // planes of a Vulkan view projection, depth in [0, 1] as produced by Camera with its clip matrix
+    static Frustum FromViewProjection(const glm::mat4 &viewProjection);
+};
+
+struct SphereSoA
+{
+    const float *x;
+    const float *y;
+    const float *z;
+    const float *radius;
+};
+
+// center and half extent per axis
+struct AabbSoA
+{
+    const float *centerX;
+    const float *centerY;
+    const float *centerZ;
+    const float *extentX;
+    const float *extentY;
+    const float *extentZ;
+};
+
+// Tests bounding volumes against a frustum a full SIMD register of objects at a time (16 with
+// AVX-512, 8 with AVX2, 4 with SSE2 or NEON) and spreads large batches over the TaskPool. The result is the
+// ascending list of indices that intersect the frustum, ready for draw submission.
+class FrustumCuller
+{
+  public:
+    static SimdIsa GetIsa();
+    static const char *GetIsaName();
+    // see SimdDispatch::Limit
+    static SimdIsa LimitIsa(SimdIsa isa);
+
+    // returns the number of visible objects, visible is resized to it
+    static size_t CullSpheres(const Frustum &frustum, const SphereSoA &spheres, size_t count,
+                              std::vector<uint32_t> &visible);
+    static size_t CullAabbs(const Frustum &frustum, const AabbSoA &boxes, size_t count,
+                            std::vector<uint32_t> &visible);
+};
+
+#endif // VULKAN_CORE_FRUSTUM_CULLER_H
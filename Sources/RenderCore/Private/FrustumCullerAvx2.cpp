@@ -0,0 +1,22 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx2CullLanes
+
+#include "CullKernels.hpp"
+
+#if defined(__AVX2__)
+
+const CullKernels *GetAvx2CullKernels()
+{
+    static const CullKernels kernels = Avx2CullLanes::MakeCullKernels<Avx2CullLanes::Avx2Lanes>(SimdIsa::Avx2);
+    return &kernels;
+}
+
+#else
+
+const CullKernels *GetAvx2CullKernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,23 @@
+// Built with AVX-512F enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx512CullLanes
+
+#include "CullKernels.hpp"
+
+#if defined(__AVX512F__)
+
+const CullKernels *GetAvx512CullKernels()
+{
+    static const CullKernels kernels =
+        Avx512CullLanes::MakeCullKernels<Avx512CullLanes::Avx512Lanes>(SimdIsa::Avx512);
+    return &kernels;
+}
+
+#else
+
+const CullKernels *GetAvx512CullKernels()
+{
+    return nullptr;
+}
+
+#endif
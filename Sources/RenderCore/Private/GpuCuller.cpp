@@ -0,0 +1,278 @@
+#include "GpuCuller.hpp"
+
+#include <assert.h>
+#include <string.h>
+
+#include "HostAllocator.hpp"
+#include "Log.hpp"
+#include "Utils.hpp"
+
+#ifdef RENDERCORE_SHADERS
+static const uint32_t GpuCullSpirv[] = {
+#include "GpuCull.comp.inc"
+};
+#endif
+
+// must match local_size_x of GpuCull.comp
+static const uint32_t GroupSize = 64;
+// minimum maxComputeWorkGroupCount[0] every device supports
+static const uint32_t MaxGroups = 65535;
+
+GpuCuller::GpuCuller()
+    : mEnabled(false), mDevice(VK_NULL_HANDLE), mLimits(), mInstanceCount(0), mDrawIndexedIndirectCount(nullptr),
+      mInstances(nullptr), mMeshes(nullptr), mDescLayout(VK_NULL_HANDLE), mDescPool(VK_NULL_HANDLE),
+      mDescSet(VK_NULL_HANDLE), mPipelineLayout(VK_NULL_HANDLE), mPipeline(VK_NULL_HANDLE)
+{
+    mInstanceBuffer.buf = VK_NULL_HANDLE;
+    mInstanceBuffer.mem = VK_NULL_HANDLE;
+    mMeshBuffer.buf = VK_NULL_HANDLE;
+    mMeshBuffer.mem = VK_NULL_HANDLE;
+    mCommandBuffer.buf = VK_NULL_HANDLE;
+    mCommandBuffer.mem = VK_NULL_HANDLE;
+    mCountBuffer.buf = VK_NULL_HANDLE;
+    mCountBuffer.mem = VK_NULL_HANDLE;
+}
+
+bool GpuCuller::Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                     const VkPhysicalDeviceFeatures &enabledFeatures, bool drawIndirectCount, const Limits &limits)
+{
+    RC_INFO("GpuCuller::Init");
+
+#ifndef RENDERCORE_SHADERS
+    RC_WARN("RenderCore was built without shaders, gpu culling disabled");
+    return false;
+#endif
+    if (!enabledFeatures.multiDrawIndirect || !enabledFeatures.drawIndirectFirstInstance)
+    {
+        RC_WARN("multiDrawIndirect or drawIndirectFirstInstance not enabled, gpu culling disabled");
+        return false;
+    }
+
+    mDevice = device;
+    mLimits = limits;
+    if (mLimits.maxInstances > MaxGroups * GroupSize)
+    {
+        RC_WARN("gpu culling is limited to {} instances", MaxGroups * GroupSize);
+        mLimits.maxInstances = MaxGroups * GroupSize;
+    }
+    if (drawIndirectCount)
+    {
+        mDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(mDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+    if (mDrawIndexedIndirectCount == nullptr)
+    {
+        RC_INFO("VK_KHR_draw_indirect_count not enabled, gpu culled buckets are drawn at full size");
+    }
+
+    // the cpu writes instances and meshes in place, device local host visible memory is preferred
+    const VkMemoryPropertyFlags hostVisible =
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    VkDeviceSize commandCount = static_cast<VkDeviceSize>(mLimits.bucketCount) * mLimits.maxDrawsPerBucket;
+    VkResult res = CreateBuffer(mDevice, memoryProperties, sizeof(GpuCullInstance) * mLimits.maxInstances,
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                mInstanceBuffer, reinterpret_cast<void **>(&mInstances));
+    PANIC_IF_NOT_SUCCESS(res);
+    res = CreateBuffer(mDevice, memoryProperties, sizeof(GpuCullMesh) * mLimits.maxMeshes,
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostVisible, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                       mMeshBuffer, reinterpret_cast<void **>(&mMeshes));
+    PANIC_IF_NOT_SUCCESS(res);
+    res = CreateBuffer(mDevice, memoryProperties, sizeof(VkDrawIndexedIndirectCommand) * commandCount,
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, mCommandBuffer);
+    PANIC_IF_NOT_SUCCESS(res);
+    res = CreateBuffer(mDevice, memoryProperties, sizeof(uint32_t) * mLimits.bucketCount,
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, mCountBuffer);
+    PANIC_IF_NOT_SUCCESS(res);
+    memset(mMeshes, 0, sizeof(GpuCullMesh) * mLimits.maxMeshes);
+
+    initDescriptors();
+    initPipeline();
+    mEnabled = true;
+    return true;
+}
+
+void GpuCuller::initDescriptors()
+{
+    VkDescriptorSetLayoutBinding layoutBindings[4];
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        layoutBindings[i].binding = i;
+        layoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        layoutBindings[i].descriptorCount = 1;
+        layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        layoutBindings[i].pImmutableSamplers = nullptr;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descSetLayoutInfo = {};
+    descSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descSetLayoutInfo.pNext = nullptr;
+    descSetLayoutInfo.flags = 0;
+    descSetLayoutInfo.bindingCount = 4;
+    descSetLayoutInfo.pBindings = layoutBindings;
+    VkResult res = vkCreateDescriptorSetLayout(mDevice, &descSetLayoutInfo,
+                                               VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &mDescLayout);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 4;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    res = vkCreateDescriptorPool(mDevice, &poolInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &mDescPool);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = mDescPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &mDescLayout;
+    res = vkAllocateDescriptorSets(mDevice, &allocInfo, &mDescSet);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    const VkDescriptorBufferInfo *bufferInfos[4] = {&mInstanceBuffer.bufferInfo, &mMeshBuffer.bufferInfo,
+                                                    &mCommandBuffer.bufferInfo, &mCountBuffer.bufferInfo};
+    VkWriteDescriptorSet writes[4];
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        writes[i] = {};
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].pNext = nullptr;
+        writes[i].dstSet = mDescSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writes[i].pBufferInfo = bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(mDevice, 4, writes, 0, nullptr);
+}
+
+void GpuCuller::initPipeline()
+{
+#ifdef RENDERCORE_SHADERS
+    VkPushConstantRange pushRange = {};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = nullptr;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushRange;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &mDescLayout;
+    VkResult res = vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo,
+                                          VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &mPipelineLayout);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    res = CreateComputePipeline(mDevice, GpuCullSpirv, sizeof(GpuCullSpirv), mPipelineLayout, &mPipeline);
+    PANIC_IF_NOT_SUCCESS(res);
+#endif
+}
+
+void GpuCuller::Destroy()
+{
+    if (mDevice == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroyPipeline(mDevice, mPipeline, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(mDevice, mPipelineLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    // destroying the pool frees the set
+    vkDestroyDescriptorPool(mDevice, mDescPool, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    vkDestroyDescriptorSetLayout(mDevice, mDescLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    DestroyBuffer(mDevice, mInstanceBuffer);
+    DestroyBuffer(mDevice, mMeshBuffer);
+    DestroyBuffer(mDevice, mCommandBuffer);
+    DestroyBuffer(mDevice, mCountBuffer);
+    mInstances = nullptr;
+    mMeshes = nullptr;
+    mEnabled = false;
+    mDevice = VK_NULL_HANDLE;
+}
+
+void GpuCuller::SetInstanceCount(uint32_t count)
+{
+    assert(count <= mLimits.maxInstances);
+    mInstanceCount = count;
+}
+
+void GpuCuller::Cull(VkCommandBuffer cmd, const Frustum &frustum, const glm::vec3 &eye, float lodScale)
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    // the previous frame's draws may still read the commands and counts being reset
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 0, nullptr);
+
+    vkCmdFillBuffer(cmd, mCountBuffer.buf, 0, VK_WHOLE_SIZE, 0);
+    if (!HasDrawCount())
+    {
+        vkCmdFillBuffer(cmd, mCommandBuffer.buf, 0, VK_WHOLE_SIZE, 0);
+    }
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+
+    if (mInstanceCount > 0)
+    {
+        PushConstants constants;
+        for (int i = 0; i < 6; i++)
+        {
+            constants.planes[i] = frustum.planes[i];
+        }
+        constants.eye = glm::vec4(eye, lodScale);
+        constants.instanceCount = mInstanceCount;
+        constants.maxDrawsPerBucket = mLimits.maxDrawsPerBucket;
+
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &mDescSet, 0, nullptr);
+        vkCmdPushConstants(cmd, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(cmd, (mInstanceCount + GroupSize - 1) / GroupSize, 1, 1);
+    }
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuCuller::Draw(VkCommandBuffer cmd, uint32_t bucket)
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+    assert(bucket < mLimits.bucketCount);
+
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize offset = static_cast<VkDeviceSize>(bucket) * mLimits.maxDrawsPerBucket * stride;
+    if (HasDrawCount())
+    {
+        mDrawIndexedIndirectCount(cmd, mCommandBuffer.buf, offset, mCountBuffer.buf, bucket * sizeof(uint32_t),
+                                  mLimits.maxDrawsPerBucket, stride);
+    }
+    else
+    {
+        vkCmdDrawIndexedIndirect(cmd, mCommandBuffer.buf, offset, mLimits.maxDrawsPerBucket, stride);
+    }
+}
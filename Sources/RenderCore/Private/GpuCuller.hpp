@@ -0,0 +1,132 @@
+#ifndef VULKAN_CORE_GPU_CULLER_H
+#define VULKAN_CORE_GPU_CULLER_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdint.h>
+
+#include "FrustumCuller.hpp"
+#include "Resources.hpp"
+#include "glm/glm.hpp"
+
+// std430 layouts shared with Shaders/GpuCull.comp
+
+struct GpuCullInstance
+{
+    // xyz world center, w radius
+    glm::vec4 sphere;
+    uint32_t mesh;
+    uint32_t pad[3];
+};
+
+// Up to four lods of one mesh in the shared index and vertex buffers. Lod i is drawn while the
+// distance from the camera to the sphere's surface is at most lodDistance[i]; beyond the last
+// one the instance is culled.
+struct GpuCullMesh
+{
+    // pipeline the mesh is drawn with, selects the region its draws are appended to
+    uint32_t bucket;
+    uint32_t lodCount;
+    uint32_t pad[2];
+    glm::vec4 lodDistance;
+    uint32_t indexCount[4];
+    uint32_t firstIndex[4];
+    int32_t vertexOffset[4];
+};
+
+static_assert(sizeof(GpuCullInstance) == 32, "GpuCullInstance must match Instance in GpuCull.comp");
+static_assert(sizeof(GpuCullMesh) == 80, "GpuCullMesh must match Mesh in GpuCull.comp");
+
+// GPU-driven culling. Instance bounds and meshes live in storage buffers; a compute pass tests
+// every instance against the frustum, picks its lod and appends a VkDrawIndexedIndirectCommand
+// to its bucket's region, so drawing a bucket is one vkCmdDrawIndexedIndirectCount whatever the
+// instance count. Each command draws one instance with firstInstance set to the instance's
+// index. Without VK_KHR_draw_indirect_count the regions are zeroed before culling and drawn
+// whole, unused commands have no instances.
+//
+// The buffers are single: edit instances and meshes only while no submitted frame still culls.
+class GpuCuller
+{
+  public:
+    struct Limits
+    {
+        uint32_t maxInstances;
+        uint32_t maxMeshes;
+        uint32_t bucketCount;
+        // at most VkPhysicalDeviceLimits::maxDrawIndirectCount
+        uint32_t maxDrawsPerBucket;
+    };
+
+    GpuCuller();
+
+    // false when the device lacks multiDrawIndirect or drawIndirectFirstInstance, or RenderCore
+    // was built without shaders; the culler then stays disabled
+    bool Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+              const VkPhysicalDeviceFeatures &enabledFeatures, bool drawIndirectCount, const Limits &limits);
+    void Destroy();
+
+    bool IsEnabled() const
+    {
+        return mEnabled;
+    }
+
+    bool HasDrawCount() const
+    {
+        return mDrawIndexedIndirectCount != nullptr;
+    }
+
+    // persistently mapped, maxInstances and maxMeshes entries
+    GpuCullInstance *GetInstances()
+    {
+        return mInstances;
+    }
+    GpuCullMesh *GetMeshes()
+    {
+        return mMeshes;
+    }
+    void SetInstanceCount(uint32_t count);
+
+    // storage buffer of the instance bounds, for vertex shaders indexing by gl_InstanceIndex
+    const BufferResource &GetInstanceBuffer() const
+    {
+        return mInstanceBuffer;
+    }
+
+    // outside a render pass: resets the counts, culls and makes the commands visible to indirect draws
+    void Cull(VkCommandBuffer cmd, const Frustum &frustum, const glm::vec3 &eye, float lodScale = 1.0f);
+    // inside the render pass, with the bucket's pipeline and the index and vertex buffers bound
+    void Draw(VkCommandBuffer cmd, uint32_t bucket);
+
+  private:
+    struct PushConstants
+    {
+        glm::vec4 planes[6];
+        glm::vec4 eye;
+        uint32_t instanceCount;
+        uint32_t maxDrawsPerBucket;
+    };
+
+    void initPipeline();
+    void initDescriptors();
+
+    bool mEnabled;
+    VkDevice mDevice;
+    Limits mLimits;
+    uint32_t mInstanceCount;
+    PFN_vkCmdDrawIndexedIndirectCountKHR mDrawIndexedIndirectCount;
+
+    BufferResource mInstanceBuffer;
+    BufferResource mMeshBuffer;
+    BufferResource mCommandBuffer;
+    BufferResource mCountBuffer;
+    GpuCullInstance *mInstances;
+    GpuCullMesh *mMeshes;
+
+    VkDescriptorSetLayout mDescLayout;
+    VkDescriptorPool mDescPool;
+    VkDescriptorSet mDescSet;
+    VkPipelineLayout mPipelineLayout;
+    VkPipeline mPipeline;
+};
+
+#endif // VULKAN_CORE_GPU_CULLER_H
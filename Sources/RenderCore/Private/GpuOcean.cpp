@@ -0,0 +1,418 @@
+#include "GpuOcean.hpp"
+
+#include <assert.h>
+#include <string.h>
+#include <vector>
+
+#include "HostAllocator.hpp"
+#include "Log.hpp"
+#include "Utils.hpp"
+
+#ifdef RENDERCORE_SHADERS
+static const uint32_t OceanSpectrumSpirv[] = {
+#include "OceanSpectrum.comp.inc"
+};
+static const uint32_t OceanFftSpirv[] = {
+#include "OceanFft.comp.inc"
+};
+static const uint32_t OceanResolveSpirv[] = {
+#include "OceanResolve.comp.inc"
+};
+#endif
+
+// must match local_size_x and local_size_y of OceanSpectrum.comp and OceanResolve.comp
+static const uint32_t GroupSize = 8;
+static const VkFormat MapFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+static const uint32_t BindingCount = 4;
+
+GpuOcean::GpuOcean()
+    : mEnabled(false), mImagesReady(false),
+      mReaders(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT), mDevice(VK_NULL_HANDLE),
+      mSettings(), mLogSize(0), mSampler(VK_NULL_HANDLE), mDescLayout(VK_NULL_HANDLE), mDescPool(VK_NULL_HANDLE),
+      mDescSet(VK_NULL_HANDLE), mPipelineLayout(VK_NULL_HANDLE), mSpectrumPipeline(VK_NULL_HANDLE),
+      mFftPipeline(VK_NULL_HANDLE), mResolvePipeline(VK_NULL_HANDLE)
+{
+    mSpectrumBuffer.buf = VK_NULL_HANDLE;
+    mSpectrumBuffer.mem = VK_NULL_HANDLE;
+    mFieldBuffer.buf = VK_NULL_HANDLE;
+    mFieldBuffer.mem = VK_NULL_HANDLE;
+    for (ImageResource *image : {&mDisplacement, &mNormal})
+    {
+        image->image = VK_NULL_HANDLE;
+        image->mem = VK_NULL_HANDLE;
+        image->view = VK_NULL_HANDLE;
+    }
+}
+
+bool GpuOcean::Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                    const OceanSettings &settings)
+{
+    RC_INFO("GpuOcean::Init {}x{} cells, {} cascades", settings.size, settings.size, settings.cascadeCount);
+
+#ifndef RENDERCORE_SHADERS
+    RC_WARN("RenderCore was built without shaders, gpu ocean disabled");
+    return false;
+#endif
+    assert(settings.size >= 16 && settings.size <= 1024 && (settings.size & (settings.size - 1)) == 0);
+    assert(settings.cascadeCount >= 1 && settings.cascadeCount <= OceanSettings::MaxCascades);
+
+    mDevice = device;
+    mSettings = settings;
+    mLogSize = 0;
+    while ((1u << mLogSize) < mSettings.size)
+    {
+        mLogSize++;
+    }
+
+    // one complex float per cell of every field
+    VkDeviceSize area = static_cast<VkDeviceSize>(mSettings.size) * mSettings.size;
+    VkResult res = CreateBuffer(mDevice, memoryProperties,
+                                area * mSettings.cascadeCount * OceanFieldCount * 2 * sizeof(float),
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                                mFieldBuffer);
+    PANIC_IF_NOT_SUCCESS(res);
+    uploadSpectrum(memoryProperties);
+
+    mDisplacement.format = MapFormat;
+    mNormal.format = MapFormat;
+    initImage(memoryProperties, mDisplacement);
+    initImage(memoryProperties, mNormal);
+    initSampler();
+    initDescriptors();
+    initPipelines();
+    mImagesReady = false;
+    mEnabled = true;
+    return true;
+}
+
+void GpuOcean::uploadSpectrum(const VkPhysicalDeviceMemoryProperties &memoryProperties)
+{
+    // generated in cached memory, the mirror pass reads back what it wrote
+    size_t area = static_cast<size_t>(mSettings.size) * mSettings.size;
+    std::vector<OceanSpectrumTexel> texels(area * mSettings.cascadeCount);
+    for (uint32_t cascade = 0; cascade < mSettings.cascadeCount; cascade++)
+    {
+        GenerateOceanSpectrum(mSettings, cascade, texels.data() + area * cascade);
+    }
+
+    // written once, device local host visible memory is preferred
+    void *mapped = nullptr;
+    VkResult res = CreateBuffer(mDevice, memoryProperties, sizeof(OceanSpectrumTexel) * texels.size(),
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mSpectrumBuffer, &mapped);
+    PANIC_IF_NOT_SUCCESS(res);
+    memcpy(mapped, texels.data(), sizeof(OceanSpectrumTexel) * texels.size());
+    vkUnmapMemory(mDevice, mSpectrumBuffer.mem);
+}
+
+void GpuOcean::initImage(const VkPhysicalDeviceMemoryProperties &memoryProperties, ImageResource &image)
+{
+    VkImageCreateInfo imageCreateInfo = {};
+    imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageCreateInfo.pNext = nullptr;
+    imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageCreateInfo.format = image.format;
+    imageCreateInfo.extent.width = mSettings.size;
+    imageCreateInfo.extent.height = mSettings.size;
+    imageCreateInfo.extent.depth = 1;
+    imageCreateInfo.mipLevels = 1;
+    imageCreateInfo.arrayLayers = mSettings.cascadeCount;
+    imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageCreateInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageCreateInfo.queueFamilyIndexCount = 0;
+    imageCreateInfo.pQueueFamilyIndices = nullptr;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.flags = 0;
+    VkResult res = vkCreateImage(mDevice, &imageCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE), &image.image);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkMemoryRequirements memReqs;
+    vkGetImageMemoryRequirements(mDevice, image.image, &memReqs);
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.allocationSize = memReqs.size;
+    bool found = FindMemoryType(memoryProperties, memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                &allocInfo.memoryTypeIndex);
+    assert(found);
+    (void)found;
+    res = vkAllocateMemory(mDevice, &allocInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY), &image.mem);
+    PANIC_IF_NOT_SUCCESS(res);
+    image.memSize = allocInfo.allocationSize;
+    FLIGHT_RECORD(FlightEventType::Allocation, allocInfo.memoryTypeIndex, (uint64_t)image.mem, image.memSize);
+    res = vkBindImageMemory(mDevice, image.image, image.mem, 0);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkImageViewCreateInfo viewCreateInfo = {};
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.pNext = nullptr;
+    viewCreateInfo.image = image.image;
+    viewCreateInfo.format = image.format;
+    viewCreateInfo.components.r = VK_COMPONENT_SWIZZLE_R;
+    viewCreateInfo.components.g = VK_COMPONENT_SWIZZLE_G;
+    viewCreateInfo.components.b = VK_COMPONENT_SWIZZLE_B;
+    viewCreateInfo.components.a = VK_COMPONENT_SWIZZLE_A;
+    viewCreateInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewCreateInfo.subresourceRange.baseMipLevel = 0;
+    viewCreateInfo.subresourceRange.levelCount = 1;
+    viewCreateInfo.subresourceRange.baseArrayLayer = 0;
+    viewCreateInfo.subresourceRange.layerCount = mSettings.cascadeCount;
+    viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    viewCreateInfo.flags = 0;
+    res = vkCreateImageView(mDevice, &viewCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW), &image.view);
+    PANIC_IF_NOT_SUCCESS(res);
+}
+
+void GpuOcean::initSampler()
+{
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = nullptr;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = 0.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    VkResult res = vkCreateSampler(mDevice, &samplerInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_SAMPLER), &mSampler);
+    PANIC_IF_NOT_SUCCESS(res);
+}
+
+void GpuOcean::initDescriptors()
+{
+    // spectrum, fields, displacement map, normal map; every pass binds the same set
+    const VkDescriptorType types[BindingCount] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                                                  VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE};
+    VkDescriptorSetLayoutBinding layoutBindings[BindingCount];
+    for (uint32_t i = 0; i < BindingCount; i++)
+    {
+        layoutBindings[i].binding = i;
+        layoutBindings[i].descriptorType = types[i];
+        layoutBindings[i].descriptorCount = 1;
+        layoutBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        layoutBindings[i].pImmutableSamplers = nullptr;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descSetLayoutInfo = {};
+    descSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descSetLayoutInfo.pNext = nullptr;
+    descSetLayoutInfo.flags = 0;
+    descSetLayoutInfo.bindingCount = BindingCount;
+    descSetLayoutInfo.pBindings = layoutBindings;
+    VkResult res = vkCreateDescriptorSetLayout(mDevice, &descSetLayoutInfo,
+                                               VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &mDescLayout);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorPoolSize poolSizes[2];
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[0].descriptorCount = 2;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[1].descriptorCount = 2;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    res = vkCreateDescriptorPool(mDevice, &poolInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &mDescPool);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = mDescPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &mDescLayout;
+    res = vkAllocateDescriptorSets(mDevice, &allocInfo, &mDescSet);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorImageInfo imageInfos[2];
+    imageInfos[0].sampler = VK_NULL_HANDLE;
+    imageInfos[0].imageView = mDisplacement.view;
+    imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageInfos[1] = imageInfos[0];
+    imageInfos[1].imageView = mNormal.view;
+
+    VkWriteDescriptorSet writes[BindingCount];
+    for (uint32_t i = 0; i < BindingCount; i++)
+    {
+        writes[i] = {};
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].pNext = nullptr;
+        writes[i].dstSet = mDescSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = types[i];
+    }
+    writes[0].pBufferInfo = &mSpectrumBuffer.bufferInfo;
+    writes[1].pBufferInfo = &mFieldBuffer.bufferInfo;
+    writes[2].pImageInfo = &imageInfos[0];
+    writes[3].pImageInfo = &imageInfos[1];
+    vkUpdateDescriptorSets(mDevice, BindingCount, writes, 0, nullptr);
+}
+
+void GpuOcean::initPipelines()
+{
+#ifdef RENDERCORE_SHADERS
+    VkPushConstantRange pushRange = {};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(PushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.pNext = nullptr;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushRange;
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &mDescLayout;
+    VkResult res = vkCreatePipelineLayout(mDevice, &pipelineLayoutCreateInfo,
+                                          VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &mPipelineLayout);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    res = CreateComputePipeline(mDevice, OceanSpectrumSpirv, sizeof(OceanSpectrumSpirv), mPipelineLayout,
+                                &mSpectrumPipeline);
+    PANIC_IF_NOT_SUCCESS(res);
+    res = CreateComputePipeline(mDevice, OceanFftSpirv, sizeof(OceanFftSpirv), mPipelineLayout, &mFftPipeline);
+    PANIC_IF_NOT_SUCCESS(res);
+    res = CreateComputePipeline(mDevice, OceanResolveSpirv, sizeof(OceanResolveSpirv), mPipelineLayout,
+                                &mResolvePipeline);
+    PANIC_IF_NOT_SUCCESS(res);
+#endif
+}
+
+void GpuOcean::Destroy()
+{
+    if (mDevice == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    vkDestroyPipeline(mDevice, mSpectrumPipeline, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipeline(mDevice, mFftPipeline, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipeline(mDevice, mResolvePipeline, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE));
+    vkDestroyPipelineLayout(mDevice, mPipelineLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+    // destroying the pool frees the set
+    vkDestroyDescriptorPool(mDevice, mDescPool, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    vkDestroyDescriptorSetLayout(mDevice, mDescLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    vkDestroySampler(mDevice, mSampler, VK_ALLOCATOR(VK_OBJECT_TYPE_SAMPLER));
+    for (ImageResource *image : {&mDisplacement, &mNormal})
+    {
+        vkDestroyImageView(mDevice, image->view, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(mDevice, image->image, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE));
+        if (image->mem != VK_NULL_HANDLE)
+        {
+            FLIGHT_RECORD(FlightEventType::Free, 0, (uint64_t)image->mem, image->memSize);
+        }
+        vkFreeMemory(mDevice, image->mem, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        image->image = VK_NULL_HANDLE;
+        image->mem = VK_NULL_HANDLE;
+        image->view = VK_NULL_HANDLE;
+    }
+    DestroyBuffer(mDevice, mSpectrumBuffer);
+    DestroyBuffer(mDevice, mFieldBuffer);
+    mEnabled = false;
+    mDevice = VK_NULL_HANDLE;
+}
+
+void GpuOcean::SetChoppiness(float choppiness)
+{
+    mSettings.choppiness = choppiness;
+}
+
+void GpuOcean::AddReaders(VkPipelineStageFlags stages)
+{
+    mReaders |= stages;
+}
+
+void GpuOcean::dispatch(VkCommandBuffer cmd, VkPipeline pipeline, const PushConstants &constants, uint32_t x,
+                        uint32_t y, uint32_t z)
+{
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdPushConstants(cmd, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmd, x, y, z);
+
+    // every pass reads what the previous one wrote
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                         &barrier, 0, nullptr, 0, nullptr);
+}
+
+void GpuOcean::Update(VkCommandBuffer cmd, double seconds)
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    // the previous frame's draws and resolve may still read the maps and fields being rewritten
+    const VkPipelineStageFlags readers = mReaders;
+    if (mImagesReady)
+    {
+        vkCmdPipelineBarrier(cmd, readers | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 0, nullptr);
+    }
+    else
+    {
+        VkImageMemoryBarrier imageBarriers[2];
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            imageBarriers[i] = {};
+            imageBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarriers[i].pNext = nullptr;
+            imageBarriers[i].srcAccessMask = 0;
+            imageBarriers[i].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            imageBarriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageBarriers[i].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            imageBarriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarriers[i].image = i == 0 ? mDisplacement.image : mNormal.image;
+            imageBarriers[i].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            imageBarriers[i].subresourceRange.baseMipLevel = 0;
+            imageBarriers[i].subresourceRange.levelCount = 1;
+            imageBarriers[i].subresourceRange.baseArrayLayer = 0;
+            imageBarriers[i].subresourceRange.layerCount = mSettings.cascadeCount;
+        }
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0,
+                             nullptr, 0, nullptr, 2, imageBarriers);
+        mImagesReady = true;
+    }
+
+    PushConstants constants;
+    constants.size = mSettings.size;
+    constants.logSize = mLogSize;
+    constants.pass = 0;
+    constants.time = WrapOceanTime(mSettings, seconds);
+    constants.choppiness = mSettings.choppiness;
+
+    const uint32_t groups = mSettings.size / GroupSize;
+    const uint32_t lines = mSettings.cascadeCount * OceanFieldCount;
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &mDescSet, 0, nullptr);
+    dispatch(cmd, mSpectrumPipeline, constants, groups, groups, mSettings.cascadeCount);
+    dispatch(cmd, mFftPipeline, constants, mSettings.size, lines, 1);
+    constants.pass = 1;
+    dispatch(cmd, mFftPipeline, constants, mSettings.size, lines, 1);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mResolvePipeline);
+    vkCmdPushConstants(cmd, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(cmd, groups, groups, mSettings.cascadeCount);
+
+    VkMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readers, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
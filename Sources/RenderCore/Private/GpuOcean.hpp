@@ -0,0 +1,104 @@
+#ifndef VULKAN_CORE_GPU_OCEAN_H
+#define VULKAN_CORE_GPU_OCEAN_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdint.h>
+
+#include "OceanSpectrum.hpp"
+#include "Resources.hpp"
+
+// Spectral ocean on the gpu. Initial amplitudes are generated once on the cpu (see
+// OceanSpectrum.hpp) and uploaded; every Update then runs four compute passes: advance the
+// spectrum to the current time, inverse FFT the rows, then the columns, and resolve the fields
+// into two rgba16f array images with one layer per cascade:
+//   displacement: xyz offset of the surface point, height in y, w jacobian (foam where below 0)
+//   normal: xyz unit normal of the displaced surface
+// Sample layer c at world xz / patchSize[c] with repeat addressing and add the cascades up. The
+// images stay in VK_IMAGE_LAYOUT_GENERAL.
+//
+// The fields are single buffered: Update must not overlap another frame's Update on the gpu,
+// which in-order submission to one queue guarantees.
+class GpuOcean
+{
+  public:
+    GpuOcean();
+
+    // false when RenderCore was built without shaders, the ocean then stays disabled
+    bool Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+              const OceanSettings &settings);
+    void Destroy();
+
+    bool IsEnabled() const
+    {
+        return mEnabled;
+    }
+
+    const OceanSettings &GetSettings() const
+    {
+        return mSettings;
+    }
+    // takes effect with the next Update, the spectrum is not regenerated
+    void SetChoppiness(float choppiness);
+
+    // outside a render pass, before the frame's draws sample the maps
+    void Update(VkCommandBuffer cmd, double seconds);
+    // stages sampling the maps besides the vertex and fragment shaders, Update synchronizes with them
+    void AddReaders(VkPipelineStageFlags stages);
+
+    VkImageView GetDisplacementView() const
+    {
+        return mDisplacement.view;
+    }
+    VkImageView GetNormalView() const
+    {
+        return mNormal.view;
+    }
+    // linear, repeat
+    VkSampler GetSampler() const
+    {
+        return mSampler;
+    }
+
+  private:
+    struct PushConstants
+    {
+        uint32_t size;
+        uint32_t logSize;
+        // OceanFft.comp: 0 rows, 1 columns
+        uint32_t pass;
+        float time;
+        float choppiness;
+    };
+
+    void initImage(const VkPhysicalDeviceMemoryProperties &memoryProperties, ImageResource &image);
+    void initSampler();
+    void initDescriptors();
+    void initPipelines();
+    void uploadSpectrum(const VkPhysicalDeviceMemoryProperties &memoryProperties);
+    void dispatch(VkCommandBuffer cmd, VkPipeline pipeline, const PushConstants &constants, uint32_t x, uint32_t y,
+                  uint32_t z);
+
+    bool mEnabled;
+    bool mImagesReady;
+    VkPipelineStageFlags mReaders;
+    VkDevice mDevice;
+    OceanSettings mSettings;
+    uint32_t mLogSize;
+
+    BufferResource mSpectrumBuffer;
+    BufferResource mFieldBuffer;
+    ImageResource mDisplacement;
+    ImageResource mNormal;
+    VkSampler mSampler;
+
+    VkDescriptorSetLayout mDescLayout;
+    VkDescriptorPool mDescPool;
+    VkDescriptorSet mDescSet;
+    VkPipelineLayout mPipelineLayout;
+    VkPipeline mSpectrumPipeline;
+    VkPipeline mFftPipeline;
+    VkPipeline mResolvePipeline;
+};
+
+#endif // VULKAN_CORE_GPU_OCEAN_H
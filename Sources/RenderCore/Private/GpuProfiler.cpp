@@ -0,0 +1,405 @@
+#include "GpuProfiler.hpp"
+
+#include "BinaryLog.hpp"
+#include "HostAllocator.hpp"
+#include "Log.hpp"
+#include "Utils.hpp"
+
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// calibration drifts slowly, refresh it every few hundred frames
+static const uint64_t RecalibrateInterval = 256;
+
+static const VkQueryPipelineStatisticFlags StatisticsFlags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT | VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+// seven counters followed by the availability word
+static const uint32_t StatisticsStride = 8;
+
+GpuProfiler::GpuProfiler()
+    : mEnabled(false), mCalibrated(false), mStatisticsSupported(false), mStatisticsEnabled(false),
+      mFrameStatistics(false), mDevice(VK_NULL_HANDLE), mTimestampPeriod(1.0f), mTimestampMask(0),
+      mMaxQueries(0), mCpuDomain(VK_TIME_DOMAIN_DEVICE_EXT), mGetCalibratedTimestamps(nullptr),
+      mCalibrationGpuTicks(0), mCalibrationCpuNs(0), mFrameCounter(0), mCurrent(nullptr), mPendingEnds(0),
+      mResolvedFrame(0)
+{
+}
+
+void GpuProfiler::Init(VkInstance inst, VkPhysicalDevice gpu, VkDevice device, uint32_t timestampValidBits,
+                       float timestampPeriod, bool calibratedTimestamps, bool pipelineStatisticsQuery,
+                       uint32_t framesInFlight, uint32_t maxZonesPerFrame)
+{
+    RC_INFO("GpuProfiler::Init");
+
+    if (timestampValidBits == 0)
+    {
+        RC_WARN("graphics queue does not support timestamps, gpu profiler disabled");
+        return;
+    }
+
+    mDevice = device;
+    mTimestampPeriod = timestampPeriod;
+    mTimestampMask = timestampValidBits >= 64 ? ~0ull : ((1ull << timestampValidBits) - 1);
+    mMaxQueries = maxZonesPerFrame * 2;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = 0;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = mMaxQueries;
+    poolInfo.pipelineStatistics = 0;
+
+    VkQueryPoolCreateInfo statisticsPoolInfo = poolInfo;
+    statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+    statisticsPoolInfo.queryCount = maxZonesPerFrame;
+    statisticsPoolInfo.pipelineStatistics = StatisticsFlags;
+    mStatisticsSupported = pipelineStatisticsQuery;
+
+    mFrames.resize(framesInFlight);
+    for (auto &frame : mFrames)
+    {
+        VkResult res = vkCreateQueryPool(mDevice, &poolInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_QUERY_POOL), &frame.pool);
+        PANIC_IF_NOT_SUCCESS(res);
+        frame.statisticsPool = VK_NULL_HANDLE;
+        if (mStatisticsSupported)
+        {
+            res = vkCreateQueryPool(mDevice, &statisticsPoolInfo,
+                                    VK_ALLOCATOR(VK_OBJECT_TYPE_QUERY_POOL), &frame.statisticsPool);
+            PANIC_IF_NOT_SUCCESS(res);
+        }
+        frame.queryCount = 0;
+        frame.statisticsCount = 0;
+        frame.frame = 0;
+        frame.zones.reserve(maxZonesPerFrame);
+        frame.beginQueries.reserve(maxZonesPerFrame);
+        frame.endQueries.reserve(maxZonesPerFrame);
+        frame.statisticsQueries.reserve(maxZonesPerFrame);
+    }
+    mQueryResults.resize(mMaxQueries * 2);
+    mStatisticsResults.resize(maxZonesPerFrame * StatisticsStride);
+    mEnabled = true;
+
+    if (!calibratedTimestamps)
+    {
+        RC_INFO("VK_EXT_calibrated_timestamps not enabled, gpu zones are frame relative");
+        return;
+    }
+
+    auto getDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+        vkGetInstanceProcAddr(inst, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+    mGetCalibratedTimestamps = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+        vkGetDeviceProcAddr(mDevice, "vkGetCalibratedTimestampsEXT"));
+    if (getDomains == nullptr || mGetCalibratedTimestamps == nullptr)
+    {
+        return;
+    }
+
+    uint32_t domainCount = 0;
+    getDomains(gpu, &domainCount, nullptr);
+    std::vector<VkTimeDomainEXT> domains(domainCount);
+    getDomains(gpu, &domainCount, domains.data());
+
+    // the cpu domain has to be the one std::chrono::steady_clock reads
+#ifdef _WIN32
+    const VkTimeDomainEXT wanted = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#elif defined(__APPLE__)
+    const VkTimeDomainEXT wanted = VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+#else
+    const VkTimeDomainEXT wanted = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+    bool hasDevice = false;
+    bool hasCpu = false;
+    for (auto domain : domains)
+    {
+        hasDevice |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+        hasCpu |= domain == wanted;
+    }
+
+    if (hasDevice && hasCpu)
+    {
+        mCpuDomain = wanted;
+        calibrate();
+    }
+}
+
+void GpuProfiler::Destroy()
+{
+    for (auto &frame : mFrames)
+    {
+        vkDestroyQueryPool(mDevice, frame.pool, VK_ALLOCATOR(VK_OBJECT_TYPE_QUERY_POOL));
+        vkDestroyQueryPool(mDevice, frame.statisticsPool, VK_ALLOCATOR(VK_OBJECT_TYPE_QUERY_POOL));
+    }
+    mFrames.clear();
+    mCurrent = nullptr;
+    mEnabled = false;
+}
+
+void GpuProfiler::SetPipelineStatisticsEnabled(bool enabled)
+{
+    if (enabled && !mStatisticsSupported)
+    {
+        RC_WARN("pipelineStatisticsQuery is not supported, pipeline statistics stay disabled");
+        return;
+    }
+    mStatisticsEnabled = enabled;
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex)
+{
+    FLIGHT_RECORD(FlightEventType::FrameBegin, frameIndex, mFrameCounter + 1);
+
+    if (!mEnabled)
+    {
+        return;
+    }
+
+    FrameQueries &frame = mFrames[frameIndex % mFrames.size()];
+    if (frame.queryCount > 0)
+    {
+        resolve(frame);
+    }
+
+    mFrameCounter++;
+    if (mCalibrated && mFrameCounter % RecalibrateInterval == 0)
+    {
+        calibrate();
+    }
+
+    frame.frame = mFrameCounter;
+    frame.queryCount = 0;
+    frame.statisticsCount = 0;
+    frame.zones.clear();
+    frame.beginQueries.clear();
+    frame.endQueries.clear();
+    frame.statisticsQueries.clear();
+    mOpenZones.clear();
+    mPendingEnds = 0;
+    mCurrent = &frame;
+    mFrameStatistics = mStatisticsEnabled;
+
+    vkCmdResetQueryPool(cmd, frame.pool, 0, mMaxQueries);
+    if (mFrameStatistics)
+    {
+        vkCmdResetQueryPool(cmd, frame.statisticsPool, 0, mMaxQueries / 2);
+    }
+}
+
+void GpuProfiler::BeginZone(VkCommandBuffer cmd, const char *name)
+{
+    // the zones already open still need their end timestamps
+    if (mCurrent == nullptr || mCurrent->queryCount + 2 + mPendingEnds > mMaxQueries)
+    {
+        // keep the stack balanced so EndZone can tell dropped zones apart
+        mOpenZones.push_back(UINT32_MAX);
+        return;
+    }
+
+    uint32_t query = mCurrent->queryCount++;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mCurrent->pool, query);
+
+    GpuZone zone = {};
+    zone.name = name;
+    zone.depth = static_cast<uint32_t>(mOpenZones.size());
+
+    uint32_t statisticsQuery = UINT32_MAX;
+    if (mFrameStatistics && zone.depth == 0)
+    {
+        statisticsQuery = mCurrent->statisticsCount++;
+        vkCmdBeginQuery(cmd, mCurrent->statisticsPool, statisticsQuery, 0);
+    }
+
+    mOpenZones.push_back(static_cast<uint32_t>(mCurrent->zones.size()));
+    mPendingEnds++;
+    mCurrent->zones.push_back(zone);
+    mCurrent->beginQueries.push_back(query);
+    mCurrent->endQueries.push_back(UINT32_MAX);
+    mCurrent->statisticsQueries.push_back(statisticsQuery);
+}
+
+void GpuProfiler::EndZone(VkCommandBuffer cmd)
+{
+    if (mOpenZones.empty())
+    {
+        return;
+    }
+
+    uint32_t zone = mOpenZones.back();
+    mOpenZones.pop_back();
+    if (zone == UINT32_MAX || mCurrent == nullptr)
+    {
+        return;
+    }
+    mPendingEnds--;
+
+    if (mCurrent->statisticsQueries[zone] != UINT32_MAX)
+    {
+        vkCmdEndQuery(cmd, mCurrent->statisticsPool, mCurrent->statisticsQueries[zone]);
+    }
+
+    // BeginZone reserved the slot, never write past the pool even so; the zone then resolves as
+    // unfinished
+    if (mCurrent->queryCount >= mMaxQueries)
+    {
+        return;
+    }
+    uint32_t query = mCurrent->queryCount++;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mCurrent->pool, query);
+    mCurrent->endQueries[zone] = query;
+}
+
+void GpuProfiler::calibrate()
+{
+    VkCalibratedTimestampInfoEXT infos[2] = {};
+    infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[0].pNext = nullptr;
+    infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+    infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+    infos[1].pNext = nullptr;
+    infos[1].timeDomain = mCpuDomain;
+
+    uint64_t timestamps[2];
+    uint64_t maxDeviation;
+    VkResult res = mGetCalibratedTimestamps(mDevice, 2, infos, timestamps, &maxDeviation);
+    if (res != VK_SUCCESS)
+    {
+        RC_WARN("vkGetCalibratedTimestampsEXT failed: {}", GetVkResultString(res));
+        mCalibrated = false;
+        return;
+    }
+
+    mCalibrationGpuTicks = timestamps[0] & mTimestampMask;
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    mCalibrationCpuNs = static_cast<uint64_t>(static_cast<double>(timestamps[1]) * 1e9 / frequency.QuadPart);
+#else
+    mCalibrationCpuNs = timestamps[1];
+#endif
+    mCalibrated = true;
+}
+
+uint64_t GpuProfiler::toNanoseconds(uint64_t ticks) const
+{
+    // queries may predate the calibration point, so sign extend the wrapped difference
+    uint64_t delta = (ticks - mCalibrationGpuTicks) & mTimestampMask;
+    int64_t signedDelta = static_cast<int64_t>(delta);
+    if (mTimestampMask != ~0ull && (delta & ~(mTimestampMask >> 1)))
+    {
+        signedDelta = static_cast<int64_t>(delta) - static_cast<int64_t>(mTimestampMask) - 1;
+    }
+    return mCalibrationCpuNs + static_cast<int64_t>(static_cast<double>(signedDelta) * mTimestampPeriod);
+}
+
+void GpuProfiler::resolve(FrameQueries &frame)
+{
+    // no WAIT flag: the slot is a full ring of frames old, if it is still pending we drop it
+    VkResult res = vkGetQueryPoolResults(mDevice, frame.pool, 0, frame.queryCount,
+                                         frame.queryCount * 2 * sizeof(uint64_t), mQueryResults.data(),
+                                         2 * sizeof(uint64_t),
+                                         VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (res != VK_SUCCESS && res != VK_NOT_READY)
+    {
+        RC_WARN("vkGetQueryPoolResults failed: {}", GetVkResultString(res));
+        return;
+    }
+
+    bool haveStatistics = false;
+    if (frame.statisticsCount > 0)
+    {
+        res = vkGetQueryPoolResults(mDevice, frame.statisticsPool, 0, frame.statisticsCount,
+                                    frame.statisticsCount * StatisticsStride * sizeof(uint64_t),
+                                    mStatisticsResults.data(), StatisticsStride * sizeof(uint64_t),
+                                    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        haveStatistics = res == VK_SUCCESS || res == VK_NOT_READY;
+    }
+
+    uint64_t frameStart = 0;
+    bool haveFrameStart = false;
+    mResolvedZones.clear();
+    for (size_t i = 0; i < frame.zones.size(); i++)
+    {
+        uint32_t beginQuery = frame.beginQueries[i];
+        uint32_t endQuery = frame.endQueries[i];
+        if (endQuery == UINT32_MAX || mQueryResults[beginQuery * 2 + 1] == 0 || mQueryResults[endQuery * 2 + 1] == 0)
+        {
+            continue;
+        }
+
+        uint64_t begin = mQueryResults[beginQuery * 2] & mTimestampMask;
+        uint64_t end = mQueryResults[endQuery * 2] & mTimestampMask;
+        if (!haveFrameStart)
+        {
+            frameStart = begin;
+            haveFrameStart = true;
+        }
+
+        GpuZone zone = frame.zones[i];
+        if (mCalibrated)
+        {
+            zone.beginNs = toNanoseconds(begin);
+            zone.endNs = toNanoseconds(end);
+        }
+        else
+        {
+            uint64_t beginTicks = (begin - frameStart) & mTimestampMask;
+            uint64_t endTicks = (end - frameStart) & mTimestampMask;
+            zone.beginNs = static_cast<uint64_t>(static_cast<double>(beginTicks) * mTimestampPeriod);
+            zone.endNs = static_cast<uint64_t>(static_cast<double>(endTicks) * mTimestampPeriod);
+        }
+
+        uint32_t statisticsQuery = frame.statisticsQueries[i];
+        if (haveStatistics && statisticsQuery != UINT32_MAX &&
+            mStatisticsResults[statisticsQuery * StatisticsStride + StatisticsStride - 1] != 0)
+        {
+            const uint64_t *counters = &mStatisticsResults[statisticsQuery * StatisticsStride];
+            zone.hasStatistics = true;
+            zone.statistics.inputAssemblyVertices = counters[0];
+            zone.statistics.inputAssemblyPrimitives = counters[1];
+            zone.statistics.vertexShaderInvocations = counters[2];
+            zone.statistics.clippingInvocations = counters[3];
+            zone.statistics.clippingPrimitives = counters[4];
+            zone.statistics.fragmentShaderInvocations = counters[5];
+            zone.statistics.computeShaderInvocations = counters[6];
+        }
+        BLOG("gpu frame {} zone {} depth {} {} ns", frame.frame, zone.name, zone.depth, zone.endNs - zone.beginNs);
+        mResolvedZones.push_back(zone);
+    }
+    mResolvedFrame = frame.frame;
+    frame.queryCount = 0;
+}
+
+std::string GpuProfiler::GetFrameReport() const
+{
+    std::string report = "gpu frame " + std::to_string(mResolvedFrame) + ":";
+    for (auto &zone : mResolvedZones)
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf), "\n%*s%s %.3fms", static_cast<int>(zone.depth * 2), "", zone.name,
+                 static_cast<double>(zone.endNs - zone.beginNs) / 1e6);
+        report += buf;
+
+        if (zone.hasStatistics)
+        {
+            const GpuPipelineStatistics &st = zone.statistics;
+            snprintf(buf, sizeof(buf),
+                     " iaVerts=%llu iaPrims=%llu vs=%llu clipIn=%llu clipOut=%llu fs=%llu cs=%llu",
+                     static_cast<unsigned long long>(st.inputAssemblyVertices),
+                     static_cast<unsigned long long>(st.inputAssemblyPrimitives),
+                     static_cast<unsigned long long>(st.vertexShaderInvocations),
+                     static_cast<unsigned long long>(st.clippingInvocations),
+                     static_cast<unsigned long long>(st.clippingPrimitives),
+                     static_cast<unsigned long long>(st.fragmentShaderInvocations),
+                     static_cast<unsigned long long>(st.computeShaderInvocations));
+            report += buf;
+        }
+    }
+    return report;
+}
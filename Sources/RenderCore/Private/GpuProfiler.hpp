@@ -0,0 +1,156 @@
+#ifndef VULKAN_CORE_GPU_PROFILER_H
+#define VULKAN_CORE_GPU_PROFILER_H
+
+#include <vulkan/vulkan.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Counters of VK_QUERY_TYPE_PIPELINE_STATISTICS, in the order the driver writes them
+struct GpuPipelineStatistics
+{
+    uint64_t inputAssemblyVertices;
+    uint64_t inputAssemblyPrimitives;
+    uint64_t vertexShaderInvocations;
+    uint64_t clippingInvocations;
+    uint64_t clippingPrimitives;
+    uint64_t fragmentShaderInvocations;
+    uint64_t computeShaderInvocations;
+};
+
+// A timed region of one frame. Times are nanoseconds on the CPU steady clock when the
+// device supports VK_EXT_calibrated_timestamps, otherwise relative to the frame's first query.
+struct GpuZone
+{
+    const char *name;
+    uint32_t depth;
+    uint64_t beginNs;
+    uint64_t endNs;
+    bool hasStatistics;
+    GpuPipelineStatistics statistics;
+};
+
+// Timestamp queries with one query pool per frame in flight. A pool is read back when its
+// frame slot comes around again, so results arrive framesInFlight frames late without a stall.
+class GpuProfiler
+{
+  public:
+    class Scope
+    {
+      public:
+        Scope(GpuProfiler &profiler, VkCommandBuffer cmd, const char *name) : mProfiler(profiler), mCmd(cmd)
+        {
+            mProfiler.BeginZone(mCmd, name);
+        }
+
+        ~Scope()
+        {
+            mProfiler.EndZone(mCmd);
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        GpuProfiler &mProfiler;
+        VkCommandBuffer mCmd;
+    };
+
+    GpuProfiler();
+
+    void Init(VkInstance inst, VkPhysicalDevice gpu, VkDevice device, uint32_t timestampValidBits,
+              float timestampPeriod, bool calibratedTimestamps, bool pipelineStatisticsQuery, uint32_t framesInFlight,
+              uint32_t maxZonesPerFrame = 128);
+    void Destroy();
+
+    bool IsEnabled() const
+    {
+        return mEnabled;
+    }
+
+    bool IsCalibrated() const
+    {
+        return mCalibrated;
+    }
+
+    // Collect pipeline statistics for the outermost zones, starting with the next frame.
+    // Statistics queries of one type cannot nest, so inner zones only get timings.
+    void SetPipelineStatisticsEnabled(bool enabled);
+
+    bool IsPipelineStatisticsEnabled() const
+    {
+        return mStatisticsEnabled;
+    }
+
+    // record at the start of the frame's first command buffer, before any zone
+    void BeginFrame(VkCommandBuffer cmd, uint32_t frameIndex);
+    void BeginZone(VkCommandBuffer cmd, const char *name);
+    void EndZone(VkCommandBuffer cmd);
+
+    // zones of the most recent frame whose queries were available
+    const std::vector<GpuZone> &GetResolvedZones() const
+    {
+        return mResolvedZones;
+    }
+
+    uint64_t GetResolvedFrame() const
+    {
+        return mResolvedFrame;
+    }
+
+    // one line per resolved zone with its time and, if collected, its statistics
+    std::string GetFrameReport() const;
+
+  private:
+    struct FrameQueries
+    {
+        VkQueryPool pool;
+        VkQueryPool statisticsPool;
+        uint32_t queryCount;
+        uint32_t statisticsCount;
+        uint64_t frame;
+        std::vector<GpuZone> zones;
+        std::vector<uint32_t> beginQueries;
+        std::vector<uint32_t> endQueries;
+        std::vector<uint32_t> statisticsQueries;
+    };
+
+    void calibrate();
+    void resolve(FrameQueries &frame);
+    uint64_t toNanoseconds(uint64_t ticks) const;
+
+    bool mEnabled;
+    bool mCalibrated;
+    bool mStatisticsSupported;
+    bool mStatisticsEnabled;
+    bool mFrameStatistics;
+    VkDevice mDevice;
+    float mTimestampPeriod;
+    uint64_t mTimestampMask;
+    uint32_t mMaxQueries;
+    VkTimeDomainEXT mCpuDomain;
+    PFN_vkGetCalibratedTimestampsEXT mGetCalibratedTimestamps;
+
+    // gpu tick and cpu nanosecond sampled at the same instant
+    uint64_t mCalibrationGpuTicks;
+    uint64_t mCalibrationCpuNs;
+
+    uint64_t mFrameCounter;
+    FrameQueries *mCurrent;
+    std::vector<FrameQueries> mFrames;
+    std::vector<uint32_t> mOpenZones;
+    // open zones that were not dropped, each still owes an end timestamp
+    uint32_t mPendingEnds;
+
+    uint64_t mResolvedFrame;
+    std::vector<GpuZone> mResolvedZones;
+    std::vector<uint64_t> mQueryResults;
+    std::vector<uint64_t> mStatisticsResults;
+};
+
+#define GPU_ZONE_CONCAT_INNER(a, b) a##b
+#define GPU_ZONE_CONCAT(a, b) GPU_ZONE_CONCAT_INNER(a, b)
+#define GPU_ZONE(profiler, cmd, name) GpuProfiler::Scope GPU_ZONE_CONCAT(gpuZone_, __LINE__)(profiler, cmd, name)
+
+#endif // VULKAN_CORE_GPU_PROFILER_H
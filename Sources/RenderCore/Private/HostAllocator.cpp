@@ -0,0 +1,337 @@
+#include "HostAllocator.hpp"
+
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const size_t ArenaSize = 256 * 1024;
+static const size_t MinAlignment = 16;
+
+struct CommandArena
+{
+    std::unique_ptr<char[]> data;
+    size_t used;
+    std::atomic<uint32_t> live;
+};
+
+// sits right in front of every pointer handed to the driver
+struct AllocationHeader
+{
+    uint64_t size;
+    CommandArena *arena;
+    uint32_t offset;
+    uint16_t slot;
+    uint8_t scope;
+    uint8_t padding[9];
+};
+
+static_assert(sizeof(AllocationHeader) == 32, "header must keep 16 byte alignment");
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static AllocationHeader *HeaderOf(void *memory)
+{
+    return reinterpret_cast<AllocationHeader *>(static_cast<char *>(memory) - sizeof(AllocationHeader));
+}
+
+// Command scope memory is freed before the call that allocated it returns, so on the owning
+// thread the arena is empty between calls and can simply be rewound.
+static CommandArena &ThreadArena()
+{
+    thread_local CommandArena arena = {std::unique_ptr<char[]>(new char[ArenaSize]), 0, {0}};
+    return arena;
+}
+
+static char *AllocateFromArena(size_t size, size_t alignment, uint32_t &offset)
+{
+    CommandArena &arena = ThreadArena();
+    if (arena.live.load(std::memory_order_relaxed) == 0)
+    {
+        arena.used = 0;
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(arena.data.get());
+    size_t user = AlignUp(base + arena.used + sizeof(AllocationHeader), alignment) - base;
+    if (user + size > ArenaSize)
+    {
+        return nullptr;
+    }
+
+    offset = static_cast<uint32_t>(user - arena.used);
+    char *memory = arena.data.get() + user;
+    arena.used = user + size;
+    arena.live.fetch_add(1, std::memory_order_relaxed);
+    HeaderOf(memory)->arena = &arena;
+    return memory;
+}
+
+static char *AllocateFromHeap(size_t size, size_t alignment, uint32_t &offset)
+{
+    char *raw = static_cast<char *>(malloc(size + sizeof(AllocationHeader) + alignment - 1));
+    if (raw == nullptr)
+    {
+        return nullptr;
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+    offset = static_cast<uint32_t>(AlignUp(base + sizeof(AllocationHeader), alignment) - base);
+    char *memory = raw + offset;
+    HeaderOf(memory)->arena = nullptr;
+    return memory;
+}
+
+HostAllocator &HostAllocator::Instance()
+{
+    // never destroyed, shared instances and devices may be released by other static destructors
+    static HostAllocator *instance = new HostAllocator();
+    return *instance;
+}
+
+HostAllocator::HostAllocator() : mArenaMisses(0)
+{
+    for (uint32_t i = 0; i < SlotCount; i++)
+    {
+        mSlots[i].index = i;
+        VkAllocationCallbacks &callbacks = mCallbacks[i];
+        callbacks.pUserData = &mSlots[i];
+        callbacks.pfnAllocation = allocate;
+        callbacks.pfnReallocation = reallocate;
+        callbacks.pfnFree = release;
+        callbacks.pfnInternalAllocation = internalAllocate;
+        callbacks.pfnInternalFree = internalFree;
+    }
+
+    for (auto &bytes : mInternalBytes)
+    {
+        bytes = 0;
+    }
+}
+
+uint32_t HostAllocator::slotIndex(VkObjectType type)
+{
+    if (type <= VK_OBJECT_TYPE_COMMAND_POOL)
+    {
+        return static_cast<uint32_t>(type);
+    }
+    if (type == VK_OBJECT_TYPE_SWAPCHAIN_KHR)
+    {
+        return VK_OBJECT_TYPE_COMMAND_POOL + 1;
+    }
+    if (type == VK_OBJECT_TYPE_SURFACE_KHR)
+    {
+        return VK_OBJECT_TYPE_COMMAND_POOL + 2;
+    }
+    return VK_OBJECT_TYPE_COMMAND_POOL + 3;
+}
+
+const char *HostAllocator::slotName(uint32_t slot)
+{
+    static const char *names[SlotCount] = {
+        "Unknown", "Instance", "PhysicalDevice", "Device", "Queue", "Semaphore", "CommandBuffer", "Fence",
+        "DeviceMemory", "Buffer", "Image", "Event", "QueryPool", "BufferView", "ImageView", "ShaderModule",
+        "PipelineCache", "PipelineLayout", "RenderPass", "Pipeline", "DescriptorSetLayout", "Sampler", "DescriptorPool",
+        "DescriptorSet", "Framebuffer", "CommandPool", "Swapchain", "Surface", "Other",
+    };
+    return names[slot];
+}
+
+const VkAllocationCallbacks *HostAllocator::Callbacks(VkObjectType type) const
+{
+    return &mCallbacks[slotIndex(type)];
+}
+
+void HostAllocator::trackCounter(Counter &counter, int64_t bytes)
+{
+    int64_t live = counter.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    counter.allocations.fetch_add(bytes > 0 ? 1 : -1, std::memory_order_relaxed);
+    if (bytes < 0)
+    {
+        return;
+    }
+
+    int64_t peak = counter.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !counter.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    {
+    }
+}
+
+void HostAllocator::track(uint32_t slot, uint32_t scope, int64_t bytes)
+{
+    trackCounter(mSlots[slot].usage, bytes);
+    trackCounter(mScopes[scope], bytes);
+    trackCounter(mTotal, bytes);
+}
+
+HostAllocator::Usage HostAllocator::load(const Counter &counter)
+{
+    Usage usage;
+    usage.bytes = counter.bytes.load(std::memory_order_relaxed);
+    usage.peakBytes = counter.peakBytes.load(std::memory_order_relaxed);
+    usage.allocations = counter.allocations.load(std::memory_order_relaxed);
+    return usage;
+}
+
+void *VKAPI_PTR HostAllocator::allocate(void *userData, size_t size, size_t alignment, VkSystemAllocationScope scope)
+{
+    if (size == 0)
+    {
+        return nullptr;
+    }
+
+    alignment = alignment < MinAlignment ? MinAlignment : alignment;
+    uint32_t offset = 0;
+    char *memory = nullptr;
+    if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND)
+    {
+        memory = AllocateFromArena(size, alignment, offset);
+        if (memory == nullptr)
+        {
+            Instance().mArenaMisses.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (memory == nullptr)
+    {
+        memory = AllocateFromHeap(size, alignment, offset);
+        if (memory == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    Slot *slot = static_cast<Slot *>(userData);
+    AllocationHeader *header = HeaderOf(memory);
+    header->size = size;
+    header->offset = offset;
+    header->slot = static_cast<uint16_t>(slot->index);
+    header->scope = static_cast<uint8_t>(scope);
+    Instance().track(slot->index, scope, static_cast<int64_t>(size));
+    return memory;
+}
+
+void *VKAPI_PTR HostAllocator::reallocate(void *userData, void *original, size_t size, size_t alignment,
+                                          VkSystemAllocationScope scope)
+{
+    if (original == nullptr)
+    {
+        return allocate(userData, size, alignment, scope);
+    }
+    if (size == 0)
+    {
+        release(userData, original);
+        return nullptr;
+    }
+
+    // the spec keeps the original scope, the header knows it
+    AllocationHeader *header = HeaderOf(original);
+    void *memory = allocate(userData, size, alignment, static_cast<VkSystemAllocationScope>(header->scope));
+    if (memory == nullptr)
+    {
+        return nullptr;
+    }
+    memcpy(memory, original, header->size < size ? header->size : size);
+    release(userData, original);
+    return memory;
+}
+
+void VKAPI_PTR HostAllocator::release(void *, void *memory)
+{
+    if (memory == nullptr)
+    {
+        return;
+    }
+
+    HostAllocator &allocator = Instance();
+    AllocationHeader *header = HeaderOf(memory);
+    allocator.track(header->slot, header->scope, -static_cast<int64_t>(header->size));
+    if (header->arena != nullptr)
+    {
+        header->arena->live.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    ::free(static_cast<char *>(memory) - header->offset);
+}
+
+void VKAPI_PTR HostAllocator::internalAllocate(void *, size_t size, VkInternalAllocationType,
+                                               VkSystemAllocationScope scope)
+{
+    Instance().mInternalBytes[scope].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+void VKAPI_PTR HostAllocator::internalFree(void *, size_t size, VkInternalAllocationType,
+                                           VkSystemAllocationScope scope)
+{
+    Instance().mInternalBytes[scope].fetch_sub(static_cast<int64_t>(size), std::memory_order_relaxed);
+}
+
+HostAllocator::Usage HostAllocator::GetUsage(VkObjectType type) const
+{
+    return load(mSlots[slotIndex(type)].usage);
+}
+
+HostAllocator::Usage HostAllocator::GetScopeUsage(VkSystemAllocationScope scope) const
+{
+    return load(mScopes[scope]);
+}
+
+HostAllocator::Usage HostAllocator::GetTotal() const
+{
+    return load(mTotal);
+}
+
+int64_t HostAllocator::GetInternalBytes() const
+{
+    int64_t bytes = 0;
+    for (auto &internal : mInternalBytes)
+    {
+        bytes += internal.load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+std::string HostAllocator::ToReport() const
+{
+    static const char *scopeNames[ScopeCount] = {"command", "object", "cache", "device", "instance"};
+
+    Usage total = GetTotal();
+    char buf[256];
+    snprintf(buf, sizeof(buf), "driver host memory: %.1f KB live in %lld allocations, %.1f KB peak, %.1f KB internal",
+             total.bytes / 1024.0, static_cast<long long>(total.allocations), total.peakBytes / 1024.0,
+             GetInternalBytes() / 1024.0);
+    std::string report = buf;
+
+    for (uint32_t scope = 0; scope < ScopeCount; scope++)
+    {
+        Usage usage = GetScopeUsage(static_cast<VkSystemAllocationScope>(scope));
+        if (usage.peakBytes == 0)
+        {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "\n  scope %-8s %10.1f KB live %10.1f KB peak", scopeNames[scope],
+                 usage.bytes / 1024.0, usage.peakBytes / 1024.0);
+        report += buf;
+    }
+
+    for (uint32_t i = 0; i < SlotCount; i++)
+    {
+        Usage usage = load(mSlots[i].usage);
+        if (usage.peakBytes == 0)
+        {
+            continue;
+        }
+        snprintf(buf, sizeof(buf), "\n  %-20s %10.1f KB live %10.1f KB peak %6lld allocations", slotName(i),
+                 usage.bytes / 1024.0, usage.peakBytes / 1024.0, static_cast<long long>(usage.allocations));
+        report += buf;
+    }
+
+    int64_t misses = GetArenaMisses();
+    if (misses > 0)
+    {
+        snprintf(buf, sizeof(buf), "\n  %lld command allocations missed the arena", static_cast<long long>(misses));
+        report += buf;
+    }
+    return report;
+}
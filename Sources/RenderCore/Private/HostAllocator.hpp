@@ -0,0 +1,91 @@
+#ifndef VULKAN_CORE_HOST_ALLOCATOR_H
+#define VULKAN_CORE_HOST_ALLOCATOR_H
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <stdint.h>
+#include <string>
+
+// VkAllocationCallbacks that account every driver host allocation by object type and
+// allocation scope. Each object type gets its own callbacks, so pass VK_ALLOCATOR(type) to a
+// vkCreate*/vkAllocate* call and the same pointer to the matching vkDestroy*/vkFree*.
+// Command scope allocations live only for the duration of one Vulkan call and are served
+// from a per-thread bump arena instead of the heap.
+class HostAllocator
+{
+  public:
+    struct Usage
+    {
+        int64_t bytes;
+        int64_t peakBytes;
+        int64_t allocations;
+    };
+
+    static HostAllocator &Instance();
+
+    const VkAllocationCallbacks *Callbacks(VkObjectType type) const;
+
+    // live bytes, peak bytes and live allocation count
+    Usage GetUsage(VkObjectType type) const;
+    Usage GetScopeUsage(VkSystemAllocationScope scope) const;
+    Usage GetTotal() const;
+    // memory the driver allocated itself and only reported through the internal notifications
+    int64_t GetInternalBytes() const;
+    // command scope allocations that did not fit the arena
+    int64_t GetArenaMisses() const
+    {
+        return mArenaMisses.load(std::memory_order_relaxed);
+    }
+
+    std::string ToReport() const;
+
+  private:
+    static const uint32_t ScopeCount = VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE + 1;
+    // core object types map to themselves, then swapchain, surface and everything else
+    static const uint32_t SlotCount = VK_OBJECT_TYPE_COMMAND_POOL + 4;
+
+    struct Counter
+    {
+        std::atomic<int64_t> bytes{0};
+        std::atomic<int64_t> peakBytes{0};
+        std::atomic<int64_t> allocations{0};
+    };
+
+    // every allocation counts towards its type, its scope and the total, each keeping the peak of
+    // its own live bytes
+    struct Slot
+    {
+        uint32_t index;
+        Counter usage;
+    };
+
+    HostAllocator();
+
+    static uint32_t slotIndex(VkObjectType type);
+    static const char *slotName(uint32_t slot);
+
+    static void *VKAPI_PTR allocate(void *userData, size_t size, size_t alignment, VkSystemAllocationScope scope);
+    static void *VKAPI_PTR reallocate(void *userData, void *original, size_t size, size_t alignment,
+                                      VkSystemAllocationScope scope);
+    static void VKAPI_PTR release(void *userData, void *memory);
+    static void VKAPI_PTR internalAllocate(void *userData, size_t size, VkInternalAllocationType type,
+                                           VkSystemAllocationScope scope);
+    static void VKAPI_PTR internalFree(void *userData, size_t size, VkInternalAllocationType type,
+                                       VkSystemAllocationScope scope);
+
+    static void trackCounter(Counter &counter, int64_t bytes);
+    void track(uint32_t slot, uint32_t scope, int64_t bytes);
+    static Usage load(const Counter &counter);
+
+    Slot mSlots[SlotCount];
+    VkAllocationCallbacks mCallbacks[SlotCount];
+    Counter mScopes[ScopeCount];
+    Counter mTotal;
+    std::atomic<int64_t> mInternalBytes[ScopeCount];
+    std::atomic<int64_t> mArenaMisses;
+};
+
+#define VK_ALLOCATOR(type) HostAllocator::Instance().Callbacks(type)
+
+#endif // VULKAN_CORE_HOST_ALLOCATOR_H
@@ -0,0 +1,185 @@
+#include "InstanceStream.hpp"
+
+#include <string.h>
+
+#include "Log.hpp"
+#include "Utils.hpp"
+
+InstanceStream::InstanceStream()
+    : mDevice(VK_NULL_HANDLE), mMapped(nullptr), mMaxInstances(0), mFramesInFlight(1), mSlot(0), mDropped(0)
+{
+    mBuffer.buf = VK_NULL_HANDLE;
+    mBuffer.mem = VK_NULL_HANDLE;
+}
+
+void InstanceStream::Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                          uint32_t maxInstances, uint32_t framesInFlight)
+{
+    RC_INFO("InstanceStream::Init {} instances", maxInstances);
+
+    mDevice = device;
+    mMaxInstances = maxInstances;
+    mFramesInFlight = framesInFlight;
+
+    VkDeviceSize size = static_cast<VkDeviceSize>(sizeof(InstanceData)) * maxInstances * framesInFlight;
+    VkResult res = CreateBuffer(mDevice, memoryProperties, size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mBuffer, reinterpret_cast<void **>(&mMapped));
+    PANIC_IF_NOT_SUCCESS(res);
+
+    mBatchIds.reserve(maxInstances);
+    mStaging.reserve(maxInstances);
+    mOrder.resize(maxInstances);
+}
+
+void InstanceStream::Destroy()
+{
+    if (mDevice == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    DestroyBuffer(mDevice, mBuffer);
+    mMapped = nullptr;
+    mDevice = VK_NULL_HANDLE;
+}
+
+VkVertexInputBindingDescription InstanceStream::GetBindingDescription(uint32_t binding)
+{
+    VkVertexInputBindingDescription description = {};
+    description.binding = binding;
+    description.stride = sizeof(InstanceData);
+    description.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    return description;
+}
+
+void InstanceStream::GetAttributeDescriptions(uint32_t binding, uint32_t firstLocation,
+                                              VkVertexInputAttributeDescription attributes[4])
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        attributes[i].location = firstLocation + i;
+        attributes[i].binding = binding;
+        attributes[i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributes[i].offset = i * sizeof(glm::vec4);
+    }
+}
+
+void InstanceStream::BeginFrame(uint32_t frameIndex)
+{
+    mSlot = frameIndex % mFramesInFlight;
+    mBatchIds.clear();
+    mStaging.clear();
+    mBatches.clear();
+    mDropped = 0;
+}
+
+void InstanceStream::Add(uint32_t batch, const glm::mat4 &model, const glm::vec4 &params)
+{
+    if (batch >= MaxBatches)
+    {
+        PANIC("InstanceStream batch id out of range");
+    }
+    if (mStaging.size() >= mMaxInstances)
+    {
+        mDropped++;
+        return;
+    }
+
+    InstanceData data;
+    for (int row = 0; row < 3; row++)
+    {
+        data.rows[row] = glm::vec4(model[0][row], model[1][row], model[2][row], model[3][row]);
+    }
+    data.params = params;
+    mBatchIds.push_back(batch);
+    mStaging.push_back(data);
+}
+
+void InstanceStream::Add(uint32_t batch, const Mat4SoA &models, const glm::vec4 *params, size_t count)
+{
+    if (batch >= MaxBatches)
+    {
+        PANIC("InstanceStream batch id out of range");
+    }
+    size_t room = mMaxInstances - mStaging.size();
+    if (count > room)
+    {
+        mDropped += count - room;
+        count = room;
+    }
+
+    size_t first = mStaging.size();
+    mBatchIds.resize(first + count, batch);
+    mStaging.resize(first + count);
+    for (size_t i = 0; i < count; i++)
+    {
+        InstanceData &data = mStaging[first + i];
+        // element k = column * 4 + row
+        for (int row = 0; row < 3; row++)
+        {
+            data.rows[row] = glm::vec4(models.m[row][i], models.m[4 + row][i], models.m[8 + row][i],
+                                       models.m[12 + row][i]);
+        }
+        data.params = params != nullptr ? params[i] : glm::vec4(0.0f);
+    }
+}
+
+const std::vector<InstanceStream::Batch> &InstanceStream::Upload()
+{
+    mBatches.clear();
+    if (mDropped > 0)
+    {
+        RC_WARN("instance stream full, {} instances dropped", mDropped);
+    }
+    if (mStaging.empty() || mMapped == nullptr)
+    {
+        return mBatches;
+    }
+
+    uint32_t maxId = 0;
+    for (auto id : mBatchIds)
+    {
+        maxId = id > maxId ? id : maxId;
+    }
+    mOffsets.assign(maxId + 1, 0);
+    for (auto id : mBatchIds)
+    {
+        mOffsets[id]++;
+    }
+
+    uint32_t first = 0;
+    for (uint32_t id = 0; id <= maxId; id++)
+    {
+        uint32_t count = mOffsets[id];
+        if (count > 0)
+        {
+            mBatches.push_back({id, first, count});
+        }
+        mOffsets[id] = first;
+        first += count;
+    }
+
+    for (size_t i = 0; i < mBatchIds.size(); i++)
+    {
+        mOrder[mOffsets[mBatchIds[i]]++] = static_cast<uint32_t>(i);
+    }
+
+    InstanceData *dst = reinterpret_cast<InstanceData *>(mMapped) + static_cast<size_t>(mSlot) * mMaxInstances;
+    for (size_t i = 0; i < mStaging.size(); i++)
+    {
+        memcpy(dst + i, &mStaging[mOrder[i]], sizeof(InstanceData));
+    }
+    return mBatches;
+}
+
+void InstanceStream::Bind(VkCommandBuffer cmd, uint32_t binding) const
+{
+    VkDeviceSize offset = static_cast<VkDeviceSize>(sizeof(InstanceData)) * mSlot * mMaxInstances;
+    vkCmdBindVertexBuffers(cmd, binding, 1, &mBuffer.buf, &offset);
+}
+
+void InstanceStream::Draw(VkCommandBuffer cmd, const Batch &batch, uint32_t indexCount, uint32_t firstIndex,
+                          int32_t vertexOffset)
+{
+    vkCmdDrawIndexed(cmd, indexCount, batch.instanceCount, firstIndex, vertexOffset, batch.firstInstance);
+}
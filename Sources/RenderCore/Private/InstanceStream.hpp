@@ -0,0 +1,83 @@
+#ifndef VULKAN_CORE_INSTANCE_STREAM_H
+#define VULKAN_CORE_INSTANCE_STREAM_H
+
+#include <vulkan/vulkan.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Resources.hpp"
+#include "TransformBatch.hpp"
+#include "glm/glm.hpp"
+
+// Per-instance vertex input, four vec4 attributes
+struct InstanceData
+{
+    // rows 0..2 of the model matrix, the last row is (0, 0, 0, 1)
+    glm::vec4 rows[3];
+    // free for the material, e.g. tile offset or wave phase
+    glm::vec4 params;
+};
+
+// Per-instance transforms and parameters streamed into a vertex buffer read at instance rate.
+// Instances are added in any order with the id of their batch (one mesh with one material);
+// Upload groups them so each batch is a contiguous range drawn with one vkCmdDrawIndexed. Batch
+// ids index a table sized by the largest id in the frame, so keep them dense, e.g.
+// mesh * materialCount + material, and below MaxBatches.
+// The buffer holds one slot per frame in flight and stays mapped, a frame only writes its own
+// slot. Instanced pipelines use the camera's mvp as view projection, so keep its model identity.
+class InstanceStream
+{
+  public:
+    static const uint32_t MaxBatches = 1u << 16;
+
+    struct Batch
+    {
+        uint32_t id;
+        uint32_t firstInstance;
+        uint32_t instanceCount;
+    };
+
+    InstanceStream();
+
+    void Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, uint32_t maxInstances,
+              uint32_t framesInFlight);
+    void Destroy();
+
+    // vertex input of instanced pipelines: model rows at firstLocation..firstLocation + 2, params after
+    static VkVertexInputBindingDescription GetBindingDescription(uint32_t binding);
+    static void GetAttributeDescriptions(uint32_t binding, uint32_t firstLocation,
+                                         VkVertexInputAttributeDescription attributes[4]);
+
+    // starts collecting the instances of frameIndex, batches of the slot's previous frame are dropped
+    void BeginFrame(uint32_t frameIndex);
+    void Add(uint32_t batch, const glm::mat4 &model, const glm::vec4 &params);
+    // count models from a TransformBatch array, params may be null for zeros
+    void Add(uint32_t batch, const Mat4SoA &models, const glm::vec4 *params, size_t count);
+
+    // writes the frame's instances grouped by batch, returns the non-empty batches by ascending id
+    const std::vector<Batch> &Upload();
+    // bind once per frame, the batches address their range through firstInstance
+    void Bind(VkCommandBuffer cmd, uint32_t binding) const;
+    static void Draw(VkCommandBuffer cmd, const Batch &batch, uint32_t indexCount, uint32_t firstIndex,
+                     int32_t vertexOffset);
+
+  private:
+    VkDevice mDevice;
+    BufferResource mBuffer;
+    uint8_t *mMapped;
+    uint32_t mMaxInstances;
+    uint32_t mFramesInFlight;
+    uint32_t mSlot;
+    size_t mDropped;
+
+    std::vector<uint32_t> mBatchIds;
+    std::vector<InstanceData> mStaging;
+    // counting sort by batch id, writes to mapped memory stay sequential
+    std::vector<uint32_t> mOffsets;
+    std::vector<uint32_t> mOrder;
+    std::vector<Batch> mBatches;
+};
+
+#endif // VULKAN_CORE_INSTANCE_STREAM_H
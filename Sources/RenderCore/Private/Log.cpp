@@ -0,0 +1,35 @@
+#include "Log.hpp"
+
+#include "spdlog/async.h"
+#include "spdlog/sinks/stdout_color_sinks.h"
+
+static const size_t LogQueueSize = 8192;
+
+static std::shared_ptr<spdlog::logger> CreateRenderCoreLogger()
+{
+    // share the global pool so spdlog::shutdown() drains our queue as well
+    if (!spdlog::thread_pool())
+    {
+        spdlog::init_thread_pool(LogQueueSize, 1);
+    }
+
+    auto sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::async_logger>("RenderCore", sink, spdlog::thread_pool(),
+                                                         spdlog::async_overflow_policy::overrun_oldest);
+    // filtering happens at compile time through SPDLOG_ACTIVE_LEVEL
+    logger->set_level(spdlog::level::trace);
+    logger->flush_on(spdlog::level::err);
+    spdlog::register_logger(logger);
+    return logger;
+}
+
+spdlog::logger *RenderCoreLogger()
+{
+    static std::shared_ptr<spdlog::logger> logger = CreateRenderCoreLogger();
+    return logger.get();
+}
+
+void ShutdownRenderCoreLog()
+{
+    spdlog::shutdown();
+}
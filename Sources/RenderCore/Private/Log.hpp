@@ -0,0 +1,21 @@
+#ifndef VULKAN_CORE_LOG_H
+#define VULKAN_CORE_LOG_H
+
+// SPDLOG_ACTIVE_LEVEL comes from the build, calls below it compile to nothing
+#include "spdlog/spdlog.h"
+
+// RenderCore's logger. Messages are queued to spdlog's thread pool and formatted there,
+// the queue overwrites the oldest entries instead of blocking the caller when it is full.
+spdlog::logger *RenderCoreLogger();
+
+// drain the queue, used before the process exits on a fatal error
+void ShutdownRenderCoreLog();
+
+#define RC_TRACE(...) SPDLOG_LOGGER_TRACE(RenderCoreLogger(), __VA_ARGS__)
+#define RC_DEBUG(...) SPDLOG_LOGGER_DEBUG(RenderCoreLogger(), __VA_ARGS__)
+#define RC_INFO(...) SPDLOG_LOGGER_INFO(RenderCoreLogger(), __VA_ARGS__)
+#define RC_WARN(...) SPDLOG_LOGGER_WARN(RenderCoreLogger(), __VA_ARGS__)
+#define RC_ERROR(...) SPDLOG_LOGGER_ERROR(RenderCoreLogger(), __VA_ARGS__)
+#define RC_CRITICAL(...) SPDLOG_LOGGER_CRITICAL(RenderCoreLogger(), __VA_ARGS__)
+
+#endif // VULKAN_CORE_LOG_H
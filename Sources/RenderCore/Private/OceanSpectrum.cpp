@@ -0,0 +1,135 @@
+#include "OceanSpectrum.hpp"
+
+#include <assert.h>
+#include <math.h>
+
+static const float Pi = 3.14159265358979f;
+
+// Wavenumber where cascade takes over from the previous one. A band starts at waves a quarter of
+// its patch long, so no wave repeats visibly with the patch, and never past the previous
+// cascade's Nyquist limit so the bands stay contiguous.
+static float LowerBand(const OceanSettings &settings, uint32_t cascade)
+{
+    if (cascade == 0)
+    {
+        return 0.0f;
+    }
+    float lower = 8.0f * Pi / settings.patchSize[cascade];
+    float nyquist = Pi * settings.size / settings.patchSize[cascade - 1];
+    return lower < nyquist ? lower : nyquist;
+}
+
+// Stateless generator so every texel draws the same numbers whatever order it is filled in
+static uint32_t Hash(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// two independent standard normal samples, Box-Muller
+static glm::vec2 Gaussian(uint32_t seed, uint32_t cascade, uint32_t texel)
+{
+    uint32_t a = Hash(seed ^ Hash(cascade * 0x9e3779b9u ^ Hash(texel)));
+    uint32_t b = Hash(a ^ 0x68e31da4u);
+    // (0, 1], log stays finite
+    float u1 = ((a >> 8) + 1) * (1.0f / 16777216.0f);
+    float u2 = (b >> 8) * (1.0f / 16777216.0f);
+    float r = sqrtf(-2.0f * logf(u1));
+    return glm::vec2(r * cosf(2.0f * Pi * u2), r * sinf(2.0f * Pi * u2));
+}
+
+// Directional spreading normalized over the circle, waves only travel downwind
+static float Spreading(float cosTheta)
+{
+    return cosTheta > 0.0f ? 2.0f / Pi * cosTheta * cosTheta : 0.0f;
+}
+
+// Variance density per unit area of wavenumber space, before directional spreading
+static float Density(const OceanSettings &settings, float k)
+{
+    const float g = settings.gravity;
+    const float u = settings.windSpeed;
+    if (settings.spectrum == OceanSpectrumType::Phillips)
+    {
+        // alpha / 2 k^-4 integrates to the alpha / 2 k^-3 saturation range, the exponentials
+        // cut waves longer than the wind can sustain and shorter than a few millimeters
+        const float alpha = 0.0081f;
+        float longest = u * u / g;
+        float shortest = longest * 0.001f;
+        float k2 = k * k;
+        return alpha / 2.0f / (k2 * k2) * expf(-1.0f / (k2 * longest * longest)) * expf(-k2 * shortest * shortest);
+    }
+
+    // JONSWAP in angular frequency, Hasselmann et al. 1973, moved to wavenumber with the deep
+    // water dispersion w^2 = g k: S(k) = S(w) dw/dk / k per unit area
+    float fetch = settings.fetch;
+    float alpha = 0.076f * powf(u * u / (fetch * g), 0.22f);
+    float peak = 22.0f * powf(g * g / (u * fetch), 1.0f / 3.0f);
+    float w = sqrtf(g * k);
+    float sigma = w <= peak ? 0.07f : 0.09f;
+    float d = (w - peak) / (sigma * peak);
+    float r = expf(-0.5f * d * d);
+    float ratio = peak / w;
+    float s = alpha * g * g / powf(w, 5.0f) * expf(-1.25f * ratio * ratio * ratio * ratio) *
+              powf(settings.peakEnhancement, r);
+    return s * (g / (2.0f * w)) / k;
+}
+
+void GenerateOceanSpectrum(const OceanSettings &settings, uint32_t cascade, OceanSpectrumTexel *texels)
+{
+    const uint32_t n = settings.size;
+    assert(n >= 16 && n <= 1024 && (n & (n - 1)) == 0);
+    assert(cascade < settings.cascadeCount && settings.cascadeCount <= OceanSettings::MaxCascades);
+
+    const float dk = 2.0f * Pi / settings.patchSize[cascade];
+    const float lower = LowerBand(settings, cascade);
+    const float upper = cascade + 1 < settings.cascadeCount ? LowerBand(settings, cascade + 1) : INFINITY;
+    const float quantum = 2.0f * Pi / settings.loopPeriod;
+    glm::vec2 wind = glm::normalize(settings.windDirection);
+
+    for (uint32_t z = 0; z < n; z++)
+    {
+        for (uint32_t x = 0; x < n; x++)
+        {
+            OceanSpectrumTexel &texel = texels[z * n + x];
+            int32_t mx = x < n / 2 ? static_cast<int32_t>(x) : static_cast<int32_t>(x) - static_cast<int32_t>(n);
+            int32_t mz = z < n / 2 ? static_cast<int32_t>(z) : static_cast<int32_t>(z) - static_cast<int32_t>(n);
+            float kx = mx * dk;
+            float kz = mz * dk;
+            float k = sqrtf(kx * kx + kz * kz);
+
+            float amplitude = 0.0f;
+            if (k > 0.0f && k >= lower && k < upper && x != n / 2 && z != n / 2)
+            {
+                float density = Density(settings, k) * Spreading((kx * wind.x + kz * wind.y) / k);
+                // E|h0|^2 = density dk^2 / 2, h(k, t) and its mirror together carry the band's variance
+                amplitude = settings.amplitude * dk * sqrtf(0.5f * density);
+            }
+            glm::vec2 xi = Gaussian(settings.seed, cascade, z * n + x) * 0.70710678f;
+            float omega = floorf(sqrtf(settings.gravity * k) / quantum) * quantum;
+
+            texel.h0 = glm::vec4(xi * amplitude, 0.0f, 0.0f);
+            texel.k = glm::vec4(kx, kz, omega, k > 0.0f ? 1.0f / k : 0.0f);
+        }
+    }
+
+    for (uint32_t z = 0; z < n; z++)
+    {
+        for (uint32_t x = 0; x < n; x++)
+        {
+            const OceanSpectrumTexel &mirror = texels[((n - z) % n) * n + (n - x) % n];
+            texels[z * n + x].h0.z = mirror.h0.x;
+            texels[z * n + x].h0.w = -mirror.h0.y;
+        }
+    }
+}
+
+float WrapOceanTime(const OceanSettings &settings, double seconds)
+{
+    double period = settings.loopPeriod;
+    return static_cast<float>(seconds - floor(seconds / period) * period);
+}
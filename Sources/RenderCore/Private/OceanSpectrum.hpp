@@ -0,0 +1,76 @@
+#ifndef VULKAN_CORE_OCEAN_SPECTRUM_H
+#define VULKAN_CORE_OCEAN_SPECTRUM_H
+
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+
+// Tessendorf style spectral ocean. Each cascade is a periodic patch of size x size cells whose
+// wave amplitudes are drawn once from a wind spectrum; the surface at time t is an inverse FFT of
+// h(k, t) = h0(k) e^(i w t) + conj(h0(-k)) e^(-i w t). Cascades cover disjoint wavenumber bands
+// of the same spectrum, so their displacements add up to one surface: the largest patch carries
+// the swell, the smaller ones the chop without repeating at the scale of the big waves.
+
+enum class OceanSpectrumType
+{
+    // saturation range k^-4, only wind speed and direction
+    Phillips,
+    // fetch limited sea, peaked around the frequency the fetch and wind speed allow
+    Jonswap,
+};
+
+struct OceanSettings
+{
+    static const uint32_t MaxCascades = 4;
+
+    // cells per patch side, a power of two from 16 to 1024
+    uint32_t size = 256;
+    uint32_t cascadeCount = 3;
+    // patch side in meters per cascade, largest first
+    float patchSize[MaxCascades] = {1024.0f, 128.0f, 24.0f, 6.0f};
+
+    OceanSpectrumType spectrum = OceanSpectrumType::Jonswap;
+    // meters per second at 10 m above the surface
+    float windSpeed = 12.0f;
+    // xz, normalized by the generator
+    glm::vec2 windDirection = glm::vec2(1.0f, 0.0f);
+    // meters of open water upwind, Jonswap only
+    float fetch = 300000.0f;
+    // Jonswap peak enhancement
+    float peakEnhancement = 3.3f;
+    // scales every amplitude
+    float amplitude = 1.0f;
+    // horizontal displacement scale, 0 gives a plain heightfield
+    float choppiness = 1.0f;
+    float gravity = 9.81f;
+    // angular frequencies are rounded to multiples of 2 pi / loopPeriod so the surface repeats
+    // exactly and time can be wrapped without losing float precision
+    float loopPeriod = 256.0f;
+    uint32_t seed = 1;
+};
+
+// Initial amplitudes of one wavenumber, layout shared with OceanSpectrum.comp
+struct OceanSpectrumTexel
+{
+    // xy h0(k), zw conj(h0(-k))
+    glm::vec4 h0;
+    // kx, kz, angular frequency, 1 / |k| (0 at k = 0)
+    glm::vec4 k;
+};
+
+static_assert(sizeof(OceanSpectrumTexel) == 32, "OceanSpectrumTexel must match SpectrumTexel in OceanSpectrum.comp");
+
+// Fills size * size texels of cascade in FFT order: texel (m, n) holds kx = 2 pi m' / L and
+// kz = 2 pi n' / L with m' = m for m < size / 2 and m - size above. The Nyquist row and column
+// stay zero so every derived field keeps the symmetry of a real surface.
+void GenerateOceanSpectrum(const OceanSettings &settings, uint32_t cascade, OceanSpectrumTexel *texels);
+
+// time wrapped to the loop period, in double so long sessions keep their precision
+float WrapOceanTime(const OceanSettings &settings, double seconds);
+
+// Eight real fields per cell come out of four complex inverse FFTs, two per transform:
+// (height, dh/dx), (dh/dz, Dx), (Dz, dDx/dx), (dDz/dz, dDx/dz). D is the horizontal displacement
+// before choppiness, D(k) = -i k / |k| h(k).
+static const uint32_t OceanFieldCount = 4;
+
+#endif // VULKAN_CORE_OCEAN_SPECTRUM_H
@@ -0,0 +1,526 @@
+#include "OceanSurface.hpp"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "CpuProfiler.hpp"
+#include "HostAllocator.hpp"
+#include "Log.hpp"
+#include "Utils.hpp"
+
+#ifdef RENDERCORE_SHADERS
+static const uint32_t OceanSurfaceSpirv[] = {
+#include "OceanSurface.vert.inc"
+};
+static const uint32_t OceanPatchSpirv[] = {
+#include "OceanPatch.vert.inc"
+};
+static const uint32_t OceanPatchControlSpirv[] = {
+#include "OceanSurface.tesc.inc"
+};
+static const uint32_t OceanPatchEvaluationSpirv[] = {
+#include "OceanSurface.tese.inc"
+};
+#endif
+
+// true when the box lies completely behind one of the planes
+static bool BoxOutside(const Frustum &frustum, const glm::vec3 &lo, const glm::vec3 &hi)
+{
+    for (int i = 0; i < 6; i++)
+    {
+        const glm::vec4 &plane = frustum.planes[i];
+        // corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? hi.x : lo.x, plane.y >= 0.0f ? hi.y : lo.y, plane.z >= 0.0f ? hi.z : lo.z);
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static float BoxDistanceSquared(const glm::vec3 &point, const glm::vec3 &lo, const glm::vec3 &hi)
+{
+    float dx = point.x < lo.x ? lo.x - point.x : (point.x > hi.x ? point.x - hi.x : 0.0f);
+    float dy = point.y < lo.y ? lo.y - point.y : (point.y > hi.y ? point.y - hi.y : 0.0f);
+    float dz = point.z < lo.z ? lo.z - point.z : (point.z > hi.z ? point.z - hi.z : 0.0f);
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// written once, device local host visible memory is preferred
+static void CreateStaticBuffer(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                               VkBufferUsageFlags usage, const void *data, size_t size, BufferResource &buffer)
+{
+    void *mapped = nullptr;
+    VkResult res = CreateBuffer(device, memoryProperties, size, usage,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, &mapped);
+    PANIC_IF_NOT_SUCCESS(res);
+    memcpy(mapped, data, size);
+    vkUnmapMemory(device, buffer.mem);
+}
+
+OceanSurface::OceanSurface()
+    : mSettings(), mDropped(0), mMode(Mode::Quadtree), mTessellation(false), mStages(VK_SHADER_STAGE_VERTEX_BIT),
+      mDevice(VK_NULL_HANDLE), mFramesInFlight(1), mSlot(0), mMapped(nullptr),
+      mDescLayout(VK_NULL_HANDLE), mDescPool(VK_NULL_HANDLE), mDescSet(VK_NULL_HANDLE)
+{
+    for (BufferResource *buffer : {&mVertexBuffer, &mIndexBuffer, &mPatchBuffer, &mTessVertexBuffer, &mTessIndexBuffer})
+    {
+        buffer->buf = VK_NULL_HANDLE;
+        buffer->mem = VK_NULL_HANDLE;
+    }
+    memset(&mConstants, 0, sizeof(mConstants));
+    computeRanges();
+}
+
+void OceanSurface::Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+                        const VkPhysicalDeviceFeatures &enabledFeatures, const Settings &settings,
+                        uint32_t framesInFlight)
+{
+    RC_INFO("OceanSurface::Init {} levels, {}x{} quads per patch", settings.levelCount, settings.gridResolution,
+            settings.gridResolution);
+
+    mDevice = device;
+    mSettings = settings;
+    mFramesInFlight = framesInFlight;
+    computeRanges();
+
+    mTessellation = enabledFeatures.tessellationShader == VK_TRUE;
+    mStages = VK_SHADER_STAGE_VERTEX_BIT;
+    if (mTessellation)
+    {
+        mStages |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        initTessellationGrid(memoryProperties);
+    }
+    else
+    {
+        RC_INFO("tessellation not supported, ocean surface limited to the quadtree");
+    }
+
+    initGrid(memoryProperties);
+    VkResult res = CreateBuffer(mDevice, memoryProperties,
+                                static_cast<VkDeviceSize>(sizeof(OceanPatch)) * mSettings.maxPatches * framesInFlight,
+                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mPatchBuffer, reinterpret_cast<void **>(&mMapped));
+    PANIC_IF_NOT_SUCCESS(res);
+    initDescriptors();
+
+    mPatches.reserve(mSettings.maxPatches);
+    mConstants.eye.w = 1.0f / static_cast<float>(mSettings.gridResolution);
+    mConstants.tessellation = glm::vec4(0.0f, mSettings.tessEdgePixels, mSettings.tessSlopeWeight,
+                                        mSettings.tessMaxFactor);
+    mConstants.tessPatches = glm::vec4(mSettings.tessPatchSize, static_cast<float>(mSettings.tessPatchCount),
+                                       mSettings.maxDisplacement.x, mSettings.maxDisplacement.y);
+}
+
+void OceanSurface::computeRanges()
+{
+    assert(mSettings.levelCount >= 1 && mSettings.levelCount <= MaxLevels);
+    assert(mSettings.morphStart < 1.0f && mSettings.lodRatio * mSettings.morphStart >= 2.83f);
+    assert(mSettings.gridResolution >= 2 && mSettings.gridResolution <= 254 && mSettings.gridResolution % 2 == 0);
+
+    float size = mSettings.leafSize;
+    for (uint32_t level = 0; level < mSettings.levelCount; level++)
+    {
+        mRanges[level] = mSettings.lodRatio * size;
+        size *= 2.0f;
+    }
+
+    // morph over the last part of the band between the finer level's range and this one's; the
+    // roots have no coarser grid to morph into
+    for (uint32_t level = 0; level < mSettings.levelCount; level++)
+    {
+        const float lower = level > 0 ? mRanges[level - 1] : 0.0f;
+        const float end = mRanges[level];
+        const float start = lower + (end - lower) * mSettings.morphStart;
+        if (level + 1 < mSettings.levelCount)
+        {
+            mMorph[level] = glm::vec4(start, 1.0f / (end - start), 0.0f, 0.0f);
+        }
+        else
+        {
+            mMorph[level] = glm::vec4(0.0f);
+        }
+    }
+}
+
+void OceanSurface::initGrid(const VkPhysicalDeviceMemoryProperties &memoryProperties)
+{
+    // vertices are grid coordinates as R16G16_UINT, the shader scales them by the patch size; the
+    // 4 byte stride is the smallest Metal accepts
+    const uint32_t res = mSettings.gridResolution;
+    std::vector<uint16_t> vertices;
+    vertices.reserve((res + 1) * (res + 1) * 2);
+    for (uint32_t y = 0; y <= res; y++)
+    {
+        for (uint32_t x = 0; x <= res; x++)
+        {
+            vertices.push_back(static_cast<uint16_t>(x));
+            vertices.push_back(static_cast<uint16_t>(y));
+        }
+    }
+
+    // every quad split along the same diagonal, so a fully morphed patch is the coarser level's mesh
+    std::vector<uint16_t> indices;
+    indices.reserve(GetIndexCount());
+    for (uint32_t y = 0; y < res; y++)
+    {
+        for (uint32_t x = 0; x < res; x++)
+        {
+            uint16_t i00 = static_cast<uint16_t>(y * (res + 1) + x);
+            uint16_t i10 = static_cast<uint16_t>(i00 + 1);
+            uint16_t i01 = static_cast<uint16_t>(i00 + res + 1);
+            uint16_t i11 = static_cast<uint16_t>(i01 + 1);
+            uint16_t quad[6] = {i00, i01, i11, i00, i11, i10};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    CreateStaticBuffer(mDevice, memoryProperties, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(),
+                       vertices.size() * sizeof(uint16_t), mVertexBuffer);
+    CreateStaticBuffer(mDevice, memoryProperties, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(),
+                       indices.size() * sizeof(uint16_t), mIndexBuffer);
+}
+
+void OceanSurface::initTessellationGrid(const VkPhysicalDeviceMemoryProperties &memoryProperties)
+{
+    assert(mSettings.tessMaxFactor >= 1.0f && mSettings.tessMaxFactor <= 64.0f);
+
+    // corners in patch units as R16G16_UINT, the patch vertex shader centers them on the camera
+    const uint32_t count = mSettings.tessPatchCount;
+    assert(count < 65536);
+    std::vector<uint16_t> vertices;
+    vertices.reserve((count + 1) * (count + 1) * 2);
+    for (uint32_t y = 0; y <= count; y++)
+    {
+        for (uint32_t x = 0; x <= count; x++)
+        {
+            vertices.push_back(static_cast<uint16_t>(x));
+            vertices.push_back(static_cast<uint16_t>(y));
+        }
+    }
+
+    // control points (0, 0), (1, 0), (1, 1), (0, 1) of the domain, u along x and v along z
+    std::vector<uint32_t> indices;
+    indices.reserve(count * count * 4);
+    for (uint32_t y = 0; y < count; y++)
+    {
+        for (uint32_t x = 0; x < count; x++)
+        {
+            uint32_t i00 = y * (count + 1) + x;
+            uint32_t patch[4] = {i00, i00 + 1, i00 + count + 2, i00 + count + 1};
+            indices.insert(indices.end(), patch, patch + 4);
+        }
+    }
+
+    CreateStaticBuffer(mDevice, memoryProperties, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertices.data(),
+                       vertices.size() * sizeof(uint16_t), mTessVertexBuffer);
+    CreateStaticBuffer(mDevice, memoryProperties, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indices.data(),
+                       indices.size() * sizeof(uint32_t), mTessIndexBuffer);
+}
+
+void OceanSurface::initDescriptors()
+{
+    // displacement map, normal map
+    VkDescriptorSetLayoutBinding layoutBindings[2];
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        layoutBindings[i].binding = i;
+        layoutBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        layoutBindings[i].descriptorCount = 1;
+        layoutBindings[i].stageFlags = mStages | VK_SHADER_STAGE_FRAGMENT_BIT;
+        layoutBindings[i].pImmutableSamplers = nullptr;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descSetLayoutInfo = {};
+    descSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descSetLayoutInfo.pNext = nullptr;
+    descSetLayoutInfo.flags = 0;
+    descSetLayoutInfo.bindingCount = 2;
+    descSetLayoutInfo.pBindings = layoutBindings;
+    VkResult res = vkCreateDescriptorSetLayout(mDevice, &descSetLayoutInfo,
+                                               VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), &mDescLayout);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorPoolSize poolSize;
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = 2;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.pNext = nullptr;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    res = vkCreateDescriptorPool(mDevice, &poolInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL), &mDescPool);
+    PANIC_IF_NOT_SUCCESS(res);
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.descriptorPool = mDescPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &mDescLayout;
+    res = vkAllocateDescriptorSets(mDevice, &allocInfo, &mDescSet);
+    PANIC_IF_NOT_SUCCESS(res);
+}
+
+void OceanSurface::Destroy()
+{
+    if (mDevice == VK_NULL_HANDLE)
+    {
+        return;
+    }
+    // destroying the pool frees the set
+    vkDestroyDescriptorPool(mDevice, mDescPool, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_POOL));
+    vkDestroyDescriptorSetLayout(mDevice, mDescLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+    mDescPool = VK_NULL_HANDLE;
+    mDescLayout = VK_NULL_HANDLE;
+    mDescSet = VK_NULL_HANDLE;
+    DestroyBuffer(mDevice, mVertexBuffer);
+    DestroyBuffer(mDevice, mIndexBuffer);
+    DestroyBuffer(mDevice, mPatchBuffer);
+    if (mTessellation)
+    {
+        DestroyBuffer(mDevice, mTessVertexBuffer);
+        DestroyBuffer(mDevice, mTessIndexBuffer);
+    }
+    mMode = Mode::Quadtree;
+    mMapped = nullptr;
+    mDevice = VK_NULL_HANDLE;
+}
+
+uint32_t OceanSurface::GetBindingDescriptions(Mode mode, VkVertexInputBindingDescription bindings[2])
+{
+    bindings[0].binding = 0;
+    bindings[0].stride = 2 * sizeof(uint16_t);
+    bindings[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    if (mode == Mode::Tessellation)
+    {
+        return 1;
+    }
+    bindings[1].binding = 1;
+    bindings[1].stride = sizeof(OceanPatch);
+    bindings[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+    return 2;
+}
+
+uint32_t OceanSurface::GetAttributeDescriptions(Mode mode, VkVertexInputAttributeDescription attributes[3])
+{
+    attributes[0].location = 0;
+    attributes[0].binding = 0;
+    attributes[0].format = VK_FORMAT_R16G16_UINT;
+    attributes[0].offset = 0;
+    if (mode == Mode::Tessellation)
+    {
+        return 1;
+    }
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        attributes[1 + i].location = 1 + i;
+        attributes[1 + i].binding = 1;
+        attributes[1 + i].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributes[1 + i].offset = i * sizeof(glm::vec4);
+    }
+    return 3;
+}
+
+VkPushConstantRange OceanSurface::GetPushConstantRange() const
+{
+    VkPushConstantRange range;
+    range.stageFlags = mStages;
+    range.offset = 0;
+    range.size = sizeof(PushConstants);
+    return range;
+}
+
+uint32_t OceanSurface::GetShaders(Mode mode, ShaderCode stages[3])
+{
+#ifdef RENDERCORE_SHADERS
+    if (mode == Mode::Quadtree)
+    {
+        stages[0] = {VK_SHADER_STAGE_VERTEX_BIT, OceanSurfaceSpirv, sizeof(OceanSurfaceSpirv)};
+        return 1;
+    }
+    stages[0] = {VK_SHADER_STAGE_VERTEX_BIT, OceanPatchSpirv, sizeof(OceanPatchSpirv)};
+    stages[1] = {VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, OceanPatchControlSpirv, sizeof(OceanPatchControlSpirv)};
+    stages[2] = {VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, OceanPatchEvaluationSpirv,
+                 sizeof(OceanPatchEvaluationSpirv)};
+    return 3;
+#else
+    (void)mode;
+    (void)stages;
+    return 0;
+#endif
+}
+
+bool OceanSurface::SetMode(Mode mode)
+{
+    if (mode == Mode::Tessellation && !mTessellation)
+    {
+        RC_WARN("tessellation not supported, ocean surface stays on the quadtree");
+        return false;
+    }
+    mMode = mode;
+    return true;
+}
+
+void OceanSurface::SetScreen(const glm::mat4 &projection, float viewportHeight)
+{
+    mConstants.tessellation.x = fabsf(projection[1][1]) * 0.5f * viewportHeight;
+}
+
+void OceanSurface::BindMaps(const GpuOcean &ocean)
+{
+    const OceanSettings &settings = ocean.GetSettings();
+    mConstants.cascadeCount = settings.cascadeCount;
+    for (uint32_t c = 0; c < settings.cascadeCount; c++)
+    {
+        mConstants.cascadeScale[c] = 1.0f / settings.patchSize[c];
+    }
+
+    // GpuOcean keeps its maps in the general layout
+    VkDescriptorImageInfo imageInfos[2];
+    imageInfos[0].sampler = ocean.GetSampler();
+    imageInfos[0].imageView = ocean.GetDisplacementView();
+    imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageInfos[1] = imageInfos[0];
+    imageInfos[1].imageView = ocean.GetNormalView();
+
+    VkWriteDescriptorSet writes[2];
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        writes[i] = {};
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].pNext = nullptr;
+        writes[i].dstSet = mDescSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[i].pImageInfo = &imageInfos[i];
+    }
+    vkUpdateDescriptorSets(mDevice, 2, writes, 0, nullptr);
+}
+
+const std::vector<OceanPatch> &OceanSurface::Select(const Frustum &frustum, const glm::vec3 &eye)
+{
+    CPU_ZONE("OceanSurface::Select");
+
+    mPatches.clear();
+    mDropped = 0;
+
+    // roots of a world aligned grid, every one that may reach into the top level's range
+    const uint32_t top = mSettings.levelCount - 1;
+    const float rootSize = mSettings.leafSize * static_cast<float>(1u << top);
+    const float reach = mRanges[top];
+    const int x0 = static_cast<int>(floorf((eye.x - reach) / rootSize));
+    const int x1 = static_cast<int>(floorf((eye.x + reach) / rootSize));
+    const int z0 = static_cast<int>(floorf((eye.z - reach) / rootSize));
+    const int z1 = static_cast<int>(floorf((eye.z + reach) / rootSize));
+    for (int z = z0; z <= z1; z++)
+    {
+        for (int x = x0; x <= x1; x++)
+        {
+            selectNode(frustum, eye, static_cast<float>(x) * rootSize, static_cast<float>(z) * rootSize, top);
+        }
+    }
+
+    if (mDropped > 0)
+    {
+        RC_WARN("ocean surface full, {} patches dropped", mDropped);
+    }
+    return mPatches;
+}
+
+void OceanSurface::selectNode(const Frustum &frustum, const glm::vec3 &eye, float x, float z, uint32_t level)
+{
+    const float size = mSettings.leafSize * static_cast<float>(1u << level);
+    // lod distances are to the flat patch, the metric of the shader's morph, so the spacing of the
+    // levels does not depend on the waves; culling uses bounds grown by the largest displacement
+    const float distanceSquared = BoxDistanceSquared(eye, glm::vec3(x, 0.0f, z), glm::vec3(x + size, 0.0f, z + size));
+    if (level == mSettings.levelCount - 1 && distanceSquared > mRanges[level] * mRanges[level])
+    {
+        return;
+    }
+    const float grow = mSettings.maxDisplacement.x;
+    const glm::vec3 lo(x - grow, -mSettings.maxDisplacement.y, z - grow);
+    const glm::vec3 hi(x + size + grow, mSettings.maxDisplacement.y, z + size + grow);
+    if (BoxOutside(frustum, lo, hi))
+    {
+        return;
+    }
+
+    if (level > 0 && distanceSquared <= mRanges[level - 1] * mRanges[level - 1])
+    {
+        // children out of their range still get drawn, fully morphed into this level's grid
+        const float half = size * 0.5f;
+        for (uint32_t child = 0; child < 4; child++)
+        {
+            float cx = x + (child & 1 ? half : 0.0f);
+            float cz = z + (child & 2 ? half : 0.0f);
+            selectNode(frustum, eye, cx, cz, level - 1);
+        }
+        return;
+    }
+
+    if (mPatches.size() >= mSettings.maxPatches)
+    {
+        mDropped++;
+        return;
+    }
+
+    OceanPatch patch;
+    patch.placement = glm::vec4(x, z, size, static_cast<float>(level));
+    patch.morph = mMorph[level];
+    mPatches.push_back(patch);
+}
+
+void OceanSurface::Update(uint32_t frameIndex, const Frustum &frustum, const glm::vec3 &eye)
+{
+    mConstants.eye.x = eye.x;
+    mConstants.eye.y = eye.y;
+    mConstants.eye.z = eye.z;
+    if (mMode == Mode::Tessellation)
+    {
+        return;
+    }
+
+    mSlot = frameIndex % mFramesInFlight;
+    Select(frustum, eye);
+    if (mMapped != nullptr)
+    {
+        memcpy(mMapped + static_cast<size_t>(mSlot) * mSettings.maxPatches, mPatches.data(),
+               mPatches.size() * sizeof(OceanPatch));
+    }
+}
+
+void OceanSurface::Draw(VkCommandBuffer cmd, VkPipelineLayout layout) const
+{
+    if (mMode == Mode::Tessellation)
+    {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(cmd, 0, 1, &mTessVertexBuffer.buf, &offset);
+        vkCmdBindIndexBuffer(cmd, mTessIndexBuffer.buf, 0, VK_INDEX_TYPE_UINT32);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &mDescSet, 0, nullptr);
+        vkCmdPushConstants(cmd, layout, mStages, 0, sizeof(mConstants), &mConstants);
+        vkCmdDrawIndexed(cmd, mSettings.tessPatchCount * mSettings.tessPatchCount * 4, 1, 0, 0, 0);
+        return;
+    }
+
+    if (mPatches.empty())
+    {
+        return;
+    }
+    VkBuffer buffers[2] = {mVertexBuffer.buf, mPatchBuffer.buf};
+    VkDeviceSize offsets[2] = {0, static_cast<VkDeviceSize>(sizeof(OceanPatch)) * mSlot * mSettings.maxPatches};
+    vkCmdBindVertexBuffers(cmd, 0, 2, buffers, offsets);
+    vkCmdBindIndexBuffer(cmd, mIndexBuffer.buf, 0, VK_INDEX_TYPE_UINT16);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &mDescSet, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, mStages, 0, sizeof(mConstants), &mConstants);
+    vkCmdDrawIndexed(cmd, GetIndexCount(), static_cast<uint32_t>(mPatches.size()), 0, 0, 0);
+}
@@ -0,0 +1,197 @@
+#ifndef VULKAN_CORE_OCEAN_SURFACE_H
+#define VULKAN_CORE_OCEAN_SURFACE_H
+
+#include <vulkan/vulkan.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "FrustumCuller.hpp"
+#include "GpuOcean.hpp"
+#include "Resources.hpp"
+#include "glm/glm.hpp"
+
+// One square patch of the surface, the per-instance input of Shaders/OceanSurface.vert
+struct OceanPatch
+{
+    // x, z of the patch's min corner, side in meters, quadtree level (0 finest)
+    glm::vec4 placement;
+    // distance where morphing towards the next coarser level starts, 1 / length of the morph
+    glm::vec4 morph;
+};
+
+static_assert(sizeof(OceanPatch) == 32, "OceanPatch must match the instance inputs of OceanSurface.vert");
+
+// Continuous distance-dependent level of detail (CDLOD, Strugar 2010) for the ocean surface.
+// The plane is tiled by quadtrees whose roots snap to a world grid, a node is split while it
+// intersects the lod range of its children's level, and nodes outside the frustum (bounds grown
+// by the maximum wave displacement) are dropped. Every selected node is one instance of the same
+// grid mesh; the vertex shader moves odd grid vertices onto the coarser grid as the distance
+// approaches the end of the level's range, so neighbouring levels meet without cracks or pops.
+// Patches per level stay about constant, and so does the vertex count wherever the camera is.
+//
+// The Tessellation mode instead draws a fixed grid of coarse patches that follows the camera in
+// whole patch steps. The control shader drops patches outside the view and sets every edge's
+// factor from its projected length and the wave slope around it, so detail goes where it is seen
+// and where the waves are steep, and the cpu does no work per frame. Both modes draw the same
+// displaced surface; the mode can change between frames to compare them.
+//
+// The instance buffer holds one slot per frame in flight, like InstanceStream.
+class OceanSurface
+{
+  public:
+    static const uint32_t MaxLevels = 16;
+
+    enum class Mode
+    {
+        Quadtree,
+        Tessellation,
+    };
+
+    struct ShaderCode
+    {
+        VkShaderStageFlagBits stage;
+        const uint32_t *code;
+        size_t codeSize;
+    };
+
+    struct Settings
+    {
+        // quads per patch side, at most 254 so indices fit 16 bits
+        uint32_t gridResolution = 32;
+        // side of a level 0 patch in meters
+        float leafSize = 16.0f;
+        // levels including the roots, the surface reaches lodRatio * leafSize * 2^(levelCount - 1)
+        uint32_t levelCount = 10;
+        // range of a level over its patch size
+        float lodRatio = 4.0f;
+        // fraction of a level's range band before morphing starts. A vertex a patch shares with a
+        // finer neighbour can lie a parent diagonal, 2 sqrt(2) finer patch sizes, beyond the finer
+        // range; lodRatio * morphStart of at least that keeps it unmorphed on the coarse side.
+        float morphStart = 0.75f;
+        uint32_t maxPatches = 1024;
+        // bounds of the wave displacement: horizontal, vertical (see GpuOcean's maps)
+        glm::vec2 maxDisplacement = glm::vec2(8.0f, 8.0f);
+
+        // Tessellation mode: side of a coarse patch in meters, patches per side of the grid
+        float tessPatchSize = 32.0f;
+        uint32_t tessPatchCount = 128;
+        // target length of a triangle edge in pixels, and how much the wave slope shortens it
+        float tessEdgePixels = 8.0f;
+        float tessSlopeWeight = 4.0f;
+        // at most 64, the smallest maxTessellationGenerationLevel
+        float tessMaxFactor = 64.0f;
+    };
+
+    OceanSurface();
+
+    // the Tessellation mode needs enabledFeatures.tessellationShader
+    void Init(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties,
+              const VkPhysicalDeviceFeatures &enabledFeatures, const Settings &settings, uint32_t framesInFlight);
+    void Destroy();
+
+    Mode GetMode() const
+    {
+        return mMode;
+    }
+    // false, keeping the mode, when the device cannot tessellate
+    bool SetMode(Mode mode);
+    bool IsTessellationSupported() const
+    {
+        return mTessellation;
+    }
+
+    // Quadtree pipelines take the grid at binding 0 (location 0) and the patches at binding 1
+    // (locations 1 and 2). Tessellation pipelines take only binding 0 and location 0, as a patch
+    // list of 4 control points. Grid coordinates are R16G16_UINT integers in both modes, Metal
+    // needs vertex strides in multiples of 4 bytes. Set 1 of both layouts is GetDescriptorSetLayout
+    // and their push constants are GetPushConstantRange. Both return the number of descriptions
+    // written.
+    static uint32_t GetBindingDescriptions(Mode mode, VkVertexInputBindingDescription bindings[2]);
+    static uint32_t GetAttributeDescriptions(Mode mode, VkVertexInputAttributeDescription attributes[3]);
+    VkDescriptorSetLayout GetDescriptorSetLayout() const
+    {
+        return mDescLayout;
+    }
+    VkPushConstantRange GetPushConstantRange() const;
+    // SPIR-V of the stages of mode's pipeline, returns their count, 0 when RenderCore was built
+    // without shaders
+    static uint32_t GetShaders(Mode mode, ShaderCode stages[3]);
+
+    // pixels a unit long edge covers at unit distance, for the tessellation factors; projection as
+    // given to Camera, whose [1][1] is the cotangent of half the vertical field of view
+    void SetScreen(const glm::mat4 &projection, float viewportHeight);
+
+    // points set 1 at the ocean's maps, once after both were initialized
+    void BindMaps(const GpuOcean &ocean);
+
+    // selects the patches of a view; pure cpu work, usable without Init
+    const std::vector<OceanPatch> &Select(const Frustum &frustum, const glm::vec3 &eye);
+    // every frame in both modes; the Quadtree mode also selects and writes the patches into
+    // frameIndex's slot
+    void Update(uint32_t frameIndex, const Frustum &frustum, const glm::vec3 &eye);
+    // inside the render pass with the current mode's pipeline and the camera's set 0 bound
+    void Draw(VkCommandBuffer cmd, VkPipelineLayout layout) const;
+
+    const std::vector<OceanPatch> &GetPatches() const
+    {
+        return mPatches;
+    }
+    uint32_t GetIndexCount() const
+    {
+        return mSettings.gridResolution * mSettings.gridResolution * 6;
+    }
+    float GetRange(uint32_t level) const
+    {
+        return mRanges[level];
+    }
+
+  private:
+    struct PushConstants
+    {
+        // xyz camera position, w meters per grid step of a unit patch (1 / gridResolution)
+        glm::vec4 eye;
+        // 1 / patchSize of every ocean cascade
+        glm::vec4 cascadeScale;
+        // screen scale, target edge pixels, slope weight, max factor
+        glm::vec4 tessellation;
+        // tessellation patch size, patches per side, displacement bounds
+        glm::vec4 tessPatches;
+        uint32_t cascadeCount;
+        uint32_t pad[3];
+    };
+
+    void computeRanges();
+    void selectNode(const Frustum &frustum, const glm::vec3 &eye, float x, float z, uint32_t level);
+    void initGrid(const VkPhysicalDeviceMemoryProperties &memoryProperties);
+    void initTessellationGrid(const VkPhysicalDeviceMemoryProperties &memoryProperties);
+    void initDescriptors();
+
+    Settings mSettings;
+    float mRanges[MaxLevels];
+    glm::vec4 mMorph[MaxLevels];
+    std::vector<OceanPatch> mPatches;
+    uint32_t mDropped;
+
+    Mode mMode;
+    bool mTessellation;
+    VkShaderStageFlags mStages;
+    VkDevice mDevice;
+    uint32_t mFramesInFlight;
+    uint32_t mSlot;
+    PushConstants mConstants;
+
+    BufferResource mVertexBuffer;
+    BufferResource mIndexBuffer;
+    BufferResource mPatchBuffer;
+    BufferResource mTessVertexBuffer;
+    BufferResource mTessIndexBuffer;
+    OceanPatch *mMapped;
+
+    VkDescriptorSetLayout mDescLayout;
+    VkDescriptorPool mDescPool;
+    VkDescriptorSet mDescSet;
+};
+
+#endif // VULKAN_CORE_OCEAN_SURFACE_H
@@ -13,3 +13,19 @@ void RenderCore::Init(void *view)
 {
     rhi->Init(view);
 }
+
+size_t RenderCore::CreateContext(bool shareDevice, const std::string &preferredDevice)
+{
+    contexts.push_back(rhi->CreateContext(shareDevice, preferredDevice));
+    return contexts.size() - 1;
+}
+
+std::shared_ptr<VulkanRHI> RenderCore::GetContext(size_t index) const
+{
+    return index < contexts.size() ? contexts[index] : nullptr;
+}
+
+size_t RenderCore::GetContextCount() const
+{
+    return contexts.size();
+}
@@ -0,0 +1,146 @@
+#include "Resources.hpp"
+
+#include "FlightRecorder.hpp"
+#include "HostAllocator.hpp"
+
+SharedInstance::~SharedInstance()
+{
+    if (inst != VK_NULL_HANDLE)
+    {
+        vkDestroyInstance(inst, VK_ALLOCATOR(VK_OBJECT_TYPE_INSTANCE));
+    }
+}
+
+SharedDevice::~SharedDevice()
+{
+    if (device != VK_NULL_HANDLE)
+    {
+        vkDeviceWaitIdle(device);
+        vkDestroyDevice(device, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE));
+    }
+}
+
+bool FindMemoryType(const VkPhysicalDeviceMemoryProperties &memoryProperties, uint32_t typeBits,
+                    VkMemoryPropertyFlags required, uint32_t *typeIndex)
+{
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+    {
+        if ((typeBits & (1u << i)) != 0 && (memoryProperties.memoryTypes[i].propertyFlags & required) == required)
+        {
+            *typeIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+VkResult CreateBuffer(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize size,
+                      VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+                      BufferResource &buffer, void **mapped)
+{
+    buffer.buf = VK_NULL_HANDLE;
+    buffer.mem = VK_NULL_HANDLE;
+
+    VkBufferCreateInfo bufCreateInfo = {};
+    bufCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufCreateInfo.pNext = nullptr;
+    bufCreateInfo.usage = usage;
+    bufCreateInfo.size = size;
+    bufCreateInfo.queueFamilyIndexCount = 0;
+    bufCreateInfo.pQueueFamilyIndices = nullptr;
+    bufCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bufCreateInfo.flags = 0;
+    VkResult res = vkCreateBuffer(device, &bufCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_BUFFER), &buffer.buf);
+    if (res != VK_SUCCESS)
+    {
+        return res;
+    }
+
+    VkMemoryRequirements memReqs;
+    vkGetBufferMemoryRequirements(device, buffer.buf, &memReqs);
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = nullptr;
+    allocInfo.allocationSize = memReqs.size;
+    if (!FindMemoryType(memoryProperties, memReqs.memoryTypeBits, required | preferred, &allocInfo.memoryTypeIndex) &&
+        !FindMemoryType(memoryProperties, memReqs.memoryTypeBits, required, &allocInfo.memoryTypeIndex))
+    {
+        DestroyBuffer(device, buffer);
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    res = vkAllocateMemory(device, &allocInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY), &buffer.mem);
+    if (res == VK_SUCCESS)
+    {
+        buffer.memSize = allocInfo.allocationSize;
+        FLIGHT_RECORD(FlightEventType::Allocation, allocInfo.memoryTypeIndex, (uint64_t)buffer.mem, buffer.memSize);
+        res = vkBindBufferMemory(device, buffer.buf, buffer.mem, 0);
+    }
+    if (res == VK_SUCCESS && mapped != nullptr)
+    {
+        res = vkMapMemory(device, buffer.mem, 0, VK_WHOLE_SIZE, 0, mapped);
+    }
+    if (res != VK_SUCCESS)
+    {
+        DestroyBuffer(device, buffer);
+        return res;
+    }
+
+    buffer.bufferInfo.buffer = buffer.buf;
+    buffer.bufferInfo.offset = 0;
+    buffer.bufferInfo.range = size;
+    return VK_SUCCESS;
+}
+
+void DestroyBuffer(VkDevice device, BufferResource &buffer)
+{
+    // freeing the memory also unmaps it
+    if (buffer.buf != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(device, buffer.buf, VK_ALLOCATOR(VK_OBJECT_TYPE_BUFFER));
+    }
+    if (buffer.mem != VK_NULL_HANDLE)
+    {
+        FLIGHT_RECORD(FlightEventType::Free, 0, (uint64_t)buffer.mem, buffer.memSize);
+        vkFreeMemory(device, buffer.mem, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY));
+    }
+    buffer.buf = VK_NULL_HANDLE;
+    buffer.mem = VK_NULL_HANDLE;
+}
+
+VkResult CreateComputePipeline(VkDevice device, const uint32_t *code, size_t codeSize, VkPipelineLayout layout,
+                               VkPipeline *pipeline)
+{
+    VkShaderModuleCreateInfo moduleInfo = {};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.pNext = nullptr;
+    moduleInfo.flags = 0;
+    moduleInfo.codeSize = codeSize;
+    moduleInfo.pCode = code;
+    VkShaderModule module;
+    VkResult res = vkCreateShaderModule(device, &moduleInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_SHADER_MODULE), &module);
+    if (res != VK_SUCCESS)
+    {
+        return res;
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.flags = 0;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+    res = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE),
+                                   pipeline);
+    if (res == VK_SUCCESS)
+    {
+        FLIGHT_RECORD(FlightEventType::PipelineCreate, VK_OBJECT_TYPE_PIPELINE, (uint64_t)*pipeline);
+    }
+
+    vkDestroyShaderModule(device, module, VK_ALLOCATOR(VK_OBJECT_TYPE_SHADER_MODULE));
+    return res;
+}
@@ -3,9 +3,13 @@
 
 #include <vulkan/vulkan_core.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 struct ImageResource
 {
-    ImageResource() : format(VK_FORMAT_UNDEFINED)
+    ImageResource() : format(VK_FORMAT_UNDEFINED), memSize(0)
     {
     }
 
@@ -13,13 +17,67 @@ struct ImageResource
 
     VkImage image;
     VkDeviceMemory mem;
+    // allocationSize of mem, recorded with its Free event
+    VkDeviceSize memSize;
     VkImageView view;
 };
 
 struct BufferResource{
     VkBuffer buf;
     VkDeviceMemory mem;
+    // allocationSize of mem, recorded with its Free event
+    VkDeviceSize memSize;
     VkDescriptorBufferInfo bufferInfo;
 };
 
+// first memory type allowed by typeBits that has all of required, false when none does
+bool FindMemoryType(const VkPhysicalDeviceMemoryProperties &memoryProperties, uint32_t typeBits,
+                    VkMemoryPropertyFlags required, uint32_t *typeIndex);
+
+// Buffer with its own allocation, bufferInfo covers all of it. Prefers preferred memory and falls
+// back to required; host visible memory stays mapped to *mapped when mapped is given.
+VkResult CreateBuffer(VkDevice device, const VkPhysicalDeviceMemoryProperties &memoryProperties, VkDeviceSize size,
+                      VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+                      BufferResource &buffer, void **mapped = nullptr);
+void DestroyBuffer(VkDevice device, BufferResource &buffer);
+
+// Compute pipeline of one SPIR-V module with entry point main, the module is released once the
+// pipeline holds it. codeSize is in bytes.
+VkResult CreateComputePipeline(VkDevice device, const uint32_t *code, size_t codeSize, VkPipelineLayout layout,
+                               VkPipeline *pipeline);
+
+// VkInstance owned jointly by every render context created from the same root VulkanRHI
+struct SharedInstance
+{
+    SharedInstance() : inst(VK_NULL_HANDLE)
+    {
+    }
+    ~SharedInstance();
+
+    VkInstance inst;
+};
+
+// VkDevice owned jointly by the contexts that share it. The device is created with every
+// queue of the graphics family, contexts take them round-robin and lock the queue on submit
+struct SharedDevice
+{
+    SharedDevice() : device(VK_NULL_HANDLE), gpu(VK_NULL_HANDLE), queueFamilyIndex(0), queueCount(0), nextQueue(0)
+    {
+    }
+    ~SharedDevice();
+
+    uint32_t AcquireQueueIndex()
+    {
+        return nextQueue.fetch_add(1) % queueCount;
+    }
+
+    std::shared_ptr<SharedInstance> instance;
+    VkDevice device;
+    VkPhysicalDevice gpu;
+    uint32_t queueFamilyIndex;
+    uint32_t queueCount;
+    std::atomic<uint32_t> nextQueue;
+    std::unique_ptr<std::mutex[]> queueMutexes;
+};
+
 #endif // VULKAN_CORE_RESOURCES_H
\ No newline at end of file
@@ -0,0 +1,684 @@
+#include "SceneBvh.hpp"
+
+#include <algorithm>
+#include <assert.h>
+#include <chrono>
+#include <limits>
+
+#include "CpuProfiler.hpp"
+
+static const int BuildBins = 12;
+// a background build starts only when the refitted tree costs this much more than a fresh one
+static const float RebuildCostRatio = 1.2f;
+
+static Aabb Union(const Aabb &a, const Aabb &b)
+{
+    return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+static Aabb EmptyAabb()
+{
+    float big = std::numeric_limits<float>::max();
+    return {glm::vec3(big), glm::vec3(-big)};
+}
+
+// half the surface area, enough for SAH comparisons
+static float Area(const Aabb &box)
+{
+    glm::vec3 d = box.max - box.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static bool Overlaps(const Aabb &a, const Aabb &b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static bool Equal(const Aabb &a, const Aabb &b)
+{
+    return a.min == b.min && a.max == b.max;
+}
+
+SceneBvh::SceneBvh()
+    : mRoot(Null), mObjectCount(0), mStructureVersion(0), mChangesSinceBuild(0), mRebuildThreshold(0.25f),
+      mCostAfterBuild(0.0f)
+{
+}
+
+SceneBvh::~SceneBvh()
+{
+    if (mPendingBuild.valid())
+    {
+        mPendingBuild.wait();
+    }
+}
+
+int32_t SceneBvh::allocateNode()
+{
+    if (!mFreeNodes.empty())
+    {
+        int32_t node = mFreeNodes.back();
+        mFreeNodes.pop_back();
+        return node;
+    }
+    mNodes.push_back(Node());
+    return static_cast<int32_t>(mNodes.size() - 1);
+}
+
+void SceneBvh::freeNode(int32_t node)
+{
+    mNodes[node].parent = Null;
+    mNodes[node].object = Null;
+    mFreeNodes.push_back(node);
+}
+
+uint32_t SceneBvh::Insert(const Aabb &box, uint32_t userData)
+{
+    uint32_t handle;
+    if (!mFreeObjects.empty())
+    {
+        handle = mFreeObjects.back();
+        mFreeObjects.pop_back();
+    }
+    else
+    {
+        handle = static_cast<uint32_t>(mObjects.size());
+        mObjects.push_back(Object());
+    }
+
+    int32_t leaf = allocateNode();
+    Node &node = mNodes[leaf];
+    node.box = box;
+    node.parent = Null;
+    node.left = Null;
+    node.right = Null;
+    node.object = static_cast<int32_t>(handle);
+
+    mObjects[handle] = {box, userData, leaf, false};
+    mObjectCount++;
+    mStructureVersion++;
+    mChangesSinceBuild++;
+    insertLeaf(leaf);
+    return handle;
+}
+
+void SceneBvh::Remove(uint32_t handle)
+{
+    Object &object = mObjects[handle];
+    assert(object.leaf != Null);
+    removeLeaf(object.leaf);
+    freeNode(object.leaf);
+    object.leaf = Null;
+    object.dirty = false;
+    mFreeObjects.push_back(handle);
+    mObjectCount--;
+    mStructureVersion++;
+    mChangesSinceBuild++;
+}
+
+void SceneBvh::Update(uint32_t handle, const Aabb &box)
+{
+    Object &object = mObjects[handle];
+    assert(object.leaf != Null);
+    object.box = box;
+    if (!object.dirty)
+    {
+        object.dirty = true;
+        mDirtyObjects.push_back(handle);
+        mChangesSinceBuild++;
+    }
+}
+
+// Picks the sibling with the lowest added surface area, descending while a child can still be
+// cheaper than stopping at the current node (the branch and bound of incremental insertion).
+void SceneBvh::insertLeaf(int32_t leaf)
+{
+    if (mRoot == Null)
+    {
+        mRoot = leaf;
+        mNodes[leaf].parent = Null;
+        return;
+    }
+
+    Aabb box = mNodes[leaf].box;
+    int32_t sibling = mRoot;
+    while (mNodes[sibling].object == Null)
+    {
+        const Node &node = mNodes[sibling];
+        float area = Area(node.box);
+        float combined = Area(Union(node.box, box));
+        // making a new parent here costs the combined area, going further down also grows this node
+        float cost = 2.0f * combined;
+        float inheritance = 2.0f * (combined - area);
+
+        float childCost[2];
+        int32_t children[2] = {node.left, node.right};
+        for (int i = 0; i < 2; i++)
+        {
+            const Node &child = mNodes[children[i]];
+            float grown = Area(Union(child.box, box));
+            childCost[i] = (child.object != Null ? grown : grown - Area(child.box)) + inheritance;
+        }
+
+        if (cost < childCost[0] && cost < childCost[1])
+        {
+            break;
+        }
+        sibling = childCost[0] < childCost[1] ? children[0] : children[1];
+    }
+
+    int32_t oldParent = mNodes[sibling].parent;
+    int32_t parent = allocateNode();
+    Node &newParent = mNodes[parent];
+    newParent.parent = oldParent;
+    newParent.box = Union(box, mNodes[sibling].box);
+    newParent.left = sibling;
+    newParent.right = leaf;
+    newParent.object = Null;
+    mNodes[sibling].parent = parent;
+    mNodes[leaf].parent = parent;
+
+    if (oldParent == Null)
+    {
+        mRoot = parent;
+    }
+    else if (mNodes[oldParent].left == sibling)
+    {
+        mNodes[oldParent].left = parent;
+    }
+    else
+    {
+        mNodes[oldParent].right = parent;
+    }
+    refitUpwards(oldParent);
+}
+
+void SceneBvh::removeLeaf(int32_t leaf)
+{
+    if (leaf == mRoot)
+    {
+        mRoot = Null;
+        return;
+    }
+
+    int32_t parent = mNodes[leaf].parent;
+    int32_t grandParent = mNodes[parent].parent;
+    int32_t sibling = mNodes[parent].left == leaf ? mNodes[parent].right : mNodes[parent].left;
+
+    if (grandParent == Null)
+    {
+        mRoot = sibling;
+        mNodes[sibling].parent = Null;
+    }
+    else
+    {
+        if (mNodes[grandParent].left == parent)
+        {
+            mNodes[grandParent].left = sibling;
+        }
+        else
+        {
+            mNodes[grandParent].right = sibling;
+        }
+        mNodes[sibling].parent = grandParent;
+        refitUpwards(grandParent);
+    }
+    freeNode(parent);
+}
+
+// stops as soon as a node's box does not change, its ancestors are then already tight
+void SceneBvh::refitUpwards(int32_t node)
+{
+    while (node != Null)
+    {
+        Node &current = mNodes[node];
+        Aabb box = Union(mNodes[current.left].box, mNodes[current.right].box);
+        if (Equal(box, current.box))
+        {
+            return;
+        }
+        current.box = box;
+        node = current.parent;
+    }
+}
+
+void SceneBvh::Refit()
+{
+    for (uint32_t handle : mDirtyObjects)
+    {
+        Object &object = mObjects[handle];
+        if (!object.dirty)
+        {
+            continue;
+        }
+        object.dirty = false;
+        mNodes[object.leaf].box = object.box;
+        refitUpwards(mNodes[object.leaf].parent);
+    }
+    mDirtyObjects.clear();
+}
+
+void SceneBvh::SetRebuildThreshold(float fraction)
+{
+    mRebuildThreshold = fraction;
+}
+
+float SceneBvh::GetSahCost() const
+{
+    if (mRoot == Null || mNodes[mRoot].object != Null)
+    {
+        return 0.0f;
+    }
+
+    float internal = 0.0f;
+    std::vector<int32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+        if (node.object == Null)
+        {
+            internal += Area(node.box);
+            stack.push_back(node.left);
+            stack.push_back(node.right);
+        }
+    }
+    float rootArea = Area(mNodes[mRoot].box);
+    return rootArea > 0.0f ? internal / rootArea : 0.0f;
+}
+
+void SceneBvh::Maintain()
+{
+    CPU_ZONE("SceneBvh::Maintain");
+    Refit();
+
+    if (mPendingBuild.valid())
+    {
+        if (mPendingBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return;
+        }
+        BuildResult result = mPendingBuild.get();
+        // objects were added or removed while it built, the next evaluation starts over
+        if (result.structureVersion == mStructureVersion)
+        {
+            adopt(result);
+        }
+        return;
+    }
+
+    if (mObjectCount < 2 || mChangesSinceBuild < static_cast<size_t>(mRebuildThreshold * mObjectCount))
+    {
+        return;
+    }
+    mChangesSinceBuild = 0;
+    if (GetSahCost() < mCostAfterBuild * RebuildCostRatio)
+    {
+        return;
+    }
+    mPendingBuild = std::async(std::launch::async, build, snapshot(), mStructureVersion);
+}
+
+void SceneBvh::Rebuild()
+{
+    CPU_ZONE("SceneBvh::Rebuild");
+    if (mPendingBuild.valid())
+    {
+        mPendingBuild.wait();
+        mPendingBuild = std::future<BuildResult>();
+    }
+    Refit();
+    BuildResult result = build(snapshot(), mStructureVersion);
+    adopt(result);
+}
+
+std::vector<SceneBvh::BuildItem> SceneBvh::snapshot() const
+{
+    std::vector<BuildItem> items;
+    items.reserve(mObjectCount);
+    for (size_t i = 0; i < mObjects.size(); i++)
+    {
+        const Object &object = mObjects[i];
+        if (object.leaf != Null)
+        {
+            items.push_back({object.box, (object.box.min + object.box.max) * 0.5f, static_cast<int32_t>(i)});
+        }
+    }
+    return items;
+}
+
+SceneBvh::BuildResult SceneBvh::build(std::vector<BuildItem> items, uint64_t structureVersion)
+{
+    CPU_ZONE("SceneBvh::build");
+    BuildResult result;
+    result.structureVersion = structureVersion;
+    result.root = Null;
+    if (!items.empty())
+    {
+        result.nodes.reserve(items.size() * 2 - 1);
+        result.root = buildRange(result.nodes, items, 0, items.size(), Null);
+    }
+    return result;
+}
+
+// Binned SAH over the centroids of the longest centroid axis. Nodes are emitted in preorder, so
+// every child has a larger index than its parent.
+int32_t SceneBvh::buildRange(std::vector<Node> &nodes, std::vector<BuildItem> &items, size_t begin, size_t end,
+                             int32_t parent)
+{
+    int32_t index = static_cast<int32_t>(nodes.size());
+    nodes.push_back(Node());
+    nodes[index].parent = parent;
+
+    if (end - begin == 1)
+    {
+        nodes[index].box = items[begin].box;
+        nodes[index].left = Null;
+        nodes[index].right = Null;
+        nodes[index].object = items[begin].object;
+        return index;
+    }
+
+    Aabb bounds = EmptyAabb();
+    Aabb centroids = EmptyAabb();
+    for (size_t i = begin; i < end; i++)
+    {
+        bounds = Union(bounds, items[i].box);
+        centroids = Union(centroids, {items[i].centroid, items[i].centroid});
+    }
+    nodes[index].box = bounds;
+    nodes[index].object = Null;
+
+    glm::vec3 extent = centroids.max - centroids.min;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    size_t mid = begin + (end - begin) / 2;
+
+    if (extent[axis] > 0.0f)
+    {
+        Aabb binBoxes[BuildBins];
+        size_t binCounts[BuildBins] = {};
+        for (auto &box : binBoxes)
+        {
+            box = EmptyAabb();
+        }
+        float scale = BuildBins / extent[axis];
+        auto binOf = [&](const BuildItem &item) {
+            int bin = static_cast<int>((item.centroid[axis] - centroids.min[axis]) * scale);
+            return bin < BuildBins ? bin : BuildBins - 1;
+        };
+        for (size_t i = begin; i < end; i++)
+        {
+            int bin = binOf(items[i]);
+            binBoxes[bin] = Union(binBoxes[bin], items[i].box);
+            binCounts[bin]++;
+        }
+
+        // cost of splitting after bin i, swept from both ends
+        float rightCost[BuildBins];
+        Aabb right = EmptyAabb();
+        size_t rightCount = 0;
+        for (int i = BuildBins - 1; i > 0; i--)
+        {
+            right = Union(right, binBoxes[i]);
+            rightCount += binCounts[i];
+            rightCost[i - 1] = rightCount > 0 ? Area(right) * rightCount : 0.0f;
+        }
+        float bestCost = std::numeric_limits<float>::max();
+        int bestSplit = -1;
+        Aabb left = EmptyAabb();
+        size_t leftCount = 0;
+        for (int i = 0; i < BuildBins - 1; i++)
+        {
+            left = Union(left, binBoxes[i]);
+            leftCount += binCounts[i];
+            if (leftCount == 0 || leftCount == end - begin)
+            {
+                continue;
+            }
+            float cost = Area(left) * leftCount + rightCost[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        if (bestSplit >= 0)
+        {
+            auto split = std::partition(items.begin() + begin, items.begin() + end,
+                                        [&](const BuildItem &item) { return binOf(item) <= bestSplit; });
+            mid = static_cast<size_t>(split - items.begin());
+        }
+        else
+        {
+            auto byAxis = [axis](const BuildItem &a, const BuildItem &b) {
+                return a.centroid[axis] < b.centroid[axis];
+            };
+            std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end, byAxis);
+        }
+    }
+
+    int32_t leftChild = buildRange(nodes, items, begin, mid, index);
+    int32_t rightChild = buildRange(nodes, items, mid, end, index);
+    nodes[index].left = leftChild;
+    nodes[index].right = rightChild;
+    return index;
+}
+
+void SceneBvh::adopt(BuildResult &result)
+{
+    mNodes.swap(result.nodes);
+    mRoot = result.root;
+    mFreeNodes.clear();
+
+    // objects that moved while the build ran: take their current boxes and refit bottom up,
+    // which preorder makes a reverse sweep
+    for (auto &node : mNodes)
+    {
+        if (node.object != Null)
+        {
+            Object &object = mObjects[node.object];
+            object.leaf = static_cast<int32_t>(&node - mNodes.data());
+            object.dirty = false;
+            node.box = object.box;
+        }
+    }
+    mDirtyObjects.clear();
+    for (size_t i = mNodes.size(); i-- > 0;)
+    {
+        Node &node = mNodes[i];
+        if (node.object == Null)
+        {
+            node.box = Union(mNodes[node.left].box, mNodes[node.right].box);
+        }
+    }
+
+    mChangesSinceBuild = 0;
+    mCostAfterBuild = GetSahCost();
+}
+
+void SceneBvh::collectLeaves(int32_t node, std::vector<uint32_t> &out) const
+{
+    std::vector<int32_t> stack(1, node);
+    while (!stack.empty())
+    {
+        const Node &current = mNodes[stack.back()];
+        stack.pop_back();
+        if (current.object != Null)
+        {
+            out.push_back(mObjects[current.object].userData);
+        }
+        else
+        {
+            stack.push_back(current.left);
+            stack.push_back(current.right);
+        }
+    }
+}
+
+void SceneBvh::QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &out) const
+{
+    CPU_ZONE("SceneBvh::QueryFrustum");
+    if (mRoot == Null)
+    {
+        return;
+    }
+
+    std::vector<int32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        int32_t index = stack.back();
+        stack.pop_back();
+        const Node &node = mNodes[index];
+
+        glm::vec3 center = (node.box.min + node.box.max) * 0.5f;
+        glm::vec3 extent = (node.box.max - node.box.min) * 0.5f;
+        bool inside = true;
+        bool outside = false;
+        for (const glm::vec4 &plane : frustum.planes)
+        {
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius = glm::abs(plane.x) * extent.x + glm::abs(plane.y) * extent.y + glm::abs(plane.z) * extent.z;
+            if (distance < -radius)
+            {
+                outside = true;
+                break;
+            }
+            inside = inside && distance >= radius;
+        }
+
+        if (outside)
+        {
+            continue;
+        }
+        // a subtree fully inside needs no further plane tests
+        if (inside || node.object != Null)
+        {
+            collectLeaves(index, out);
+            continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+void SceneBvh::QueryOverlap(const Aabb &box, std::vector<uint32_t> &out) const
+{
+    if (mRoot == Null)
+    {
+        return;
+    }
+
+    std::vector<int32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+        if (!Overlaps(node.box, box))
+        {
+            continue;
+        }
+        if (node.object != Null)
+        {
+            out.push_back(mObjects[node.object].userData);
+            continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+void SceneBvh::QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &out) const
+{
+    if (mRoot == Null)
+    {
+        return;
+    }
+
+    float radiusSquared = radius * radius;
+    std::vector<int32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+        glm::vec3 closest = glm::clamp(center, node.box.min, node.box.max);
+        glm::vec3 delta = closest - center;
+        if (glm::dot(delta, delta) > radiusSquared)
+        {
+            continue;
+        }
+        if (node.object != Null)
+        {
+            out.push_back(mObjects[node.object].userData);
+            continue;
+        }
+        stack.push_back(node.left);
+        stack.push_back(node.right);
+    }
+}
+
+// slab test, returns the entry distance or a negative value on a miss
+static float IntersectRay(const Aabb &box, const glm::vec3 &origin, const glm::vec3 &inverseDirection,
+                          float maxDistance)
+{
+    glm::vec3 t0 = (box.min - origin) * inverseDirection;
+    glm::vec3 t1 = (box.max - origin) * inverseDirection;
+    glm::vec3 near = glm::min(t0, t1);
+    glm::vec3 far = glm::max(t0, t1);
+    float enter = glm::max(glm::max(near.x, near.y), glm::max(near.z, 0.0f));
+    float exit = glm::min(glm::min(far.x, far.y), glm::min(far.z, maxDistance));
+    return enter <= exit ? enter : -1.0f;
+}
+
+RayHit SceneBvh::Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const
+{
+    RayHit result = {0, maxDistance, false};
+    if (mRoot == Null)
+    {
+        return result;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    std::vector<int32_t> stack(1, mRoot);
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+        float distance = IntersectRay(node.box, origin, inverseDirection, result.distance);
+        if (distance < 0.0f)
+        {
+            continue;
+        }
+        if (node.object != Null)
+        {
+            result = {mObjects[node.object].userData, distance, true};
+            continue;
+        }
+
+        // visit the nearer child first so it can shrink the search distance for the other
+        float leftDistance = IntersectRay(mNodes[node.left].box, origin, inverseDirection, result.distance);
+        float rightDistance = IntersectRay(mNodes[node.right].box, origin, inverseDirection, result.distance);
+        bool leftFirst = leftDistance >= 0.0f && (rightDistance < 0.0f || leftDistance <= rightDistance);
+        if (leftFirst)
+        {
+            if (rightDistance >= 0.0f)
+            {
+                stack.push_back(node.right);
+            }
+            stack.push_back(node.left);
+        }
+        else
+        {
+            if (leftDistance >= 0.0f)
+            {
+                stack.push_back(node.left);
+            }
+            if (rightDistance >= 0.0f)
+            {
+                stack.push_back(node.right);
+            }
+        }
+    }
+    return result;
+}
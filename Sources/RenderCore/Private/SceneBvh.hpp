@@ -0,0 +1,133 @@
+#ifndef VULKAN_CORE_SCENE_BVH_H
+#define VULKAN_CORE_SCENE_BVH_H
+
+#include "FrustumCuller.hpp"
+#include "glm/glm.hpp"
+
+#include <future>
+#include <stdint.h>
+#include <vector>
+
+struct Aabb
+{
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct RayHit
+{
+    uint32_t userData;
+    float distance;
+    bool hit;
+};
+
+// Dynamic bounding volume hierarchy over scene objects, one object per leaf. Inserts and
+// removes keep the tree valid immediately; moving objects only mark their leaf and Refit
+// tightens the ancestors of everything that moved. Refits loosen the tree over time, so
+// Maintain periodically rebuilds it with binned SAH on a background thread and swaps the result
+// in on a later call. Not thread safe: use one thread, the background build only reads a snapshot.
+class SceneBvh
+{
+  public:
+    SceneBvh();
+    ~SceneBvh();
+
+    // returns a handle that stays valid until Remove
+    uint32_t Insert(const Aabb &box, uint32_t userData);
+    void Remove(uint32_t handle);
+    // new bounds for a moving object, applied to the tree by the next Refit
+    void Update(uint32_t handle, const Aabb &box);
+
+    // refit everything moved since the last call
+    void Refit();
+    // once per frame: refit, adopt a finished background build and start a new one when enough
+    // changed and the tree got noticeably worse than right after its last build
+    void Maintain();
+    // synchronous SAH rebuild
+    void Rebuild();
+
+    // fraction of the objects that must change before Maintain evaluates the tree, 0.25 by default
+    void SetRebuildThreshold(float fraction);
+
+    size_t GetObjectCount() const
+    {
+        return mObjectCount;
+    }
+    // sum of internal node surface areas over the root's, lower is better
+    float GetSahCost() const;
+
+    // user data of objects whose box intersects the frustum, appended to out
+    void QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &out) const;
+    void QueryOverlap(const Aabb &box, std::vector<uint32_t> &out) const;
+    void QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &out) const;
+    // nearest object box along the ray, direction does not need to be normalized for the hit
+    // but distance is in units of its length
+    RayHit Raycast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const;
+
+  private:
+    static const int32_t Null = -1;
+
+    struct Node
+    {
+        Aabb box;
+        int32_t parent;
+        int32_t left;
+        int32_t right;
+        // object handle for leaves, Null for internal nodes
+        int32_t object;
+    };
+
+    struct Object
+    {
+        Aabb box;
+        uint32_t userData;
+        int32_t leaf;
+        bool dirty;
+    };
+
+    struct BuildItem
+    {
+        Aabb box;
+        glm::vec3 centroid;
+        int32_t object;
+    };
+
+    struct BuildResult
+    {
+        std::vector<Node> nodes;
+        int32_t root;
+        uint64_t structureVersion;
+    };
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    void refitUpwards(int32_t node);
+
+    std::vector<BuildItem> snapshot() const;
+    static BuildResult build(std::vector<BuildItem> items, uint64_t structureVersion);
+    static int32_t buildRange(std::vector<Node> &nodes, std::vector<BuildItem> &items, size_t begin, size_t end,
+                              int32_t parent);
+    void adopt(BuildResult &result);
+
+    void collectLeaves(int32_t node, std::vector<uint32_t> &out) const;
+
+    std::vector<Node> mNodes;
+    std::vector<int32_t> mFreeNodes;
+    int32_t mRoot;
+
+    std::vector<Object> mObjects;
+    std::vector<uint32_t> mFreeObjects;
+    size_t mObjectCount;
+    std::vector<uint32_t> mDirtyObjects;
+
+    // bumped by Insert and Remove, a background build of an older structure is discarded
+    uint64_t mStructureVersion;
+    size_t mChangesSinceBuild;
+    float mRebuildThreshold;
+    float mCostAfterBuild;
+    std::future<BuildResult> mPendingBuild;
+};
+
+#endif // VULKAN_CORE_SCENE_BVH_H
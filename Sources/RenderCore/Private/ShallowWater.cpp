@@ -0,0 +1,321 @@
+#include "ShallowWater.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+#include "CpuProfiler.hpp"
+#include "SimdDispatch.hpp"
+#include "TaskPool.hpp"
+#include "WaterKernels.hpp"
+
+using namespace RENDERCORE_LANES_NAMESPACE;
+
+static SimdDispatch<WaterKernels> sDispatch(MakeWaterKernels<ScalarLanes>, MakeWaterKernels<DefaultLanes>,
+                                            GetAvx2WaterKernels, GetAvx512WaterKernels);
+
+static const WaterKernels &Kernels()
+{
+    return sDispatch.Get();
+}
+
+// scratch of one tile: three rows of terms, x faces and two rows of y faces
+struct TileScratch
+{
+    std::vector<float> storage;
+    RowTerms rows[3];
+    FaceFlux x;
+    FaceFlux y[2];
+
+    void Reserve(size_t cells)
+    {
+        if (storage.size() >= cells * 33)
+        {
+            return;
+        }
+        storage.resize(cells * 33);
+        float *p = storage.data();
+        for (auto &row : rows)
+        {
+            float **fields[] = {&row.h, &row.hu, &row.hv, &row.fxx, &row.fxy, &row.fyy, &row.ax, &row.ay};
+            for (auto field : fields)
+            {
+                *field = p;
+                p += cells;
+            }
+        }
+        for (FaceFlux *flux : {&x, &y[0], &y[1]})
+        {
+            flux->h = p;
+            flux->hu = p + cells;
+            flux->hv = p + cells * 2;
+            p += cells * 3;
+        }
+    }
+};
+
+static thread_local TileScratch tScratch;
+
+ShallowWater::ShallowWater(uint32_t columns, uint32_t rows, float cellSize, float depth)
+    : mColumns(columns), mRows(rows), mCellSize(cellSize), mGravity(9.81f), mCourant(0.4f), mCurrent(0),
+      mMaxSpeed(0.0f)
+{
+    // ghost columns at -1 and columns, rounded up to whole cache lines
+    mStride = (Pad + columns + 1 + 15) / 16 * 16;
+    mTilesX = (columns + TileWidth - 1) / TileWidth;
+    mTilesY = (rows + TileHeight - 1) / TileHeight;
+    mTileSpeed.resize(static_cast<size_t>(mTilesX) * mTilesY);
+
+    for (int buffer = 0; buffer < 2; buffer++)
+    {
+        mH[buffer] = allocate();
+        mHu[buffer] = allocate();
+        mHv[buffer] = allocate();
+    }
+
+    // first touch from the pool, so pages land near the threads that step them
+    TaskPool::Instance().ParallelFor(static_cast<size_t>(mRows) + 2, 16, [&](size_t begin, size_t end) {
+        for (int buffer = 0; buffer < 2; buffer++)
+        {
+            std::fill(mH[buffer] + begin * mStride, mH[buffer] + end * mStride, depth);
+            std::fill(mHu[buffer] + begin * mStride, mHu[buffer] + end * mStride, 0.0f);
+            std::fill(mHv[buffer] + begin * mStride, mHv[buffer] + end * mStride, 0.0f);
+        }
+    });
+    updateMaxSpeed();
+}
+
+float *ShallowWater::allocate()
+{
+    // left uninitialized, the constructor touches it in parallel
+    size_t count = (static_cast<size_t>(mRows) + 2) * mStride + 16;
+    mStorage.emplace_back(new float[count]);
+    uintptr_t address = reinterpret_cast<uintptr_t>(mStorage.back().get());
+    return reinterpret_cast<float *>((address + 63) & ~static_cast<uintptr_t>(63));
+}
+
+void ShallowWater::SetGravity(float gravity)
+{
+    mGravity = gravity;
+    updateMaxSpeed();
+}
+
+void ShallowWater::SetCourant(float courant)
+{
+    mCourant = courant;
+}
+
+void ShallowWater::AddDrop(float x, float y, float radius, float height)
+{
+    float *h = mH[mCurrent];
+    int64_t reach = static_cast<int64_t>(ceilf(radius * 3.0f));
+    int64_t x0 = std::max<int64_t>(static_cast<int64_t>(x) - reach, 0);
+    int64_t x1 = std::min<int64_t>(static_cast<int64_t>(x) + reach, mColumns - 1);
+    int64_t y0 = std::max<int64_t>(static_cast<int64_t>(y) - reach, 0);
+    int64_t y1 = std::min<int64_t>(static_cast<int64_t>(y) + reach, mRows - 1);
+    float scale = -1.0f / (radius * radius);
+    for (int64_t cy = y0; cy <= y1; cy++)
+    {
+        for (int64_t cx = x0; cx <= x1; cx++)
+        {
+            float dx = cx - x;
+            float dy = cy - y;
+            h[index(cx, cy)] += height * expf((dx * dx + dy * dy) * scale);
+        }
+    }
+    updateMaxSpeed();
+}
+
+float ShallowWater::GetStableTimeStep() const
+{
+    return mMaxSpeed > 0.0f ? mCourant * mCellSize / mMaxSpeed : INFINITY;
+}
+
+uint32_t ShallowWater::Advance(float dt)
+{
+    // the speed is measured on each step's input, so a substep is sized from the state one step
+    // older than the one it advances; the Courant number leaves room for that
+    uint32_t steps = 0;
+    while (dt > 0.0f)
+    {
+        // equal substeps for what is left, the last one consumes dt exactly
+        float step = dt / std::max(ceilf(dt / GetStableTimeStep()), 1.0f);
+        Step(step);
+        dt = dt > step ? dt - step : 0.0f;
+        steps++;
+    }
+    return steps;
+}
+
+void ShallowWater::Step(float dt)
+{
+    CPU_ZONE("ShallowWater::Step");
+    applyBoundaries();
+    TaskPool::Instance().ParallelFor(mTileSpeed.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            stepTile(static_cast<uint32_t>(tile), dt);
+        }
+    });
+    mCurrent ^= 1;
+    mMaxSpeed = *std::max_element(mTileSpeed.begin(), mTileSpeed.end());
+}
+
+void ShallowWater::applyBoundaries()
+{
+    // reflective walls: ghost cells mirror the edge cell with the normal momentum negated
+    float *h = mH[mCurrent];
+    float *hu = mHu[mCurrent];
+    float *hv = mHv[mCurrent];
+    int64_t last = static_cast<int64_t>(mColumns) - 1;
+    for (int64_t y = 0; y < mRows; y++)
+    {
+        size_t ghost = index(-1, y);
+        size_t edge = index(0, y);
+        h[ghost] = h[edge];
+        hu[ghost] = -hu[edge];
+        hv[ghost] = hv[edge];
+        ghost = index(last + 1, y);
+        edge = index(last, y);
+        h[ghost] = h[edge];
+        hu[ghost] = -hu[edge];
+        hv[ghost] = hv[edge];
+    }
+    int64_t bottom = static_cast<int64_t>(mRows) - 1;
+    for (int64_t x = 0; x < mColumns; x++)
+    {
+        size_t ghost = index(x, -1);
+        size_t edge = index(x, 0);
+        h[ghost] = h[edge];
+        hu[ghost] = hu[edge];
+        hv[ghost] = -hv[edge];
+        ghost = index(x, bottom + 1);
+        edge = index(x, bottom);
+        h[ghost] = h[edge];
+        hu[ghost] = hu[edge];
+        hv[ghost] = -hv[edge];
+    }
+}
+
+void ShallowWater::stepTile(uint32_t tile, float dt)
+{
+    int64_t x0 = static_cast<int64_t>(tile % mTilesX) * TileWidth;
+    int64_t y0 = static_cast<int64_t>(tile / mTilesX) * TileHeight;
+    int64_t x1 = std::min<int64_t>(x0 + TileWidth, mColumns);
+    int64_t y1 = std::min<int64_t>(y0 + TileHeight, mRows);
+    size_t width = static_cast<size_t>(x1 - x0);
+
+    const float *h = mH[mCurrent];
+    const float *hu = mHu[mCurrent];
+    const float *hv = mHv[mCurrent];
+    float *nextH = mH[mCurrent ^ 1];
+    float *nextHu = mHu[mCurrent ^ 1];
+    float *nextHv = mHv[mCurrent ^ 1];
+
+    // terms cover the tile's cells plus one neighbor on each side, x faces run from the left
+    // neighbor's right face to the last cell's right face
+    const WaterKernels &kernels = Kernels();
+    TileScratch &scratch = tScratch;
+    scratch.Reserve(TileWidth + 2);
+    RowTerms *above = &scratch.rows[0];
+    RowTerms *row = &scratch.rows[1];
+    RowTerms *below = &scratch.rows[2];
+    FaceFlux *top = &scratch.y[0];
+    FaceFlux *bottom = &scratch.y[1];
+    float r = dt / mCellSize;
+    float speed = 0.0f;
+
+    size_t first = index(x0 - 1, y0 - 1);
+    kernels.computeTerms(h + first, hu + first, hv + first, width + 2, mGravity, *above);
+    first = index(x0 - 1, y0);
+    kernels.computeTerms(h + first, hu + first, hv + first, width + 2, mGravity, *row);
+
+    RowTerms inner;
+    RowTerms innerBelow;
+    auto shift = [](const RowTerms &t) {
+        RowTerms s = {t.h + 1, t.hu + 1, t.hv + 1, t.fxx + 1, t.fxy + 1, t.fyy + 1, t.ax + 1, t.ay + 1};
+        return s;
+    };
+    inner = shift(*row);
+    kernels.fluxY(shift(*above), inner, width, *top);
+
+    for (int64_t y = y0; y < y1; y++)
+    {
+        first = index(x0 - 1, y + 1);
+        kernels.computeTerms(h + first, hu + first, hv + first, width + 2, mGravity, *below);
+        innerBelow = shift(*below);
+        kernels.fluxY(inner, innerBelow, width, *bottom);
+        kernels.fluxX(*row, width + 1, scratch.x);
+
+        size_t out = index(x0, y);
+        kernels.updateRow(inner, scratch.x, *top, *bottom, r, width, nextH + out, nextHu + out, nextHv + out);
+        speed = std::max(speed, kernels.maxSpeed(inner, width));
+
+        std::swap(top, bottom);
+        RowTerms *recycled = above;
+        above = row;
+        row = below;
+        below = recycled;
+        inner = innerBelow;
+    }
+    mTileSpeed[tile] = speed;
+}
+
+void ShallowWater::updateMaxSpeed()
+{
+    float gravity = mGravity;
+    TaskPool::Instance().ParallelFor(mTileSpeed.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t tile = begin; tile < end; tile++)
+        {
+            int64_t x0 = static_cast<int64_t>(tile % mTilesX) * TileWidth;
+            int64_t y0 = static_cast<int64_t>(tile / mTilesX) * TileHeight;
+            int64_t x1 = std::min<int64_t>(x0 + TileWidth, mColumns);
+            int64_t y1 = std::min<int64_t>(y0 + TileHeight, mRows);
+            size_t width = static_cast<size_t>(x1 - x0);
+
+            const WaterKernels &kernels = Kernels();
+            TileScratch &scratch = tScratch;
+            scratch.Reserve(TileWidth + 2);
+            float speed = 0.0f;
+            for (int64_t y = y0; y < y1; y++)
+            {
+                size_t first = index(x0, y);
+                kernels.computeTerms(mH[mCurrent] + first, mHu[mCurrent] + first, mHv[mCurrent] + first, width,
+                                     gravity, scratch.rows[0]);
+                speed = std::max(speed, kernels.maxSpeed(scratch.rows[0], width));
+            }
+            mTileSpeed[tile] = speed;
+        }
+    });
+    mMaxSpeed = *std::max_element(mTileSpeed.begin(), mTileSpeed.end());
+}
+
+SimdIsa ShallowWater::GetIsa()
+{
+    return Kernels().isa;
+}
+
+const char *ShallowWater::GetIsaName()
+{
+    return GetSimdIsaName(GetIsa());
+}
+
+SimdIsa ShallowWater::LimitIsa(SimdIsa isa)
+{
+    return sDispatch.Limit(isa);
+}
+
+double ShallowWater::GetVolume() const
+{
+    double volume = 0.0;
+    for (int64_t y = 0; y < mRows; y++)
+    {
+        const float *h = mH[mCurrent] + index(0, y);
+        double row = 0.0;
+        for (uint32_t x = 0; x < mColumns; x++)
+        {
+            row += h[x];
+        }
+        volume += row;
+    }
+    return volume * mCellSize * mCellSize;
+}
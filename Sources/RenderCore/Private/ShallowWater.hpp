@@ -0,0 +1,109 @@
+#ifndef VULKAN_CORE_SHALLOW_WATER_H
+#define VULKAN_CORE_SHALLOW_WATER_H
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+
+// Shallow water equations on a regular grid, finite volumes with Rusanov fluxes and reflective
+// walls. The state is three structure of arrays grids (h, hu, hv), double buffered, with rows
+// padded so every row and every tile column starts on a cache line. A step reads the current
+// grids and writes the next ones tile by tile, tiles are spread over the TaskPool and never
+// write the same cache line, so the step needs no synchronization besides the final join.
+class ShallowWater
+{
+  public:
+    // instruction set of the row kernels, picked at first use from what the cpu supports; every
+    // one gives the same results as Scalar bit for bit
+    static SimdIsa GetIsa();
+    static const char *GetIsaName();
+    // see SimdDispatch::Limit
+    static SimdIsa LimitIsa(SimdIsa isa);
+
+    // columns x rows cells of cellSize meters, at rest with the given depth
+    ShallowWater(uint32_t columns, uint32_t rows, float cellSize, float depth);
+
+    ShallowWater(const ShallowWater &) = delete;
+    ShallowWater &operator=(const ShallowWater &) = delete;
+
+    void SetGravity(float gravity);
+    // Courant number of the substeps Advance takes, 0.4 by default
+    void SetCourant(float courant);
+
+    // gaussian bump centered on cell (x, y), radius in cells
+    void AddDrop(float x, float y, float radius, float height);
+
+    // advances by dt in as many substeps as the wave speed requires, returns their count
+    uint32_t Advance(float dt);
+    // one explicit step, dt must respect the CFL limit
+    void Step(float dt);
+    // largest stable step for the state before the last step, see Advance
+    float GetStableTimeStep() const;
+
+    uint32_t GetColumns() const
+    {
+        return mColumns;
+    }
+    uint32_t GetRows() const
+    {
+        return mRows;
+    }
+    // water height of cell (0, 0), rows are GetRowStride floats apart
+    const float *GetHeights() const
+    {
+        return mH[mCurrent] + index(0, 0);
+    }
+    size_t GetRowStride() const
+    {
+        return mStride;
+    }
+    float GetHeight(uint32_t x, uint32_t y) const
+    {
+        return mH[mCurrent][index(x, y)];
+    }
+    // sum of h * cell area, constant up to rounding with reflective walls
+    double GetVolume() const;
+
+    // wide tiles keep the row streams long enough for the hardware prefetchers
+    static const uint32_t TileWidth = 512;
+    static const uint32_t TileHeight = 64;
+
+  private:
+    // floats before column 0 of every row, keeps tile columns on cache lines
+    static const size_t Pad = 16;
+
+    size_t index(int64_t x, int64_t y) const
+    {
+        return static_cast<size_t>(y + 1) * mStride + Pad + x;
+    }
+
+    float *allocate();
+    void applyBoundaries();
+    void stepTile(uint32_t tile, float dt);
+    void updateMaxSpeed();
+
+    uint32_t mColumns;
+    uint32_t mRows;
+    float mCellSize;
+    float mGravity;
+    float mCourant;
+    size_t mStride;
+    uint32_t mTilesX;
+    uint32_t mTilesY;
+
+    std::vector<std::unique_ptr<float[]>> mStorage;
+    // [buffer] aligned grids including the ghost border
+    float *mH[2];
+    float *mHu[2];
+    float *mHv[2];
+    uint32_t mCurrent;
+
+    // max |velocity| + sqrt(g h) per tile of the last step's input
+    std::vector<float> mTileSpeed;
+    float mMaxSpeed;
+};
+
+#endif // VULKAN_CORE_SHALLOW_WATER_H
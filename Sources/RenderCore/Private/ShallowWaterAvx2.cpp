@@ -0,0 +1,23 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx2WaterLanes
+
+#include "WaterKernels.hpp"
+
+#if defined(__AVX2__)
+
+const WaterKernels *GetAvx2WaterKernels()
+{
+    static const WaterKernels kernels =
+        Avx2WaterLanes::MakeWaterKernels<Avx2WaterLanes::Avx2Lanes>(SimdIsa::Avx2);
+    return &kernels;
+}
+
+#else
+
+const WaterKernels *GetAvx2WaterKernels()
+{
+    return nullptr;
+}
+
+#endif
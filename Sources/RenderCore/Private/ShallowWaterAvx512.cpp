@@ -0,0 +1,23 @@
+// Built with AVX-512F enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx512WaterLanes
+
+#include "WaterKernels.hpp"
+
+#if defined(__AVX512F__)
+
+const WaterKernels *GetAvx512WaterKernels()
+{
+    static const WaterKernels kernels =
+        Avx512WaterLanes::MakeWaterKernels<Avx512WaterLanes::Avx512Lanes>(SimdIsa::Avx512);
+    return &kernels;
+}
+
+#else
+
+const WaterKernels *GetAvx512WaterKernels()
+{
+    return nullptr;
+}
+
+#endif
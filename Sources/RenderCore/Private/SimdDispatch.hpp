@@ -0,0 +1,104 @@
+#ifndef VULKAN_CORE_SIMD_DISPATCH_H
+#define VULKAN_CORE_SIMD_DISPATCH_H
+
+#include <atomic>
+
+#include "CpuFeatures.hpp"
+#include "SimdLanes.hpp"
+
+// widest lanes the baseline compiler flags allow, the fallback when the cpu has no wider ISA
+#if defined(RENDERCORE_LANES_SSE2)
+static const SimdIsa SimdDefaultIsa = SimdIsa::Sse2;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+static const SimdIsa SimdDefaultIsa = SimdIsa::Neon;
+#else
+static const SimdIsa SimdDefaultIsa = SimdIsa::Scalar;
+#endif
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+#if defined(RENDERCORE_LANES_SSE2)
+typedef Sse2Lanes DefaultLanes;
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef NeonLanes DefaultLanes;
+#else
+typedef ScalarLanes DefaultLanes;
+#endif
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+// Runtime choice of one module's kernel table, a struct of function pointers with an `isa`
+// member. At first use it takes the module's AVX-512 or AVX2 table when the cpu runs it and the
+// *Avx512.cpp / *Avx2.cpp translation unit was built with its flags, otherwise the DefaultLanes
+// table. Constant initialized, so kernels can be used from other static initializers; a table
+// type has a single dispatch, which owns its scalar and default tables.
+template <typename Kernels> class SimdDispatch
+{
+  public:
+    typedef Kernels (*MakeKernels)(SimdIsa isa);
+    typedef const Kernels *(*WideKernels)();
+
+    // avx2 and avx512 may be null for modules without those translation units
+    constexpr SimdDispatch(MakeKernels makeScalar, MakeKernels makeDefault, WideKernels avx2, WideKernels avx512)
+        : mMakeScalar(makeScalar), mMakeDefault(makeDefault), mAvx2(avx2), mAvx512(avx512), mCurrent(nullptr)
+    {
+    }
+
+    const Kernels &Get()
+    {
+        const Kernels *kernels = mCurrent.load(std::memory_order_acquire);
+        if (kernels == nullptr)
+        {
+            kernels = &best();
+            mCurrent.store(kernels, std::memory_order_release);
+        }
+        return *kernels;
+    }
+
+    // restricts dispatch to isa or below, for comparisons and debugging; returns the isa in use
+    SimdIsa Limit(SimdIsa isa)
+    {
+        const Kernels &widest = best();
+        const Kernels *kernels = &widest;
+        if (isa == SimdIsa::Scalar)
+        {
+            static const Kernels scalar = mMakeScalar(SimdIsa::Scalar);
+            kernels = &scalar;
+        }
+        else if (isa == SimdIsa::Avx2 && widest.isa == SimdIsa::Avx512 && mAvx2 != nullptr && mAvx2() != nullptr)
+        {
+            kernels = mAvx2();
+        }
+        else if (isa == SimdDefaultIsa && widest.isa != SimdDefaultIsa)
+        {
+            static const Kernels narrow = mMakeDefault(SimdDefaultIsa);
+            kernels = &narrow;
+        }
+        mCurrent.store(kernels, std::memory_order_release);
+        return kernels->isa;
+    }
+
+  private:
+    const Kernels &best() const
+    {
+        static const Kernels kernels = pick();
+        return kernels;
+    }
+
+    Kernels pick() const
+    {
+        const Kernels *wide = mAvx512 != nullptr && CpuSupportsAvx512() ? mAvx512() : nullptr;
+        if (wide == nullptr && mAvx2 != nullptr && CpuSupportsAvx2())
+        {
+            wide = mAvx2();
+        }
+        return wide != nullptr ? *wide : mMakeDefault(SimdDefaultIsa);
+    }
+
+    MakeKernels mMakeScalar;
+    MakeKernels mMakeDefault;
+    WideKernels mAvx2;
+    WideKernels mAvx512;
+    std::atomic<const Kernels *> mCurrent;
+};
+
+#endif // VULKAN_CORE_SIMD_DISPATCH_H
@@ -0,0 +1,405 @@
+#ifndef VULKAN_CORE_SIMD_LANES_H
+#define VULKAN_CORE_SIMD_LANES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RENDERCORE_LANES_SSE2 1
+#endif
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+#include <math.h>
+
+// Thin wrappers giving every instruction set the same float vector interface, so a kernel is
+// written once as a template over the lane type and instantiated per ISA. A lane type is only
+// defined when the translation unit is compiled for its instruction set; runtime selection
+// happens in the caller (see SimdDispatch).
+//
+// Add, Sub, Mul, Div, Sqrt and Max round exactly like their scalar counterparts (except the
+// armv7 Div estimate), so a kernel that avoids MulAdd gives bit-identical results on every lane
+// type as long as the compiler does not contract on its own (see -ffp-contract in CMakeLists.txt).
+//
+// Translation units built with extra ISA flags define RENDERCORE_LANES_NAMESPACE before
+// including this, so the linker can never fold their out-of-line copies of a lane or kernel
+// function into the baseline ones.
+#ifndef RENDERCORE_LANES_NAMESPACE
+#define RENDERCORE_LANES_NAMESPACE BaselineLanes
+#endif
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+struct ScalarLanes
+{
+    typedef float Type;
+    static const size_t Width = 1;
+
+    static Type Load(const float *p)
+    {
+        return *p;
+    }
+    static void Store(float *p, Type v)
+    {
+        *p = v;
+    }
+    static Type Set1(float v)
+    {
+        return v;
+    }
+    static Type Add(Type a, Type b)
+    {
+        return a + b;
+    }
+    static Type Sub(Type a, Type b)
+    {
+        return a - b;
+    }
+    static Type Mul(Type a, Type b)
+    {
+        return a * b;
+    }
+    // a * b + c
+    static Type MulAdd(Type a, Type b, Type c)
+    {
+        return a * b + c;
+    }
+    static Type Div(Type a, Type b)
+    {
+        return a / b;
+    }
+    static Type Abs(Type a)
+    {
+        return a < 0.0f ? -a : a;
+    }
+    // a when a > b, otherwise b, like maxps
+    static Type Max(Type a, Type b)
+    {
+        return a > b ? a : b;
+    }
+    static Type Sqrt(Type a)
+    {
+        return sqrtf(a);
+    }
+    // comparisons return a lane mask, MoveMask packs one bit per lane
+    static Type Less(Type a, Type b)
+    {
+        return a < b ? 1.0f : 0.0f;
+    }
+    static Type OrMask(Type a, Type b)
+    {
+        return (a != 0.0f || b != 0.0f) ? 1.0f : 0.0f;
+    }
+    static uint32_t MoveMask(Type mask)
+    {
+        return mask != 0.0f ? 1u : 0u;
+    }
+};
+
+#if defined(RENDERCORE_LANES_SSE2)
+struct Sse2Lanes
+{
+    typedef __m128 Type;
+    static const size_t Width = 4;
+
+    static Type Load(const float *p)
+    {
+        return _mm_loadu_ps(p);
+    }
+    static void Store(float *p, Type v)
+    {
+        _mm_storeu_ps(p, v);
+    }
+    static Type Set1(float v)
+    {
+        return _mm_set1_ps(v);
+    }
+    static Type Add(Type a, Type b)
+    {
+        return _mm_add_ps(a, b);
+    }
+    static Type Sub(Type a, Type b)
+    {
+        return _mm_sub_ps(a, b);
+    }
+    static Type Mul(Type a, Type b)
+    {
+        return _mm_mul_ps(a, b);
+    }
+    static Type MulAdd(Type a, Type b, Type c)
+    {
+        return _mm_add_ps(_mm_mul_ps(a, b), c);
+    }
+    static Type Div(Type a, Type b)
+    {
+        return _mm_div_ps(a, b);
+    }
+    static Type Abs(Type a)
+    {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), a);
+    }
+    static Type Max(Type a, Type b)
+    {
+        return _mm_max_ps(a, b);
+    }
+    static Type Sqrt(Type a)
+    {
+        return _mm_sqrt_ps(a);
+    }
+    static Type Less(Type a, Type b)
+    {
+        return _mm_cmplt_ps(a, b);
+    }
+    static Type OrMask(Type a, Type b)
+    {
+        return _mm_or_ps(a, b);
+    }
+    static uint32_t MoveMask(Type mask)
+    {
+        return static_cast<uint32_t>(_mm_movemask_ps(mask));
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2Lanes
+{
+    typedef __m256 Type;
+    static const size_t Width = 8;
+
+    static Type Load(const float *p)
+    {
+        return _mm256_loadu_ps(p);
+    }
+    static void Store(float *p, Type v)
+    {
+        _mm256_storeu_ps(p, v);
+    }
+    static Type Set1(float v)
+    {
+        return _mm256_set1_ps(v);
+    }
+    static Type Add(Type a, Type b)
+    {
+        return _mm256_add_ps(a, b);
+    }
+    static Type Sub(Type a, Type b)
+    {
+        return _mm256_sub_ps(a, b);
+    }
+    static Type Mul(Type a, Type b)
+    {
+        return _mm256_mul_ps(a, b);
+    }
+    static Type MulAdd(Type a, Type b, Type c)
+    {
+#if defined(__FMA__)
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+    static Type Div(Type a, Type b)
+    {
+        return _mm256_div_ps(a, b);
+    }
+    static Type Abs(Type a)
+    {
+        return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+    }
+    static Type Max(Type a, Type b)
+    {
+        return _mm256_max_ps(a, b);
+    }
+    static Type Sqrt(Type a)
+    {
+        return _mm256_sqrt_ps(a);
+    }
+    static Type Less(Type a, Type b)
+    {
+        return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+    }
+    static Type OrMask(Type a, Type b)
+    {
+        return _mm256_or_ps(a, b);
+    }
+    static uint32_t MoveMask(Type mask)
+    {
+        return static_cast<uint32_t>(_mm256_movemask_ps(mask));
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+// AVX-512 compares produce mask registers, Less widens them back to all-ones lanes so the
+// kernels see the same lane masks as with the other ISAs.
+struct Avx512Lanes
+{
+    typedef __m512 Type;
+    static const size_t Width = 16;
+
+    static Type Load(const float *p)
+    {
+        return _mm512_loadu_ps(p);
+    }
+    static void Store(float *p, Type v)
+    {
+        _mm512_storeu_ps(p, v);
+    }
+    static Type Set1(float v)
+    {
+        return _mm512_set1_ps(v);
+    }
+    static Type Add(Type a, Type b)
+    {
+        return _mm512_add_ps(a, b);
+    }
+    static Type Sub(Type a, Type b)
+    {
+        return _mm512_sub_ps(a, b);
+    }
+    static Type Mul(Type a, Type b)
+    {
+        return _mm512_mul_ps(a, b);
+    }
+    static Type MulAdd(Type a, Type b, Type c)
+    {
+        return _mm512_fmadd_ps(a, b, c);
+    }
+    static Type Div(Type a, Type b)
+    {
+        return _mm512_div_ps(a, b);
+    }
+    static Type Abs(Type a)
+    {
+        return _mm512_abs_ps(a);
+    }
+    // the unmasked max and sqrt start from _mm512_undefined_ps, which GCC 12 reports as
+    // -Wmaybe-uninitialized (GCC bug 105593); the zero-masked forms with every lane set compile
+    // to the same instructions
+    static Type Max(Type a, Type b)
+    {
+        return _mm512_maskz_max_ps(0xffff, a, b);
+    }
+    static Type Sqrt(Type a)
+    {
+        return _mm512_maskz_sqrt_ps(0xffff, a);
+    }
+    static Type Less(Type a, Type b)
+    {
+        return _mm512_castsi512_ps(_mm512_maskz_set1_epi32(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), -1));
+    }
+    static Type OrMask(Type a, Type b)
+    {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(a), _mm512_castps_si512(b)));
+    }
+    static uint32_t MoveMask(Type mask)
+    {
+        return static_cast<uint32_t>(_mm512_cmplt_epi32_mask(_mm512_castps_si512(mask), _mm512_setzero_si512()));
+    }
+};
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+struct NeonLanes
+{
+    typedef float32x4_t Type;
+    static const size_t Width = 4;
+
+    static Type Load(const float *p)
+    {
+        return vld1q_f32(p);
+    }
+    static void Store(float *p, Type v)
+    {
+        vst1q_f32(p, v);
+    }
+    static Type Set1(float v)
+    {
+        return vdupq_n_f32(v);
+    }
+    static Type Add(Type a, Type b)
+    {
+        return vaddq_f32(a, b);
+    }
+    static Type Sub(Type a, Type b)
+    {
+        return vsubq_f32(a, b);
+    }
+    static Type Mul(Type a, Type b)
+    {
+        return vmulq_f32(a, b);
+    }
+    static Type MulAdd(Type a, Type b, Type c)
+    {
+#if defined(__aarch64__)
+        return vfmaq_f32(c, a, b);
+#else
+        return vmlaq_f32(c, a, b);
+#endif
+    }
+    static Type Div(Type a, Type b)
+    {
+#if defined(__aarch64__)
+        return vdivq_f32(a, b);
+#else
+        // armv7 has no vector divide, refine the reciprocal estimate twice
+        Type r = vrecpeq_f32(b);
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        r = vmulq_f32(vrecpsq_f32(b, r), r);
+        return vmulq_f32(a, r);
+#endif
+    }
+    static Type Abs(Type a)
+    {
+        return vabsq_f32(a);
+    }
+    static Type Max(Type a, Type b)
+    {
+        return vmaxq_f32(a, b);
+    }
+    static Type Sqrt(Type a)
+    {
+#if defined(__aarch64__)
+        return vsqrtq_f32(a);
+#else
+        // armv7 only has a reciprocal square root estimate, go through the scalar unit
+        float lanes[4];
+        vst1q_f32(lanes, a);
+        for (int i = 0; i < 4; i++)
+        {
+            lanes[i] = sqrtf(lanes[i]);
+        }
+        return vld1q_f32(lanes);
+#endif
+    }
+    static Type Less(Type a, Type b)
+    {
+        return vreinterpretq_f32_u32(vcltq_f32(a, b));
+    }
+    static Type OrMask(Type a, Type b)
+    {
+        return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+    }
+    static uint32_t MoveMask(Type mask)
+    {
+        uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+#if defined(__aarch64__)
+        static const int32_t shifts[4] = {0, 1, 2, 3};
+        return vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts)));
+#else
+        return vgetq_lane_u32(bits, 0) | (vgetq_lane_u32(bits, 1) << 1) | (vgetq_lane_u32(bits, 2) << 2) |
+               (vgetq_lane_u32(bits, 3) << 3);
+#endif
+    }
+};
+#endif
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_SIMD_LANES_H
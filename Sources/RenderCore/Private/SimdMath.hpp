@@ -0,0 +1,75 @@
+#ifndef VULKAN_CORE_SIMD_MATH_H
+#define VULKAN_CORE_SIMD_MATH_H
+
+#include "glm/glm.hpp"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define RENDERCORE_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RENDERCORE_SIMD_SSE 1
+#endif
+
+// out = a * b for column-major 4x4 matrices, out may alias a or b. Each column of the result
+// is a linear combination of the columns of a, which maps onto four broadcast multiply-adds.
+inline void MultiplyMat4(const float *a, const float *b, float *out)
+{
+#if defined(RENDERCORE_SIMD_NEON)
+    float32x4_t a0 = vld1q_f32(a);
+    float32x4_t a1 = vld1q_f32(a + 4);
+    float32x4_t a2 = vld1q_f32(a + 8);
+    float32x4_t a3 = vld1q_f32(a + 12);
+    float32x4_t columns[4];
+    for (int i = 0; i < 4; i++)
+    {
+        float32x4_t column = vld1q_f32(b + 4 * i);
+        float32x4_t r = vmulq_lane_f32(a0, vget_low_f32(column), 0);
+        r = vmlaq_lane_f32(r, a1, vget_low_f32(column), 1);
+        r = vmlaq_lane_f32(r, a2, vget_high_f32(column), 0);
+        columns[i] = vmlaq_lane_f32(r, a3, vget_high_f32(column), 1);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        vst1q_f32(out + 4 * i, columns[i]);
+    }
+#elif defined(RENDERCORE_SIMD_SSE)
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+    __m128 columns[4];
+    for (int i = 0; i < 4; i++)
+    {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[4 * i]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[4 * i + 1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[4 * i + 2])));
+        columns[i] = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[4 * i + 3])));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        _mm_storeu_ps(out + 4 * i, columns[i]);
+    }
+#else
+    float columns[16];
+    for (int i = 0; i < 4; i++)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            columns[4 * i + row] = a[row] * b[4 * i] + a[4 + row] * b[4 * i + 1] + a[8 + row] * b[4 * i + 2] +
+                                   a[12 + row] * b[4 * i + 3];
+        }
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        out[i] = columns[i];
+    }
+#endif
+}
+
+inline void MultiplyMat4(const glm::mat4 &a, const glm::mat4 &b, glm::mat4 &out)
+{
+    MultiplyMat4(&a[0][0], &b[0][0], &out[0][0]);
+}
+
+#endif // VULKAN_CORE_SIMD_MATH_H
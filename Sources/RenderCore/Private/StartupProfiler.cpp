@@ -0,0 +1,160 @@
+#include "StartupProfiler.hpp"
+
+#include <stdio.h>
+
+static std::string EscapeJson(const std::string &s)
+{
+    std::string out;
+    out.reserve(s.size());
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+    return out;
+}
+
+static std::string FormatMs(double ms)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.3f", ms);
+    return buf;
+}
+
+StartupProfiler::StartupProfiler() : mOrigin(std::chrono::steady_clock::now())
+{
+}
+
+void StartupProfiler::Begin(const char *name)
+{
+    Phase phase;
+    phase.name = name;
+    phase.depth = static_cast<uint32_t>(mOpenPhases.size());
+    phase.startMs = elapsedMs();
+    phase.durationMs = 0.0;
+
+    mOpenPhases.push_back(mPhases.size());
+    mPhases.push_back(phase);
+}
+
+void StartupProfiler::End()
+{
+    if (mOpenPhases.empty())
+    {
+        return;
+    }
+
+    Phase &phase = mPhases[mOpenPhases.back()];
+    phase.durationMs = elapsedMs() - phase.startMs;
+    mOpenPhases.pop_back();
+}
+
+void StartupProfiler::SetAttribute(const std::string &key, const std::string &value)
+{
+    for (auto &attribute : mAttributes)
+    {
+        if (attribute.first == key)
+        {
+            attribute.second = value;
+            return;
+        }
+    }
+    mAttributes.emplace_back(key, value);
+}
+
+double StartupProfiler::TotalMs() const
+{
+    double total = 0.0;
+    for (auto &phase : mPhases)
+    {
+        if (phase.depth == 0)
+        {
+            total += phase.durationMs;
+        }
+    }
+    return total;
+}
+
+std::string StartupProfiler::ToJson() const
+{
+    std::string json = "{\n";
+    json += "  \"total_ms\": " + FormatMs(TotalMs()) + ",\n";
+
+    json += "  \"attributes\": {";
+    for (size_t i = 0; i < mAttributes.size(); i++)
+    {
+        json += i == 0 ? "\n" : ",\n";
+        json += "    \"" + EscapeJson(mAttributes[i].first) + "\": \"" + EscapeJson(mAttributes[i].second) + "\"";
+    }
+    json += mAttributes.empty() ? "},\n" : "\n  },\n";
+
+    json += "  \"phases\": [";
+    for (size_t i = 0; i < mPhases.size(); i++)
+    {
+        const Phase &phase = mPhases[i];
+        json += i == 0 ? "\n" : ",\n";
+        json += "    {\"name\": \"" + EscapeJson(phase.name) + "\", \"depth\": " + std::to_string(phase.depth) +
+                ", \"start_ms\": " + FormatMs(phase.startMs) + ", \"duration_ms\": " + FormatMs(phase.durationMs) +
+                "}";
+    }
+    json += mPhases.empty() ? "]\n" : "\n  ]\n";
+    json += "}\n";
+    return json;
+}
+
+std::string StartupProfiler::ToLogLine() const
+{
+    std::string line = "startup " + FormatMs(TotalMs()) + "ms:";
+    for (auto &phase : mPhases)
+    {
+        if (phase.depth == 0)
+        {
+            continue;
+        }
+        line += " " + phase.name + "=" + FormatMs(phase.durationMs);
+    }
+    return line;
+}
+
+bool StartupProfiler::WriteJson(const std::string &path) const
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::string json = ToJson();
+    bool ok = fwrite(json.data(), 1, json.size(), file) == json.size();
+    fclose(file);
+    return ok;
+}
+
+double StartupProfiler::elapsedMs() const
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mOrigin).count();
+}
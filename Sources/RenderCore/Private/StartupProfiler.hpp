@@ -0,0 +1,75 @@
+#ifndef VULKAN_CORE_STARTUP_PROFILER_H
+#define VULKAN_CORE_STARTUP_PROFILER_H
+
+#include <chrono>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records wall time of the init phases and driver calls made during startup.
+// Phases nest, so a driver call timed inside an init step shows up as its child.
+class StartupProfiler
+{
+  public:
+    struct Phase
+    {
+        std::string name;
+        uint32_t depth;
+        double startMs;
+        double durationMs;
+    };
+
+    class Scope
+    {
+      public:
+        Scope(StartupProfiler &profiler, const char *name) : mProfiler(profiler)
+        {
+            mProfiler.Begin(name);
+        }
+
+        ~Scope()
+        {
+            mProfiler.End();
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        StartupProfiler &mProfiler;
+    };
+
+    StartupProfiler();
+
+    void Begin(const char *name);
+    void End();
+
+    // extra key/value pairs written into the report, e.g. driver and sdk versions
+    void SetAttribute(const std::string &key, const std::string &value);
+
+    double TotalMs() const;
+    const std::vector<Phase> &GetPhases() const
+    {
+        return mPhases;
+    }
+
+    std::string ToJson() const;
+    std::string ToLogLine() const;
+    bool WriteJson(const std::string &path) const;
+
+  private:
+    double elapsedMs() const;
+
+    std::chrono::steady_clock::time_point mOrigin;
+    std::vector<Phase> mPhases;
+    std::vector<size_t> mOpenPhases;
+    std::vector<std::pair<std::string, std::string>> mAttributes;
+};
+
+#define STARTUP_PHASE_CONCAT_INNER(a, b) a##b
+#define STARTUP_PHASE_CONCAT(a, b) STARTUP_PHASE_CONCAT_INNER(a, b)
+#define STARTUP_PHASE(profiler, name) \
+    StartupProfiler::Scope STARTUP_PHASE_CONCAT(startupPhase_, __LINE__)(profiler, name)
+
+#endif // VULKAN_CORE_STARTUP_PROFILER_H
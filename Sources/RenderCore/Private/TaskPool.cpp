@@ -0,0 +1,116 @@
+#include "TaskPool.hpp"
+
+#include "CpuProfiler.hpp"
+
+static thread_local bool tInsideChunk = false;
+
+TaskPool &TaskPool::Instance()
+{
+    static TaskPool instance;
+    return instance;
+}
+
+TaskPool::TaskPool()
+    : mGeneration(0), mActive(0), mStop(false), mFn(nullptr), mCount(0), mGrain(1), mChunkCount(0), mNextChunk(0),
+      mFinishedChunks(0)
+{
+    uint32_t hardware = std::thread::hardware_concurrency();
+    uint32_t workers = hardware > 1 ? hardware - 1 : 0;
+    for (uint32_t i = 0; i < workers; i++)
+    {
+        mWorkers.emplace_back(&TaskPool::workerLoop, this);
+    }
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mWake.notify_all();
+    for (auto &worker : mWorkers)
+    {
+        worker.join();
+    }
+}
+
+void TaskPool::workerLoop()
+{
+    CPU_THREAD_NAME("TaskPool worker");
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (true)
+    {
+        mWake.wait(lock, [this, seen] { return mStop || mGeneration != seen; });
+        if (mStop)
+        {
+            return;
+        }
+        seen = mGeneration;
+
+        mActive++;
+        lock.unlock();
+        runChunks();
+        lock.lock();
+        mActive--;
+        if (mActive == 0)
+        {
+            mDone.notify_all();
+        }
+    }
+}
+
+void TaskPool::runChunks()
+{
+    tInsideChunk = true;
+    size_t chunk;
+    while ((chunk = mNextChunk.fetch_add(1, std::memory_order_relaxed)) < mChunkCount)
+    {
+        size_t begin = chunk * mGrain;
+        size_t end = begin + mGrain < mCount ? begin + mGrain : mCount;
+        (*mFn)(begin, end);
+        mFinishedChunks.fetch_add(1, std::memory_order_release);
+    }
+    tInsideChunk = false;
+}
+
+void TaskPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    grain = grain > 0 ? grain : 1;
+    if (mWorkers.empty() || count <= grain || tInsideChunk)
+    {
+        for (size_t begin = 0; begin < count; begin += grain)
+        {
+            fn(begin, begin + grain < count ? begin + grain : count);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submit(mSubmitMutex);
+    {
+        // a worker that woke late for the previous job may still be looking at its state
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this] { return mActive == 0; });
+        mFn = &fn;
+        mCount = count;
+        mGrain = grain;
+        mChunkCount = (count + grain - 1) / grain;
+        mNextChunk.store(0, std::memory_order_relaxed);
+        mFinishedChunks.store(0, std::memory_order_relaxed);
+        mGeneration++;
+    }
+    mWake.notify_all();
+
+    runChunks();
+
+    // chunks taken by workers may still be running
+    std::unique_lock<std::mutex> lock(mMutex);
+    mDone.wait(lock, [this] {
+        return mActive == 0 && mFinishedChunks.load(std::memory_order_acquire) == mChunkCount;
+    });
+}
@@ -0,0 +1,56 @@
+#ifndef VULKAN_CORE_TASK_POOL_H
+#define VULKAN_CORE_TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+// Persistent worker threads for data parallel loops. ParallelFor splits [0, count) into chunks
+// of grain items, the calling thread works on chunks too and returns once all of them ran.
+// Calls from several threads are serialized; a call from inside a chunk runs inline.
+class TaskPool
+{
+  public:
+    static TaskPool &Instance();
+
+    ~TaskPool();
+
+    // worker threads plus the calling thread
+    uint32_t GetThreadCount() const
+    {
+        return static_cast<uint32_t>(mWorkers.size()) + 1;
+    }
+
+    void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> &fn);
+
+  private:
+    TaskPool();
+
+    void workerLoop();
+    // runs chunks of the current job until none are left
+    void runChunks();
+
+    std::vector<std::thread> mWorkers;
+    std::mutex mSubmitMutex;
+
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    uint64_t mGeneration;
+    uint32_t mActive;
+    bool mStop;
+
+    const std::function<void(size_t, size_t)> *mFn;
+    size_t mCount;
+    size_t mGrain;
+    size_t mChunkCount;
+    std::atomic<size_t> mNextChunk;
+    std::atomic<size_t> mFinishedChunks;
+};
+
+#endif // VULKAN_CORE_TASK_POOL_H
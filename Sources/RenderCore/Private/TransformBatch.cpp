@@ -0,0 +1,44 @@
+#include "TransformBatch.hpp"
+
+#include "SimdDispatch.hpp"
+#include "TransformKernels.hpp"
+
+using namespace RENDERCORE_LANES_NAMESPACE;
+
+static SimdDispatch<TransformKernels> sDispatch(MakeTransformKernels<ScalarLanes>, MakeTransformKernels<DefaultLanes>,
+                                                GetAvx2TransformKernels, nullptr);
+
+static const TransformKernels &Kernels()
+{
+    return sDispatch.Get();
+}
+
+SimdIsa TransformBatch::GetIsa()
+{
+    return Kernels().isa;
+}
+
+const char *TransformBatch::GetIsaName()
+{
+    return GetSimdIsaName(GetIsa());
+}
+
+SimdIsa TransformBatch::LimitIsa(SimdIsa isa)
+{
+    return sDispatch.Limit(isa);
+}
+
+void TransformBatch::ComposeModel(const TransformSoA &transforms, const Mat4SoA &models, size_t count)
+{
+    Kernels().composeModel(transforms, models, count);
+}
+
+void TransformBatch::Multiply(const glm::mat4 &lhs, const Mat4SoA &in, const Mat4SoA &out, size_t count)
+{
+    Kernels().multiply(&lhs[0][0], in, out, count);
+}
+
+void TransformBatch::NormalMatrix(const Mat4SoA &models, const Mat3SoA &normals, size_t count)
+{
+    Kernels().normalMatrix(models, normals, count);
+}
@@ -0,0 +1,103 @@
+#ifndef VULKAN_CORE_TRANSFORM_BATCH_H
+#define VULKAN_CORE_TRANSFORM_BATCH_H
+
+#include "CpuFeatures.hpp"
+#include "glm/glm.hpp"
+
+#include <stddef.h>
+#include <vector>
+
+// Structure of arrays views. Element k of matrix i lives at m[k][i], elements are column-major
+// like glm (k = column * 4 + row for Mat4SoA, column * 3 + row for Mat3SoA).
+struct Mat4SoA
+{
+    float *m[16];
+};
+
+struct Mat3SoA
+{
+    float *m[9];
+};
+
+// per-instance translation, unit quaternion (x, y, z, w) and scale
+struct TransformSoA
+{
+    const float *position[3];
+    const float *rotation[4];
+    const float *scale[3];
+};
+
+// Owns the arrays behind a Mat4SoA or Mat3SoA, one contiguous block per element.
+template <size_t Elements> class SoAStorage
+{
+  public:
+    void Resize(size_t count)
+    {
+        mCount = count;
+        mData.resize(Elements * count);
+    }
+
+    size_t Count() const
+    {
+        return mCount;
+    }
+
+    float *Element(size_t k)
+    {
+        return mData.data() + k * mCount;
+    }
+
+  private:
+    size_t mCount = 0;
+    std::vector<float> mData;
+};
+
+class Mat4Array : public SoAStorage<16>
+{
+  public:
+    Mat4SoA View()
+    {
+        Mat4SoA view;
+        for (size_t k = 0; k < 16; k++)
+        {
+            view.m[k] = Element(k);
+        }
+        return view;
+    }
+};
+
+class Mat3Array : public SoAStorage<9>
+{
+  public:
+    Mat3SoA View()
+    {
+        Mat3SoA view;
+        for (size_t k = 0; k < 9; k++)
+        {
+            view.m[k] = Element(k);
+        }
+        return view;
+    }
+};
+
+// Batched matrix kernels over SoA arrays. Each call processes count instances with the widest
+// instruction set the cpu supports (AVX2, SSE2 or NEON, scalar otherwise), picked once at
+// first use. Inputs and outputs must not overlap unless noted.
+class TransformBatch
+{
+  public:
+    static SimdIsa GetIsa();
+    static const char *GetIsaName();
+    // see SimdDispatch::Limit
+    static SimdIsa LimitIsa(SimdIsa isa);
+
+    // model = translate(position) * rotate(rotation) * scale(scale)
+    static void ComposeModel(const TransformSoA &transforms, const Mat4SoA &models, size_t count);
+    // out[i] = lhs * in[i], e.g. mvp from a camera's view projection and the model matrices.
+    // out may be in.
+    static void Multiply(const glm::mat4 &lhs, const Mat4SoA &in, const Mat4SoA &out, size_t count);
+    // inverse transpose of the upper 3x3, singular matrices produce non-finite results
+    static void NormalMatrix(const Mat4SoA &models, const Mat3SoA &normals, size_t count);
+};
+
+#endif // VULKAN_CORE_TRANSFORM_BATCH_H
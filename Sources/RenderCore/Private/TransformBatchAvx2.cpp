@@ -0,0 +1,23 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx2KernelLanes
+
+#include "TransformKernels.hpp"
+
+#if defined(__AVX2__)
+
+const TransformKernels *GetAvx2TransformKernels()
+{
+    static const TransformKernels kernels =
+        Avx2KernelLanes::MakeTransformKernels<Avx2KernelLanes::Avx2Lanes>(SimdIsa::Avx2);
+    return &kernels;
+}
+
+#else
+
+const TransformKernels *GetAvx2TransformKernels()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,186 @@
+#ifndef VULKAN_CORE_TRANSFORM_KERNELS_H
+#define VULKAN_CORE_TRANSFORM_KERNELS_H
+
+#include "SimdLanes.hpp"
+#include "TransformBatch.hpp"
+
+// Kernel templates behind TransformBatch. Every ISA translation unit instantiates them with its
+// lane type through MakeTransformKernels; a block handles V::Width instances and the remainder
+// runs through ScalarLanes.
+
+struct TransformKernels
+{
+    SimdIsa isa;
+    void (*composeModel)(const TransformSoA &transforms, const Mat4SoA &models, size_t count);
+    void (*multiply)(const float *lhs, const Mat4SoA &in, const Mat4SoA &out, size_t count);
+    void (*normalMatrix)(const Mat4SoA &models, const Mat3SoA &normals, size_t count);
+};
+
+// null when RenderCore was built without the AVX2 translation unit
+const TransformKernels *GetAvx2TransformKernels();
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+template <typename V> void ComposeModelBlock(const TransformSoA &t, const Mat4SoA &out, size_t i)
+{
+    typedef typename V::Type T;
+    T x = V::Load(t.rotation[0] + i);
+    T y = V::Load(t.rotation[1] + i);
+    T z = V::Load(t.rotation[2] + i);
+    T w = V::Load(t.rotation[3] + i);
+    T sx = V::Load(t.scale[0] + i);
+    T sy = V::Load(t.scale[1] + i);
+    T sz = V::Load(t.scale[2] + i);
+
+    T one = V::Set1(1.0f);
+    T two = V::Set1(2.0f);
+    T x2 = V::Mul(x, two);
+    T y2 = V::Mul(y, two);
+    T z2 = V::Mul(z, two);
+    T xx = V::Mul(x, x2);
+    T yy = V::Mul(y, y2);
+    T zz = V::Mul(z, z2);
+    T xy = V::Mul(x, y2);
+    T xz = V::Mul(x, z2);
+    T yz = V::Mul(y, z2);
+    T wx = V::Mul(w, x2);
+    T wy = V::Mul(w, y2);
+    T wz = V::Mul(w, z2);
+    T zero = V::Set1(0.0f);
+
+    V::Store(out.m[0] + i, V::Mul(V::Sub(one, V::Add(yy, zz)), sx));
+    V::Store(out.m[1] + i, V::Mul(V::Add(xy, wz), sx));
+    V::Store(out.m[2] + i, V::Mul(V::Sub(xz, wy), sx));
+    V::Store(out.m[3] + i, zero);
+
+    V::Store(out.m[4] + i, V::Mul(V::Sub(xy, wz), sy));
+    V::Store(out.m[5] + i, V::Mul(V::Sub(one, V::Add(xx, zz)), sy));
+    V::Store(out.m[6] + i, V::Mul(V::Add(yz, wx), sy));
+    V::Store(out.m[7] + i, zero);
+
+    V::Store(out.m[8] + i, V::Mul(V::Add(xz, wy), sz));
+    V::Store(out.m[9] + i, V::Mul(V::Sub(yz, wx), sz));
+    V::Store(out.m[10] + i, V::Mul(V::Sub(one, V::Add(xx, yy)), sz));
+    V::Store(out.m[11] + i, zero);
+
+    V::Store(out.m[12] + i, V::Load(t.position[0] + i));
+    V::Store(out.m[13] + i, V::Load(t.position[1] + i));
+    V::Store(out.m[14] + i, V::Load(t.position[2] + i));
+    V::Store(out.m[15] + i, one);
+}
+
+template <typename V> void MultiplyBlock(const typename V::Type *lhs, const Mat4SoA &in, const Mat4SoA &out, size_t i)
+{
+    typedef typename V::Type T;
+    // load the whole input first so out may alias in
+    T m[16];
+    for (size_t k = 0; k < 16; k++)
+    {
+        m[k] = V::Load(in.m[k] + i);
+    }
+    for (size_t column = 0; column < 4; column++)
+    {
+        for (size_t row = 0; row < 4; row++)
+        {
+            T r = V::Mul(lhs[row], m[column * 4]);
+            r = V::MulAdd(lhs[4 + row], m[column * 4 + 1], r);
+            r = V::MulAdd(lhs[8 + row], m[column * 4 + 2], r);
+            r = V::MulAdd(lhs[12 + row], m[column * 4 + 3], r);
+            V::Store(out.m[column * 4 + row] + i, r);
+        }
+    }
+}
+
+template <typename V> void NormalMatrixBlock(const Mat4SoA &in, const Mat3SoA &out, size_t i)
+{
+    typedef typename V::Type T;
+    // columns a, b, c of the upper 3x3; the inverse transpose is (b x c, c x a, a x b) / det
+    T ax = V::Load(in.m[0] + i), ay = V::Load(in.m[1] + i), az = V::Load(in.m[2] + i);
+    T bx = V::Load(in.m[4] + i), by = V::Load(in.m[5] + i), bz = V::Load(in.m[6] + i);
+    T cx = V::Load(in.m[8] + i), cy = V::Load(in.m[9] + i), cz = V::Load(in.m[10] + i);
+
+    T bcx = V::Sub(V::Mul(by, cz), V::Mul(bz, cy));
+    T bcy = V::Sub(V::Mul(bz, cx), V::Mul(bx, cz));
+    T bcz = V::Sub(V::Mul(bx, cy), V::Mul(by, cx));
+    T cax = V::Sub(V::Mul(cy, az), V::Mul(cz, ay));
+    T cay = V::Sub(V::Mul(cz, ax), V::Mul(cx, az));
+    T caz = V::Sub(V::Mul(cx, ay), V::Mul(cy, ax));
+    T abx = V::Sub(V::Mul(ay, bz), V::Mul(az, by));
+    T aby = V::Sub(V::Mul(az, bx), V::Mul(ax, bz));
+    T abz = V::Sub(V::Mul(ax, by), V::Mul(ay, bx));
+
+    T det = V::MulAdd(ax, bcx, V::MulAdd(ay, bcy, V::Mul(az, bcz)));
+    T inv = V::Div(V::Set1(1.0f), det);
+
+    V::Store(out.m[0] + i, V::Mul(bcx, inv));
+    V::Store(out.m[1] + i, V::Mul(bcy, inv));
+    V::Store(out.m[2] + i, V::Mul(bcz, inv));
+    V::Store(out.m[3] + i, V::Mul(cax, inv));
+    V::Store(out.m[4] + i, V::Mul(cay, inv));
+    V::Store(out.m[5] + i, V::Mul(caz, inv));
+    V::Store(out.m[6] + i, V::Mul(abx, inv));
+    V::Store(out.m[7] + i, V::Mul(aby, inv));
+    V::Store(out.m[8] + i, V::Mul(abz, inv));
+}
+
+template <typename V> void ComposeModelKernel(const TransformSoA &transforms, const Mat4SoA &models, size_t count)
+{
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        ComposeModelBlock<V>(transforms, models, i);
+    }
+    for (; i < count; i++)
+    {
+        ComposeModelBlock<ScalarLanes>(transforms, models, i);
+    }
+}
+
+template <typename V> void MultiplyKernel(const float *lhs, const Mat4SoA &in, const Mat4SoA &out, size_t count)
+{
+    typename V::Type wide[16];
+    float narrow[16];
+    for (size_t k = 0; k < 16; k++)
+    {
+        wide[k] = V::Set1(lhs[k]);
+        narrow[k] = lhs[k];
+    }
+
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        MultiplyBlock<V>(wide, in, out, i);
+    }
+    for (; i < count; i++)
+    {
+        MultiplyBlock<ScalarLanes>(narrow, in, out, i);
+    }
+}
+
+template <typename V> void NormalMatrixKernel(const Mat4SoA &models, const Mat3SoA &normals, size_t count)
+{
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        NormalMatrixBlock<V>(models, normals, i);
+    }
+    for (; i < count; i++)
+    {
+        NormalMatrixBlock<ScalarLanes>(models, normals, i);
+    }
+}
+
+template <typename V> TransformKernels MakeTransformKernels(SimdIsa isa)
+{
+    TransformKernels kernels;
+    kernels.isa = isa;
+    kernels.composeModel = ComposeModelKernel<V>;
+    kernels.multiply = MultiplyKernel<V>;
+    kernels.normalMatrix = NormalMatrixKernel<V>;
+    return kernels;
+}
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_TRANSFORM_KERNELS_H
@@ -1,7 +1,19 @@
 #include "Utils.hpp"
 
+#include <stdlib.h>
 #include <vector>
 
+void Panic(const char *msg, const char *file, int line)
+{
+    RenderCoreLogger()->critical("Panic: {} [file: {}, line: {}]", msg, file, line);
+    if (FlightRecorder::Instance().Dump())
+    {
+        RenderCoreLogger()->critical("flight recorder dumped");
+    }
+    ShutdownRenderCoreLog();
+    exit(EXIT_FAILURE);
+}
+
 std::string GetQueueFlagString(VkQueueFlags flag)
 {
     std::vector<std::string> flagStrings;
@@ -4,15 +4,25 @@
 #include <string>
 #include <vulkan/vulkan.h>
 
+#include "FlightRecorder.hpp"
+#include "Log.hpp"
+
 std::string GetQueueFlagString(VkQueueFlags flag);
 
 std::string GetVkResultString(VkResult res);
 
-#define PANIC_IF_NOT_SUCCESS(res)              \
-    if (res != VK_SUCCESS)                     \
-    {                                          \
-        PANIC(GetVkResultString(res).c_str()); \
-    }
+#define PANIC_IF_NOT_SUCCESS(res)                                     \
+    do                                                                \
+    {                                                                 \
+        if (res != VK_SUCCESS)                                        \
+        {                                                             \
+            if (res == VK_ERROR_DEVICE_LOST)                          \
+            {                                                         \
+                FLIGHT_RECORD(FlightEventType::DeviceLost, __LINE__); \
+            }                                                         \
+            PANIC(GetVkResultString(res).c_str());                    \
+        }                                                             \
+    } while (0)
 
 struct SwapChainBuffer
 {
@@ -20,11 +30,13 @@ struct SwapChainBuffer
     VkImageView view;
 };
 
-#define LOG(s) printf("Log: %s [file: %s, line: %d]\n", s, __FILE__, __LINE__);
-#define WARN(s) printf("Warn: %s [file: %s, line: %d]\n", s, __FILE__, __LINE__);
-#define ERROR(s) printf("Error: %s [file: %s, line: %d]\n", s, __FILE__, __LINE__);
-#define PANIC(s)                                                       \
-    printf("Panic: %s [file: %s, line: %d]\n", s, __FILE__, __LINE__); \
-    exit(EXIT_FAILURE);
+// logs through the async RenderCore logger, dumps the flight recorder, drains the log and exits
+[[noreturn]] void Panic(const char *msg, const char *file, int line);
+
+// single statements, the caller supplies the semicolon
+#define LOG(s) RC_INFO("{}", s)
+#define WARN(s) RC_WARN("{}", s)
+#define ERROR(s) RC_ERROR("{}", s)
+#define PANIC(s) Panic(s, __FILE__, __LINE__)
 
 #endif // VULKAN_CORE_UTILS_H
\ No newline at end of file
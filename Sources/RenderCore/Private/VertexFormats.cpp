@@ -0,0 +1,272 @@
+#include "VertexFormats.hpp"
+
+#include <math.h>
+#include <string.h>
+
+uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xffu;
+    uint32_t mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu)
+    {
+        // keep NaNs quiet and non zero
+        return static_cast<uint16_t>(sign | 0x7c00u | (mantissa != 0 ? 0x200u | (mantissa >> 13) : 0u));
+    }
+
+    // rebias, 127 to 15
+    int32_t halfExponent = static_cast<int32_t>(exponent) - 112;
+    if (halfExponent >= 31)
+    {
+        return static_cast<uint16_t>(sign | 0x7c00u);
+    }
+    if (halfExponent <= 0)
+    {
+        // subnormal or zero: shift the mantissa with its implicit bit into place
+        if (halfExponent < -10)
+        {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1u);
+        const uint32_t midpoint = 1u << (shift - 1);
+        if (rest > midpoint || (rest == midpoint && (half & 1u) != 0))
+        {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t rest = mantissa & 0x1fffu;
+    // a carry out of the mantissa bumps the exponent, up to infinity
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u) != 0))
+    {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value)
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1fu;
+    uint32_t mantissa = value & 0x3ffu;
+
+    uint32_t bits;
+    if (exponent == 0x1fu)
+    {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else if (mantissa == 0)
+    {
+        bits = sign;
+    }
+    else
+    {
+        // subnormal, normalize it
+        uint32_t e = 113;
+        while ((mantissa & 0x400u) == 0)
+        {
+            mantissa <<= 1;
+            e--;
+        }
+        bits = sign | (e << 23) | ((mantissa & 0x3ffu) << 13);
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+glm::vec2 OctEncode(const glm::vec3 &n)
+{
+    const float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+    glm::vec2 e(n.x / l1, n.y / l1);
+    if (n.z < 0.0f)
+    {
+        // fold the lower hemisphere over the diagonals
+        glm::vec2 folded((1.0f - fabsf(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - fabsf(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+        e = folded;
+    }
+    return e;
+}
+
+glm::vec3 OctDecode(const glm::vec2 &e)
+{
+    glm::vec3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+    const float t = n.z < 0.0f ? -n.z : 0.0f;
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+// the floor and ceiling of both scaled components, keeps the pair decoding closest to n
+static void QuantizeOct(const glm::vec3 &n, float scale, int out[2])
+{
+    const glm::vec2 e = OctEncode(n);
+    const float x = e.x * scale;
+    const float y = e.y * scale;
+    const int x0 = static_cast<int>(floorf(x));
+    const int y0 = static_cast<int>(floorf(y));
+    float best = -2.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        int qx = x0 + (i & 1);
+        int qy = y0 + (i >> 1);
+        qx = qx > static_cast<int>(scale) ? static_cast<int>(scale) : qx;
+        qy = qy > static_cast<int>(scale) ? static_cast<int>(scale) : qy;
+        qx = qx < -static_cast<int>(scale) ? -static_cast<int>(scale) : qx;
+        qy = qy < -static_cast<int>(scale) ? -static_cast<int>(scale) : qy;
+        glm::vec3 d = OctDecode(glm::vec2(static_cast<float>(qx) / scale, static_cast<float>(qy) / scale));
+        float cosine = glm::dot(d, n);
+        if (cosine > best)
+        {
+            best = cosine;
+            out[0] = qx;
+            out[1] = qy;
+        }
+    }
+}
+
+void PackOctSnorm8(const glm::vec3 &n, int8_t out[2])
+{
+    int q[2];
+    QuantizeOct(n, 127.0f, q);
+    out[0] = static_cast<int8_t>(q[0]);
+    out[1] = static_cast<int8_t>(q[1]);
+}
+
+void PackOctSnorm16(const glm::vec3 &n, int16_t out[2])
+{
+    int q[2];
+    QuantizeOct(n, 32767.0f, q);
+    out[0] = static_cast<int16_t>(q[0]);
+    out[1] = static_cast<int16_t>(q[1]);
+}
+
+// SNORM fetches clamp -128 and -32768 to -1, the packers never produce them
+glm::vec3 UnpackOctSnorm8(const int8_t in[2])
+{
+    return OctDecode(glm::vec2(fmaxf(in[0] / 127.0f, -1.0f), fmaxf(in[1] / 127.0f, -1.0f)));
+}
+
+glm::vec3 UnpackOctSnorm16(const int16_t in[2])
+{
+    return OctDecode(glm::vec2(fmaxf(in[0] / 32767.0f, -1.0f), fmaxf(in[1] / 32767.0f, -1.0f)));
+}
+
+VertexQuantization VertexQuantization::FromPositions(const glm::vec3 *positions, size_t count)
+{
+    VertexQuantization quantization;
+    if (count == 0)
+    {
+        quantization.origin = glm::vec3(0.0f);
+        quantization.extent = glm::vec3(1.0f);
+        return quantization;
+    }
+
+    glm::vec3 lo = positions[0];
+    glm::vec3 hi = positions[0];
+    for (size_t i = 1; i < count; i++)
+    {
+        lo = glm::min(lo, positions[i]);
+        hi = glm::max(hi, positions[i]);
+    }
+    quantization.origin = lo;
+    quantization.extent = hi - lo;
+    // flat meshes still need a scale to divide by
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (quantization.extent[axis] <= 0.0f)
+        {
+            quantization.extent[axis] = 1.0f;
+        }
+    }
+    return quantization;
+}
+
+static uint16_t PackUnorm16(float value)
+{
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<uint16_t>(value * 65535.0f + 0.5f);
+}
+
+VkVertexInputBindingDescription PackedVertex::GetBindingDescription(uint32_t binding)
+{
+    VkVertexInputBindingDescription description = {};
+    description.binding = binding;
+    description.stride = sizeof(PackedVertex);
+    description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return description;
+}
+
+void PackedVertex::GetAttributeDescriptions(uint32_t binding, uint32_t firstLocation,
+                                            VkVertexInputAttributeDescription attributes[4])
+{
+    const VkFormat formats[4] = {VK_FORMAT_R16G16B16A16_UNORM, VK_FORMAT_R16G16_SNORM, VK_FORMAT_R8G8B8A8_SNORM,
+                                 VK_FORMAT_R16G16_SFLOAT};
+    const uint32_t offsets[4] = {offsetof(PackedVertex, position), offsetof(PackedVertex, normal),
+                                 offsetof(PackedVertex, tangent), offsetof(PackedVertex, uv)};
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        attributes[i].location = firstLocation + i;
+        attributes[i].binding = binding;
+        attributes[i].format = formats[i];
+        attributes[i].offset = offsets[i];
+    }
+}
+
+void PackVertices(const VertexQuantization &quantization, const glm::vec3 *positions, const glm::vec3 *normals,
+                  const glm::vec4 *tangents, const glm::vec2 *uvs, size_t count, PackedVertex *out)
+{
+    const glm::vec3 scale(1.0f / quantization.extent.x, 1.0f / quantization.extent.y, 1.0f / quantization.extent.z);
+    for (size_t i = 0; i < count; i++)
+    {
+        PackedVertex &vertex = out[i];
+        glm::vec3 p = (positions[i] - quantization.origin) * scale;
+        vertex.position[0] = PackUnorm16(p.x);
+        vertex.position[1] = PackUnorm16(p.y);
+        vertex.position[2] = PackUnorm16(p.z);
+        vertex.position[3] = 0;
+
+        PackOctSnorm16(normals[i], vertex.normal);
+
+        if (tangents != nullptr)
+        {
+            PackOctSnorm8(glm::vec3(tangents[i].x, tangents[i].y, tangents[i].z), vertex.tangent);
+            vertex.tangent[2] = tangents[i].w < 0.0f ? -127 : 127;
+        }
+        else
+        {
+            vertex.tangent[0] = 127;
+            vertex.tangent[1] = 0;
+            vertex.tangent[2] = 127;
+        }
+        vertex.tangent[3] = 0;
+
+        vertex.uv[0] = uvs != nullptr ? FloatToHalf(uvs[i].x) : 0;
+        vertex.uv[1] = uvs != nullptr ? FloatToHalf(uvs[i].y) : 0;
+    }
+}
+
+void UnpackVertex(const VertexQuantization &quantization, const PackedVertex &vertex, glm::vec3 *position,
+                  glm::vec3 *normal, glm::vec4 *tangent, glm::vec2 *uv)
+{
+    glm::vec3 p(vertex.position[0] / 65535.0f, vertex.position[1] / 65535.0f, vertex.position[2] / 65535.0f);
+    *position = quantization.origin + p * quantization.extent;
+    *normal = UnpackOctSnorm16(vertex.normal);
+    glm::vec3 t = UnpackOctSnorm8(vertex.tangent);
+    *tangent = glm::vec4(t, vertex.tangent[2] < 0 ? -1.0f : 1.0f);
+    *uv = glm::vec2(HalfToFloat(vertex.uv[0]), HalfToFloat(vertex.uv[1]));
+}
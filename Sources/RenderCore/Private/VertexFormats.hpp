@@ -0,0 +1,79 @@
+#ifndef VULKAN_CORE_VERTEX_FORMATS_H
+#define VULKAN_CORE_VERTEX_FORMATS_H
+
+#include <vulkan/vulkan.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "glm/glm.hpp"
+
+// Packed vertex layouts and their codecs. Every attribute uses a format the vertex input fetches
+// natively (UNORM, SNORM, SFLOAT, UINT with mandatory vertex buffer support), so shaders get
+// floats without decode cost beyond the octahedral unfold:
+//
+//     vec3 OctDecode(vec2 e)
+//     {
+//         vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//         float t = max(-n.z, 0.0);
+//         n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+//         return normalize(n);
+//     }
+
+// IEEE binary16, rounded to nearest even; overflow becomes infinity, NaN stays NaN
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// unit vector to the [-1, 1]^2 octahedral square and back
+glm::vec2 OctEncode(const glm::vec3 &n);
+glm::vec3 OctDecode(const glm::vec2 &e);
+
+// octahedral encodings quantized to snorm8 or snorm16, picking the rounding of the two
+// components that decodes closest to n
+void PackOctSnorm8(const glm::vec3 &n, int8_t out[2]);
+void PackOctSnorm16(const glm::vec3 &n, int16_t out[2]);
+glm::vec3 UnpackOctSnorm8(const int8_t in[2]);
+glm::vec3 UnpackOctSnorm16(const int16_t in[2]);
+
+// Positions are unorm16 within the mesh's box: position = origin + unorm * extent. The shader
+// gets the box with the mesh's other per draw data.
+struct VertexQuantization
+{
+    glm::vec3 origin;
+    glm::vec3 extent;
+
+    static VertexQuantization FromPositions(const glm::vec3 *positions, size_t count);
+    // largest distance between a position inside the box and its decoded unorm16
+    glm::vec3 GetMaxError() const
+    {
+        return extent * (0.5f / 65535.0f);
+    }
+};
+
+// 20 bytes instead of 48 for fp32 position, normal, tangent and uv
+struct PackedVertex
+{
+    // R16G16B16A16_UNORM, xyz in the quantization box, w 0
+    uint16_t position[4];
+    // R16G16_SNORM octahedral normal
+    int16_t normal[2];
+    // R8G8B8A8_SNORM octahedral tangent in xy, bitangent sign in z (cross(normal, tangent) * z)
+    int8_t tangent[4];
+    // R16G16_SFLOAT
+    uint16_t uv[2];
+
+    // binding at the vertex rate, attributes position, normal, tangent, uv at consecutive locations
+    static VkVertexInputBindingDescription GetBindingDescription(uint32_t binding);
+    static void GetAttributeDescriptions(uint32_t binding, uint32_t firstLocation,
+                                         VkVertexInputAttributeDescription attributes[4]);
+};
+
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must match its attribute descriptions");
+
+// tangents (w the bitangent sign) and uvs may be null, they pack as +x and 0 then
+void PackVertices(const VertexQuantization &quantization, const glm::vec3 *positions, const glm::vec3 *normals,
+                  const glm::vec4 *tangents, const glm::vec2 *uvs, size_t count, PackedVertex *out);
+void UnpackVertex(const VertexQuantization &quantization, const PackedVertex &vertex, glm::vec3 *position,
+                  glm::vec3 *normal, glm::vec4 *tangent, glm::vec2 *uv);
+
+#endif // VULKAN_CORE_VERTEX_FORMATS_H
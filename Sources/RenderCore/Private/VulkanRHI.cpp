@@ -2,20 +2,85 @@
 #include "VulkanRHI.hpp"
 
 #include <assert.h>
+#include <ctype.h>
 #include <iostream>
+#include <string.h>
 #include <vulkan/vulkan_metal.h>
 
+#include "CpuProfiler.hpp"
+#include "FlightRecorder.hpp"
+#include "HostAllocator.hpp"
+#include "Log.hpp"
 #include "Utils.hpp"
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
-#include "spdlog/spdlog.h"
 
-VulkanRHI::VulkanRHI() : caMetalLayer(nullptr)
+VulkanRHI::VulkanRHI()
+    : caMetalLayer(nullptr), m_surface(VK_NULL_HANDLE), m_appShortName(nullptr), m_inst(VK_NULL_HANDLE),
+      m_instanceLayerPropertiesQueried(false), m_instanceExtensionPropertiesQueried(false),
+      m_deviceExtensionPropertiesQueried(false), m_gpu(VK_NULL_HANDLE), m_gpuIndex(0), m_graphicsQueueIndex(0),
+      m_graphicsQueue(VK_NULL_HANDLE), m_presentQueue(VK_NULL_HANDLE), m_enabledFeatures(), m_device(VK_NULL_HANDLE),
+      m_cmdPool(VK_NULL_HANDLE), m_cmdBuffer(VK_NULL_HANDLE), m_swapChain(VK_NULL_HANDLE), m_swapChainImageCount(0),
+      m_currentSwapChainBuffer(0), mPipelineLayout(VK_NULL_HANDLE), mRenderPass(VK_NULL_HANDLE)
 {
+    m_depthBuf.image = VK_NULL_HANDLE;
+    m_depthBuf.mem = VK_NULL_HANDLE;
+    m_depthBuf.view = VK_NULL_HANDLE;
+    mUniformData.buf = VK_NULL_HANDLE;
+    mUniformData.mem = VK_NULL_HANDLE;
+    mUniformMapped = nullptr;
+    mUniformStride = 0;
 }
 
 VulkanRHI::~VulkanRHI()
 {
+    // the device and instance may outlive this context, release only what it created itself
+    if (m_device != VK_NULL_HANDLE)
+    {
+        // only this context's queue, vkDeviceWaitIdle would need every queue of a shared device
+        // locked; the queue lock keeps other contexts on it from submitting meanwhile
+        if (m_graphicsQueue != VK_NULL_HANDLE)
+        {
+            std::lock_guard<std::mutex> lock(GetQueueMutex());
+            vkQueueWaitIdle(m_graphicsQueue);
+        }
+
+        m_gpuProfiler.Destroy();
+        m_gpuCuller.Destroy();
+        mInstanceStream.Destroy();
+        mOceanSurface.Destroy();
+        mOcean.Destroy();
+        vkDestroyRenderPass(m_device, mRenderPass, VK_ALLOCATOR(VK_OBJECT_TYPE_RENDER_PASS));
+        vkDestroyPipelineLayout(m_device, mPipelineLayout, VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT));
+        for (auto layout : mDescLayout)
+        {
+            vkDestroyDescriptorSetLayout(m_device, layout, VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT));
+        }
+        if (mUniformMapped != nullptr)
+        {
+            vkUnmapMemory(m_device, mUniformData.mem);
+        }
+        vkDestroyBuffer(m_device, mUniformData.buf, VK_ALLOCATOR(VK_OBJECT_TYPE_BUFFER));
+        FLIGHT_RECORD(FlightEventType::Free, 0, (uint64_t)mUniformData.mem, mUniformData.memSize);
+        vkFreeMemory(m_device, mUniformData.mem, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        vkDestroyImageView(m_device, m_depthBuf.view, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW));
+        vkDestroyImage(m_device, m_depthBuf.image, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE));
+        FLIGHT_RECORD(FlightEventType::Free, 0, (uint64_t)m_depthBuf.mem, m_depthBuf.memSize);
+        vkFreeMemory(m_device, m_depthBuf.mem, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY));
+        for (auto &buffer : m_swapChainBuffers)
+        {
+            vkDestroyImageView(m_device, buffer.view, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW));
+        }
+        vkDestroySwapchainKHR(m_device, m_swapChain, VK_ALLOCATOR(VK_OBJECT_TYPE_SWAPCHAIN_KHR));
+        vkDestroyCommandPool(m_device, m_cmdPool, VK_ALLOCATOR(VK_OBJECT_TYPE_COMMAND_POOL));
+    }
+
+    // the window system creates the surface without callbacks, so it is destroyed without them
+    if (m_surface != VK_NULL_HANDLE)
+    {
+        vkDestroySurfaceKHR(m_inst, m_surface, nullptr);
+    }
+
 #ifdef VK_USE_PLATFORM_METAL_EXT
     destoryWindow();
 #endif
@@ -23,7 +88,8 @@ VulkanRHI::~VulkanRHI()
 
 void VulkanRHI::Init()
 {
-    initGlobalLayerProperties();
+    STARTUP_PHASE(m_startupProfiler, "Init");
+    CPU_ZONE("VulkanRHI::Init");
     initInstanceExtensionNames();
     initDeviceExtensionNames();
     initInstance();
@@ -32,12 +98,35 @@ void VulkanRHI::Init()
 }
 
 void VulkanRHI::Init2()
+{
+    {
+        STARTUP_PHASE(m_startupProfiler, "Init2");
+        CPU_ZONE("VulkanRHI::Init2");
+        init2();
+    }
+
+    m_startupProfiler.SetAttribute("device", m_gpuProps.deviceName);
+    m_startupProfiler.SetAttribute("driverVersion", std::to_string(m_gpuProps.driverVersion));
+    m_startupProfiler.SetAttribute("apiVersion", std::to_string(VK_VERSION_MAJOR(m_gpuProps.apiVersion)) + "." +
+                                                     std::to_string(VK_VERSION_MINOR(m_gpuProps.apiVersion)) + "." +
+                                                     std::to_string(VK_VERSION_PATCH(m_gpuProps.apiVersion)));
+    m_startupProfiler.SetAttribute("headerVersion", std::to_string(VK_HEADER_VERSION));
+    RC_INFO("{}", m_startupProfiler.ToLogLine());
+    RC_INFO("{}", HostAllocator::Instance().ToReport());
+}
+
+void VulkanRHI::init2()
 {
     initSwapchainExtension();
     initDevice();
+    initDeviceQueue();
+    initGpuProfiler();
     initCommandPool();
     initCommandBuffer();
-    initSwapChain(VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    if (m_surface != VK_NULL_HANDLE)
+    {
+        initSwapChain(VkImageUsageFlagBits::VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+    }
     initDepthBuffer();
     initUniformBuffer();
     initDescriptorAndPipelineLayouts();
@@ -52,10 +141,64 @@ void VulkanRHI::Init(void *view)
 }
 #endif
 
+std::shared_ptr<VulkanRHI> VulkanRHI::CreateContext(bool shareDevice, const std::string &preferredDevice)
+{
+    RC_INFO("CreateContext shareDevice: {}", shareDevice);
+    CPU_ZONE("VulkanRHI::CreateContext");
+
+    if (!m_sharedInstance || !m_sharedDevice)
+    {
+        PANIC("CreateContext called before Init2");
+    }
+
+    auto context = std::make_shared<VulkanRHI>();
+    context->m_appShortName = m_appShortName;
+    context->m_sharedInstance = m_sharedInstance;
+    context->m_inst = m_inst;
+    context->m_instanceLayerNames = m_instanceLayerNames;
+    context->m_instanceExtensionNames = m_instanceExtensionNames;
+    context->m_deviceExtensionNames = m_deviceExtensionNames;
+    context->m_optionalDeviceExtensionNames = m_optionalDeviceExtensionNames;
+    context->m_gpus = m_gpus;
+    context->mWidth = mWidth;
+    context->mHeight = mHeight;
+
+    if (shareDevice)
+    {
+        context->m_sharedDevice = m_sharedDevice;
+        context->m_enabledDeviceExtensionNames = m_enabledDeviceExtensionNames;
+        context->m_enabledFeatures = m_enabledFeatures;
+        context->m_gpu = m_gpu;
+        context->m_gpuIndex = m_gpuIndex;
+    }
+    else
+    {
+        context->m_preferredDevice = preferredDevice;
+        context->selectPhysicalDevice();
+    }
+    context->initPhysicalDeviceProperties();
+
+    // no surface, so Init2 sets the context up for offscreen rendering
+    context->Init2();
+    return context;
+}
+
+std::mutex &VulkanRHI::GetQueueMutex()
+{
+    return m_sharedDevice->queueMutexes[m_graphicsQueueIndex];
+}
+
 void VulkanRHI::initGlobalLayerProperties()
 {
+    if (m_instanceLayerPropertiesQueried)
+    {
+        return;
+    }
+    m_instanceLayerPropertiesQueried = true;
+
     // LOG("initGlobalLayerProperties");
-    spdlog::info("initGlobalLayerProperties");
+    RC_INFO("initGlobalLayerProperties");
+    STARTUP_PHASE(m_startupProfiler, "initGlobalLayerProperties");
 
     uint32_t instance_layer_count;
     std::vector<VkLayerProperties> vk_props;
@@ -75,107 +218,280 @@ void VulkanRHI::initGlobalLayerProperties()
         res = vkEnumerateInstanceLayerProperties(&instance_layer_count, vk_props.data());
     } while (res == VK_INCOMPLETE);
 
+    // extensions of each layer are enumerated on demand, see findInstanceLayer
     for (auto prop : vk_props)
     {
         layerProperties layer_props;
         layer_props.properties = prop;
-        initGlobalExtensionProperties(layer_props);
         m_instanceLayerProperties.push_back(layer_props);
-
-        spdlog::info("LayerName: {}", layer_props.properties.layerName);
-        // LOG(("LayerName: " + std::string(layer_props.properties.layerName)).c_str());
-        for (auto ep : layer_props.instanceExtensions)
-        {
-            spdlog::info("instance extension: {}", ep.extensionName);
-            // LOG(("instance extension:" + std::string(ep.extensionName)).c_str());
-        }
-        for (auto ep : layer_props.deviceExtensions)
-        {
-            spdlog::info("device extension: {}", ep.extensionName);
-            // LOG(("device extension:" + std::string(ep.extensionName)).c_str());
-        }
     }
 }
 
 void VulkanRHI::initGlobalExtensionProperties(layerProperties &layer_props)
 {
-    spdlog::info("initGlobalExtensionProperties");
-    // LOG("initGlobalExtensionProperties");
+    if (layer_props.instanceExtensionsQueried)
+    {
+        return;
+    }
+    layer_props.instanceExtensionsQueried = true;
+
+    RC_DEBUG("initGlobalExtensionProperties: {}", layer_props.properties.layerName);
+    enumerateInstanceExtensions(layer_props.properties.layerName, layer_props.instanceExtensions);
+}
 
-    VkExtensionProperties *instance_extensions;
+void VulkanRHI::enumerateInstanceExtensions(const char *layerName, std::vector<VkExtensionProperties> &extensions)
+{
     uint32_t instance_extension_count;
     VkResult res;
-    char *layer_name = nullptr;
 
-    layer_name = layer_props.properties.layerName;
     do
     {
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, nullptr);
+        res = vkEnumerateInstanceExtensionProperties(layerName, &instance_extension_count, nullptr);
         PANIC_IF_NOT_SUCCESS(res);
 
         if (instance_extension_count == 0)
         {
+            extensions.clear();
             return;
         }
 
-        layer_props.instanceExtensions.resize(instance_extension_count);
-        instance_extensions = layer_props.instanceExtensions.data();
-
-        res = vkEnumerateInstanceExtensionProperties(layer_name, &instance_extension_count, instance_extensions);
+        extensions.resize(instance_extension_count);
+        res = vkEnumerateInstanceExtensionProperties(layerName, &instance_extension_count, extensions.data());
     } while (res == VK_INCOMPLETE);
 
     PANIC_IF_NOT_SUCCESS(res);
+    extensions.resize(instance_extension_count);
 }
 
 void VulkanRHI::initInstanceExtensionNames()
 {
     // LOG("initInstanceExtensionNames");
-    spdlog::info("initInstanceExtensionNames");
+    RC_INFO("initInstanceExtensionNames");
+    STARTUP_PHASE(m_startupProfiler, "initInstanceExtensionNames");
 
     m_instanceExtensionNames.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef VK_USE_PLATFORM_METAL_EXT
     m_instanceExtensionNames.push_back(VK_EXT_METAL_SURFACE_EXTENSION_NAME);
 #endif
+    // optional, VkPhysicalDeviceIDProperties gives the device uuid a preferred device is matched by
+    if (isInstanceExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) &&
+        isInstanceExtensionSupported(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME))
+    {
+        m_instanceExtensionNames.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        m_instanceExtensionNames.push_back(VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME);
+    }
+
+    for (auto name : m_instanceLayerNames)
+    {
+        if (findInstanceLayer(name) == nullptr)
+        {
+            RC_WARN("instance layer {} is not available", name);
+        }
+    }
+
+    for (auto name : m_instanceExtensionNames)
+    {
+        if (!isInstanceExtensionSupported(name))
+        {
+            RC_WARN("instance extension {} is not supported", name);
+        }
+    }
 }
 
 void VulkanRHI::initDeviceExtensionNames()
 {
-    spdlog::info("initDeviceExtensionNames");
+    RC_INFO("initDeviceExtensionNames");
+    STARTUP_PHASE(m_startupProfiler, "initDeviceExtensionNames");
     // LOG("initDeviceExtensionNames");
     m_deviceExtensionNames.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    m_optionalDeviceExtensionNames.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+    m_optionalDeviceExtensionNames.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
 }
 
 void VulkanRHI::initDeviceExtensionProperties(layerProperties &layer_props)
 {
-    spdlog::info("initDeviceExtensionProperties");
-    // LOG("initDeviceExtensionProperties");
+    if (layer_props.deviceExtensionsQueried)
+    {
+        return;
+    }
+    layer_props.deviceExtensionsQueried = true;
 
-    VkExtensionProperties *device_extensions;
+    RC_DEBUG("initDeviceExtensionProperties: {}", layer_props.properties.layerName);
+    enumerateDeviceExtensions(m_gpu, layer_props.properties.layerName, layer_props.deviceExtensions);
+}
+
+void VulkanRHI::enumerateDeviceExtensions(VkPhysicalDevice gpu, const char *layerName,
+                                          std::vector<VkExtensionProperties> &extensions)
+{
     uint32_t device_extension_count;
     VkResult res;
-    char *layer_name = nullptr;
-
-    layer_name = layer_props.properties.layerName;
 
     do
     {
-        res = vkEnumerateDeviceExtensionProperties(m_gpus[0], layer_name, &device_extension_count, nullptr);
+        res = vkEnumerateDeviceExtensionProperties(gpu, layerName, &device_extension_count, nullptr);
         PANIC_IF_NOT_SUCCESS(res);
 
         if (device_extension_count == 0)
         {
+            extensions.clear();
             return;
         }
 
-        layer_props.deviceExtensions.resize(device_extension_count);
-        device_extensions = layer_props.deviceExtensions.data();
-        res = vkEnumerateDeviceExtensionProperties(m_gpus[0], layer_name, &device_extension_count, device_extensions);
+        extensions.resize(device_extension_count);
+        res = vkEnumerateDeviceExtensionProperties(gpu, layerName, &device_extension_count, extensions.data());
     } while (res == VK_INCOMPLETE);
+
+    PANIC_IF_NOT_SUCCESS(res);
+    extensions.resize(device_extension_count);
+}
+
+layerProperties *VulkanRHI::findInstanceLayer(const char *layerName)
+{
+    initGlobalLayerProperties();
+
+    for (auto &layer_props : m_instanceLayerProperties)
+    {
+        if (strcmp(layer_props.properties.layerName, layerName) == 0)
+        {
+            return &layer_props;
+        }
+    }
+    return nullptr;
+}
+
+bool VulkanRHI::isInstanceExtensionSupported(const char *extensionName)
+{
+    if (!m_instanceExtensionPropertiesQueried)
+    {
+        m_instanceExtensionPropertiesQueried = true;
+        enumerateInstanceExtensions(nullptr, m_instanceExtensionProperties);
+    }
+
+    for (auto &ep : m_instanceExtensionProperties)
+    {
+        if (strcmp(ep.extensionName, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+
+    // extensions may also come from the layers we enable, but not from any other layer
+    for (auto name : m_instanceLayerNames)
+    {
+        layerProperties *layer_props = findInstanceLayer(name);
+        if (layer_props == nullptr)
+        {
+            continue;
+        }
+
+        initGlobalExtensionProperties(*layer_props);
+        for (auto &ep : layer_props->instanceExtensions)
+        {
+            if (strcmp(ep.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool VulkanRHI::isDeviceExtensionSupported(const char *extensionName)
+{
+    if (!m_deviceExtensionPropertiesQueried)
+    {
+        m_deviceExtensionPropertiesQueried = true;
+        enumerateDeviceExtensions(m_gpu, nullptr, m_deviceExtensionProperties);
+    }
+
+    for (auto &ep : m_deviceExtensionProperties)
+    {
+        if (strcmp(ep.extensionName, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+
+    for (auto name : m_instanceLayerNames)
+    {
+        layerProperties *layer_props = findInstanceLayer(name);
+        if (layer_props == nullptr)
+        {
+            continue;
+        }
+
+        initDeviceExtensionProperties(*layer_props);
+        for (auto &ep : layer_props->deviceExtensions)
+        {
+            if (strcmp(ep.extensionName, extensionName) == 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+const StartupProfiler &VulkanRHI::GetStartupProfiler() const
+{
+    return m_startupProfiler;
+}
+
+bool VulkanRHI::WriteStartupReport(const std::string &path) const
+{
+    return m_startupProfiler.WriteJson(path);
+}
+
+Camera &VulkanRHI::GetCamera()
+{
+    return mCamera;
+}
+
+void VulkanRHI::UpdateUniforms(uint32_t frameIndex)
+{
+    uint32_t slot = frameIndex % MaxFramesInFlight;
+    if (mUniformMapped == nullptr || mUniformVersions[slot] == mCamera.GetVersion())
+    {
+        return;
+    }
+    mCamera.WriteMVP(mUniformMapped + GetUniformOffset(slot));
+    mUniformVersions[slot] = mCamera.GetVersion();
+}
+
+uint32_t VulkanRHI::GetUniformOffset(uint32_t frameIndex) const
+{
+    return (frameIndex % MaxFramesInFlight) * mUniformStride;
+}
+
+void VulkanRHI::DumpCapabilities()
+{
+    RC_INFO("DumpCapabilities");
+
+    initGlobalLayerProperties();
+    for (auto &layer_props : m_instanceLayerProperties)
+    {
+        initGlobalExtensionProperties(layer_props);
+        if (m_gpu != VK_NULL_HANDLE)
+        {
+            initDeviceExtensionProperties(layer_props);
+        }
+
+        RC_INFO("LayerName: {}", layer_props.properties.layerName);
+        for (auto &ep : layer_props.instanceExtensions)
+        {
+            RC_INFO("instance extension: {}", ep.extensionName);
+        }
+        for (auto &ep : layer_props.deviceExtensions)
+        {
+            RC_INFO("device extension: {}", ep.extensionName);
+        }
+    }
 }
 
 void VulkanRHI::initInstance()
 {
-    spdlog::info("initInstance");
+    RC_INFO("initInstance");
+    STARTUP_PHASE(m_startupProfiler, "initInstance");
     // LOG("initInstance");
 
     // initialize the VkApplicationInfo structure
@@ -199,44 +515,282 @@ void VulkanRHI::initInstance()
     instInfo.enabledExtensionCount = (uint32_t)(m_instanceExtensionNames.size());
     instInfo.ppEnabledExtensionNames = m_instanceExtensionNames.data();
 
-    VkResult res = vkCreateInstance(&instInfo, nullptr, &m_inst);
+    VkResult res;
+    {
+        STARTUP_PHASE(m_startupProfiler, "vkCreateInstance");
+        res = vkCreateInstance(&instInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_INSTANCE), &m_inst);
+    }
     PANIC_IF_NOT_SUCCESS(res);
+
+    m_sharedInstance = std::make_shared<SharedInstance>();
+    m_sharedInstance->inst = m_inst;
 }
 
 void VulkanRHI::initEnumerateDevice()
 {
-    spdlog::info("initEnumerateDevice");
+    RC_INFO("initEnumerateDevice");
+    STARTUP_PHASE(m_startupProfiler, "initEnumerateDevice");
     // LOG("initEnumerateDevice");
 
     VkResult res;
     uint32_t gpu_count;
-    res = vkEnumeratePhysicalDevices(m_inst, &gpu_count, NULL);
-    assert(gpu_count);
+    {
+        STARTUP_PHASE(m_startupProfiler, "vkEnumeratePhysicalDevices");
+        res = vkEnumeratePhysicalDevices(m_inst, &gpu_count, NULL);
+        assert(gpu_count);
 
-    m_gpus.resize(gpu_count);
-    res = vkEnumeratePhysicalDevices(m_inst, &gpu_count, m_gpus.data());
-    spdlog::info("gpu_count: {}", gpu_count);
+        m_gpus.resize(gpu_count);
+        res = vkEnumeratePhysicalDevices(m_inst, &gpu_count, m_gpus.data());
+    }
+    RC_INFO("gpu_count: {}", gpu_count);
     // LOG(("gpu_count:" + std::to_string(gpu_count)).c_str());
 
-    vkGetPhysicalDeviceQueueFamilyProperties(m_gpus[0], &m_queueFamilyCount, nullptr);
+    selectPhysicalDevice();
+    initPhysicalDeviceProperties();
+}
+
+void VulkanRHI::initPhysicalDeviceProperties()
+{
+    vkGetPhysicalDeviceQueueFamilyProperties(m_gpu, &m_queueFamilyCount, nullptr);
     assert(m_queueFamilyCount);
     m_queueProps.resize(m_queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(m_gpus[0], &m_queueFamilyCount, m_queueProps.data());
+    vkGetPhysicalDeviceQueueFamilyProperties(m_gpu, &m_queueFamilyCount, m_queueProps.data());
 
-    vkGetPhysicalDeviceMemoryProperties(m_gpus[0], &m_memoryProperties);
-    vkGetPhysicalDeviceProperties(m_gpus[0], &m_gpuProps);
-    spdlog::info("use gpu0: {}", m_gpuProps.deviceName);
+    vkGetPhysicalDeviceMemoryProperties(m_gpu, &m_memoryProperties);
+    vkGetPhysicalDeviceProperties(m_gpu, &m_gpuProps);
+    RC_INFO("use gpu{}: {}", m_gpuIndex, m_gpuProps.deviceName);
     // LOG(("use gpu0: " + std::string(m_gpuProps.deviceName)).c_str());
+}
 
-    for (auto &layer_props : m_instanceLayerProperties)
+void VulkanRHI::SetPreferredDevice(const std::string &nameOrUuid)
+{
+    m_preferredDevice = nameOrUuid;
+}
+
+const std::vector<DeviceScore> &VulkanRHI::GetDeviceScores() const
+{
+    return m_deviceScores;
+}
+
+static std::string GetDeviceUuidString(const uint8_t uuid[VK_UUID_SIZE])
+{
+    static const char *digits = "0123456789abcdef";
+    std::string hex;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+    {
+        hex += digits[uuid[i] >> 4];
+        hex += digits[uuid[i] & 0xf];
+    }
+    return hex;
+}
+
+static bool MatchesPreferredDevice(const VkPhysicalDeviceProperties &props, const std::string &uuid,
+                                   const std::string &preferred)
+{
+    if (preferred.empty())
+    {
+        return false;
+    }
+
+    std::string lowered;
+    for (char c : preferred)
+    {
+        if (c != '-')
+        {
+            lowered += static_cast<char>(tolower(static_cast<unsigned char>(c)));
+        }
+    }
+    if (!uuid.empty() && lowered == uuid)
+    {
+        return true;
+    }
+    return std::string(props.deviceName).find(preferred) != std::string::npos;
+}
+
+std::string VulkanRHI::getDeviceUuid(VkPhysicalDevice gpu)
+{
+    // deviceUUID names the gpu itself and survives driver updates, unlike pipelineCacheUUID which is
+    // shared by every gpu of a model; empty when the instance has no vkGetPhysicalDeviceProperties2
+    PFN_vkGetPhysicalDeviceProperties2KHR getProperties2 = nullptr;
+    for (auto name : m_instanceExtensionNames)
+    {
+        if (strcmp(name, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0)
+        {
+            getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+                vkGetInstanceProcAddr(m_inst, "vkGetPhysicalDeviceProperties2KHR"));
+        }
+    }
+    if (getProperties2 == nullptr)
+    {
+        return std::string();
+    }
+
+    VkPhysicalDeviceIDPropertiesKHR idProps = {};
+    idProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR;
+    VkPhysicalDeviceProperties2KHR props = {};
+    props.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+    props.pNext = &idProps;
+    getProperties2(gpu, &props);
+    return GetDeviceUuidString(idProps.deviceUUID);
+}
+
+int64_t VulkanRHI::scorePhysicalDevice(VkPhysicalDevice gpu, DeviceScore &score)
+{
+    VkPhysicalDeviceProperties props;
+    vkGetPhysicalDeviceProperties(gpu, &props);
+    score.name = props.deviceName;
+    score.uuid = getDeviceUuid(gpu);
+    score.deviceType = props.deviceType;
+
+    // a device without a graphics queue or without our extensions cannot be used at all
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueProps(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(gpu, &queueFamilyCount, queueProps.data());
+
+    bool hasGraphics = false;
+    bool hasAsyncCompute = false;
+    bool hasTransfer = false;
+    for (auto &qp : queueProps)
+    {
+        if (qp.queueFlags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            hasGraphics = true;
+        }
+        else if (qp.queueFlags & VK_QUEUE_COMPUTE_BIT)
+        {
+            hasAsyncCompute = true;
+        }
+        else if (qp.queueFlags & VK_QUEUE_TRANSFER_BIT)
+        {
+            hasTransfer = true;
+        }
+    }
+    if (!hasGraphics)
+    {
+        score.rejectReason = "no graphics queue";
+        return -1;
+    }
+
+    std::vector<VkExtensionProperties> extensions;
+    enumerateDeviceExtensions(gpu, nullptr, extensions);
+    for (auto name : m_deviceExtensionNames)
+    {
+        bool found = false;
+        for (auto &ep : extensions)
+        {
+            if (strcmp(ep.extensionName, name) == 0)
+            {
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+        {
+            score.rejectReason = std::string("missing ") + name;
+            return -1;
+        }
+    }
+
+    int64_t total = 0;
+    switch (props.deviceType)
+    {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        total += 10000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        total += 5000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        total += 2000;
+        break;
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        total += 0;
+        break;
+    default:
+        total += 1000;
+        break;
+    }
+
+    // one point per 64MB of device local memory, integrated gpus report shared memory here as well
+    VkPhysicalDeviceMemoryProperties memoryProps;
+    vkGetPhysicalDeviceMemoryProperties(gpu, &memoryProps);
+    VkDeviceSize deviceLocalSize = 0;
+    for (uint32_t i = 0; i < memoryProps.memoryHeapCount; i++)
+    {
+        if (memoryProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            deviceLocalSize += memoryProps.memoryHeaps[i].size;
+        }
+    }
+    score.deviceLocalMB = static_cast<uint64_t>(deviceLocalSize >> 20);
+    total += static_cast<int64_t>(score.deviceLocalMB / 64);
+
+    if (hasAsyncCompute)
+    {
+        total += 200;
+    }
+    if (hasTransfer)
+    {
+        total += 100;
+    }
+
+    if (MatchesPreferredDevice(props, score.uuid, m_preferredDevice))
     {
-        initDeviceExtensionProperties(layer_props);
+        score.preferred = true;
+        total += 1000000;
     }
+    return total;
+}
+
+void VulkanRHI::selectPhysicalDevice()
+{
+    m_deviceScores.clear();
+
+    int64_t bestScore = -1;
+    for (uint32_t i = 0; i < m_gpus.size(); i++)
+    {
+        DeviceScore score;
+        score.index = i;
+        score.score = scorePhysicalDevice(m_gpus[i], score);
+        std::string summary = score.name + " score=" + std::to_string(score.score);
+        if (score.preferred)
+        {
+            summary += " preferred";
+        }
+        if (!score.rejectReason.empty())
+        {
+            summary += " " + score.rejectReason;
+        }
+        RC_INFO("gpu{}: {}", i, summary);
+        m_startupProfiler.SetAttribute("gpu" + std::to_string(i), summary);
+
+        if (score.score > bestScore)
+        {
+            bestScore = score.score;
+            m_gpuIndex = i;
+        }
+        m_deviceScores.push_back(score);
+    }
+
+    if (bestScore < 0)
+    {
+        PANIC("No physical device supports the required queues and extensions");
+    }
+
+    if (!m_preferredDevice.empty() && !m_deviceScores[m_gpuIndex].preferred)
+    {
+        RC_WARN("preferred device {} not found or not usable", m_preferredDevice);
+    }
+
+    m_gpu = m_gpus[m_gpuIndex];
+    m_startupProfiler.SetAttribute("selectedGpu", std::to_string(m_gpuIndex));
 }
 
 void VulkanRHI::initWindowSize()
 {
-    spdlog::info("initWindowSize");
+    RC_INFO("initWindowSize");
+    STARTUP_PHASE(m_startupProfiler, "initWindowSize");
     // LOG("initWindowSize");
 
     mWidth = 500;
@@ -245,7 +799,8 @@ void VulkanRHI::initWindowSize()
 
 void VulkanRHI::initSwapchainExtension()
 {
-    spdlog::info("initSwapchainExtension");
+    RC_INFO("initSwapchainExtension");
+    STARTUP_PHASE(m_startupProfiler, "initSwapchainExtension");
     // LOG("initSwapchainExtension");
 
     VkResult res;
@@ -259,13 +814,19 @@ void VulkanRHI::initSwapchainExtension()
     //     PANIC_IF_NOT_SUCCESS(res);
     // #endif
 
+    if (m_surface == VK_NULL_HANDLE)
+    {
+        initHeadlessQueueFamily();
+        return;
+    }
+
     // search graphics and present queue
     // VkBool32 *pSupportsPresent = (VkBool32 *)malloc(queueFamilyCount * sizeof(VkBool32));
     std::vector<VkBool32> supportsPresent;
     supportsPresent.resize(m_queueFamilyCount);
     for (uint32_t i = 0; i < m_queueFamilyCount; ++i)
     {
-        vkGetPhysicalDeviceSurfaceSupportKHR(m_gpus[0], i, m_surface, &supportsPresent[i]);
+        vkGetPhysicalDeviceSurfaceSupportKHR(m_gpu, i, m_surface, &supportsPresent[i]);
     }
 
     m_graphicsQueueFamilyIndex = UINT32_MAX;
@@ -301,16 +862,16 @@ void VulkanRHI::initSwapchainExtension()
 
     if (m_graphicsQueueFamilyIndex == UINT32_MAX || m_presentQueueFamilyIndex == UINT32_MAX)
     {
-        // spdlog::error("Could not find a queues for both graphics and present");
+        // RC_ERROR("Could not find a queues for both graphics and present");
         PANIC("Could not find a queues for both graphics and present");
     }
 
     uint32_t formatCount;
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(m_gpus[0], m_surface, &formatCount, nullptr);
+    res = vkGetPhysicalDeviceSurfaceFormatsKHR(m_gpu, m_surface, &formatCount, nullptr);
     PANIC_IF_NOT_SUCCESS(res);
     std::vector<VkSurfaceFormatKHR> surfFormats;
     surfFormats.resize(formatCount);
-    res = vkGetPhysicalDeviceSurfaceFormatsKHR(m_gpus[0], m_surface, &formatCount, surfFormats.data());
+    res = vkGetPhysicalDeviceSurfaceFormatsKHR(m_gpu, m_surface, &formatCount, surfFormats.data());
     PANIC_IF_NOT_SUCCESS(res);
 
     assert(formatCount > 0);
@@ -326,19 +887,82 @@ void VulkanRHI::initSwapchainExtension()
     surfFormats.clear();
 }
 
+void VulkanRHI::initHeadlessQueueFamily()
+{
+    // offscreen contexts only need a graphics queue, and must use the family of a shared device
+    m_graphicsQueueFamilyIndex = UINT32_MAX;
+    if (m_sharedDevice)
+    {
+        m_graphicsQueueFamilyIndex = m_sharedDevice->queueFamilyIndex;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < m_queueFamilyCount; i++)
+        {
+            if ((m_queueProps[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0)
+            {
+                m_graphicsQueueFamilyIndex = i;
+                break;
+            }
+        }
+    }
+
+    if (m_graphicsQueueFamilyIndex == UINT32_MAX)
+    {
+        PANIC("Could not find a graphics queue");
+    }
+    m_presentQueueFamilyIndex = m_graphicsQueueFamilyIndex;
+    m_format = VK_FORMAT_B8G8R8A8_UNORM;
+}
+
 void VulkanRHI::initDevice()
 {
-    spdlog::info("initDevice");
+    RC_INFO("initDevice");
+    STARTUP_PHASE(m_startupProfiler, "initDevice");
     // LOG("initDevice");
 
     VkResult res;
 
+    if (m_sharedDevice)
+    {
+        m_device = m_sharedDevice->device;
+        return;
+    }
+
+    m_enabledDeviceExtensionNames = m_deviceExtensionNames;
+    for (auto name : m_deviceExtensionNames)
+    {
+        if (!isDeviceExtensionSupported(name))
+        {
+            RC_WARN("device extension {} is not supported", name);
+        }
+    }
+    for (auto name : m_optionalDeviceExtensionNames)
+    {
+        if (isDeviceExtensionSupported(name))
+        {
+            m_enabledDeviceExtensionNames.push_back(name);
+        }
+    }
+
+    // optional features, only turned on when the device has them
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_gpu, &supportedFeatures);
+    m_enabledFeatures = {};
+    m_enabledFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    m_enabledFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    m_enabledFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    m_enabledFeatures.tessellationShader = supportedFeatures.tessellationShader;
+
+    // take every queue of the family so contexts sharing this device get their own queue
+    uint32_t queueCount = m_queueProps[m_graphicsQueueFamilyIndex].queueCount;
+    std::vector<float> queuePriorities(queueCount, 0.0f);
+
     VkDeviceQueueCreateInfo queueInfo = {};
-    float queuePriorities[1] = {0.0};
     queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueInfo.pNext = nullptr;
-    queueInfo.queueCount = 1;
-    queueInfo.pQueuePriorities = queuePriorities;
+    queueInfo.queueCount = queueCount;
+    queueInfo.pQueuePriorities = queuePriorities.data();
     queueInfo.queueFamilyIndex = m_graphicsQueueFamilyIndex;
 
     VkDeviceCreateInfo deviceInfo = {};
@@ -346,17 +970,31 @@ void VulkanRHI::initDevice()
     deviceInfo.pNext = nullptr;
     deviceInfo.queueCreateInfoCount = 1;
     deviceInfo.pQueueCreateInfos = &queueInfo;
-    deviceInfo.enabledExtensionCount = (uint32_t)(m_deviceExtensionNames.size());
-    deviceInfo.ppEnabledExtensionNames = deviceInfo.enabledExtensionCount ? m_deviceExtensionNames.data() : nullptr;
-    deviceInfo.pEnabledFeatures = nullptr;
+    deviceInfo.enabledExtensionCount = (uint32_t)(m_enabledDeviceExtensionNames.size());
+    deviceInfo.ppEnabledExtensionNames =
+        deviceInfo.enabledExtensionCount ? m_enabledDeviceExtensionNames.data() : nullptr;
+    deviceInfo.pEnabledFeatures = &m_enabledFeatures;
 
-    res = vkCreateDevice(m_gpus[0], &deviceInfo, nullptr, &m_device);
+    {
+        STARTUP_PHASE(m_startupProfiler, "vkCreateDevice");
+        res = vkCreateDevice(m_gpu, &deviceInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE), &m_device);
+    }
     PANIC_IF_NOT_SUCCESS(res);
+    FLIGHT_RECORD(FlightEventType::ResourceCreate, VK_OBJECT_TYPE_DEVICE, (uint64_t)m_device);
+
+    m_sharedDevice = std::make_shared<SharedDevice>();
+    m_sharedDevice->instance = m_sharedInstance;
+    m_sharedDevice->device = m_device;
+    m_sharedDevice->gpu = m_gpu;
+    m_sharedDevice->queueFamilyIndex = m_graphicsQueueFamilyIndex;
+    m_sharedDevice->queueCount = queueCount;
+    m_sharedDevice->queueMutexes.reset(new std::mutex[queueCount]);
 }
 
 void VulkanRHI::initCommandPool()
 {
-    spdlog::info("initCommandPool");
+    RC_INFO("initCommandPool");
+    STARTUP_PHASE(m_startupProfiler, "initCommandPool");
     // LOG("initCommandPool");
 
     VkResult res;
@@ -366,13 +1004,14 @@ void VulkanRHI::initCommandPool()
     cmdPoolInfo.queueFamilyIndex = m_graphicsQueueFamilyIndex;
     cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-    res = vkCreateCommandPool(m_device, &cmdPoolInfo, nullptr, &m_cmdPool);
+    res = vkCreateCommandPool(m_device, &cmdPoolInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_COMMAND_POOL), &m_cmdPool);
     PANIC_IF_NOT_SUCCESS(res);
 }
 
 void VulkanRHI::initCommandBuffer()
 {
-    spdlog::info("initCommandBuffer");
+    RC_INFO("initCommandBuffer");
+    STARTUP_PHASE(m_startupProfiler, "initCommandBuffer");
     // LOG("initCommandBuffer");
 
     VkResult res;
@@ -403,8 +1042,11 @@ void VulkanRHI::executeBeginCommandBuffer()
 
 void VulkanRHI::initDeviceQueue()
 {
-    spdlog::info("initDeviceQueue");
-    vkGetDeviceQueue(m_device, m_graphicsQueueFamilyIndex, 0, &m_graphicsQueue);
+    RC_INFO("initDeviceQueue");
+    STARTUP_PHASE(m_startupProfiler, "initDeviceQueue");
+
+    m_graphicsQueueIndex = m_sharedDevice->AcquireQueueIndex();
+    vkGetDeviceQueue(m_device, m_graphicsQueueFamilyIndex, m_graphicsQueueIndex, &m_graphicsQueue);
     if (m_graphicsQueueFamilyIndex == m_presentQueueFamilyIndex)
     {
         m_presentQueue = m_graphicsQueue;
@@ -415,17 +1057,104 @@ void VulkanRHI::initDeviceQueue()
     }
 }
 
+void VulkanRHI::initGpuProfiler()
+{
+    RC_INFO("initGpuProfiler");
+    STARTUP_PHASE(m_startupProfiler, "initGpuProfiler");
+
+    m_gpuProfiler.Init(m_inst, m_gpu, m_device, m_queueProps[m_graphicsQueueFamilyIndex].timestampValidBits,
+                       m_gpuProps.limits.timestampPeriod,
+                       IsDeviceExtensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME),
+                       m_enabledFeatures.pipelineStatisticsQuery == VK_TRUE, MaxFramesInFlight);
+}
+
+GpuProfiler &VulkanRHI::GetGpuProfiler()
+{
+    return m_gpuProfiler;
+}
+
+bool VulkanRHI::InitGpuCuller(const GpuCuller::Limits &limits)
+{
+    RC_INFO("InitGpuCuller");
+
+    GpuCuller::Limits clamped = limits;
+    if (clamped.maxDrawsPerBucket > m_gpuProps.limits.maxDrawIndirectCount)
+    {
+        clamped.maxDrawsPerBucket = m_gpuProps.limits.maxDrawIndirectCount;
+    }
+    return m_gpuCuller.Init(m_device, m_memoryProperties, m_enabledFeatures,
+                            IsDeviceExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME), clamped);
+}
+
+GpuCuller &VulkanRHI::GetGpuCuller()
+{
+    return m_gpuCuller;
+}
+
+void VulkanRHI::InitInstanceStream(uint32_t maxInstances)
+{
+    mInstanceStream.Init(m_device, m_memoryProperties, maxInstances, MaxFramesInFlight);
+}
+
+InstanceStream &VulkanRHI::GetInstanceStream()
+{
+    return mInstanceStream;
+}
+
+bool VulkanRHI::InitOcean(const OceanSettings &settings)
+{
+    RC_INFO("InitOcean");
+    return mOcean.Init(m_device, m_memoryProperties, settings);
+}
+
+GpuOcean &VulkanRHI::GetOcean()
+{
+    return mOcean;
+}
+
+void VulkanRHI::InitOceanSurface(const OceanSurface::Settings &settings)
+{
+    mOceanSurface.Init(m_device, m_memoryProperties, m_enabledFeatures, settings, MaxFramesInFlight);
+    if (mOcean.IsEnabled())
+    {
+        mOceanSurface.BindMaps(mOcean);
+        if (mOceanSurface.IsTessellationSupported())
+        {
+            mOcean.AddReaders(VK_PIPELINE_STAGE_TESSELLATION_CONTROL_SHADER_BIT |
+                              VK_PIPELINE_STAGE_TESSELLATION_EVALUATION_SHADER_BIT);
+        }
+    }
+}
+
+OceanSurface &VulkanRHI::GetOceanSurface()
+{
+    return mOceanSurface;
+}
+
+bool VulkanRHI::IsDeviceExtensionEnabled(const char *extensionName) const
+{
+    for (auto name : m_enabledDeviceExtensionNames)
+    {
+        if (strcmp(name, extensionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void VulkanRHI::initSwapChain(VkImageUsageFlags usageFlags)
 {
-    spdlog::info("initSwapChain");
+    RC_INFO("initSwapChain");
+    STARTUP_PHASE(m_startupProfiler, "initSwapChain");
     // LOG("initSwapChain");
     VkResult res;
     VkSurfaceCapabilitiesKHR surfCapabilities;
-    res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_gpus[0], m_surface, &surfCapabilities);
+    res = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_gpu, m_surface, &surfCapabilities);
     PANIC_IF_NOT_SUCCESS(res);
 
     uint32_t presentModeCount;
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(m_gpus[0], m_surface, &presentModeCount, nullptr);
+    res = vkGetPhysicalDeviceSurfacePresentModesKHR(m_gpu, m_surface, &presentModeCount, nullptr);
     PANIC_IF_NOT_SUCCESS(res);
 
     if (presentModeCount == 0)
@@ -435,7 +1164,7 @@ void VulkanRHI::initSwapChain(VkImageUsageFlags usageFlags)
 
     std::vector<VkPresentModeKHR> presentModes;
     presentModes.resize(presentModeCount);
-    res = vkGetPhysicalDeviceSurfacePresentModesKHR(m_gpus[0], m_surface, &presentModeCount, presentModes.data());
+    res = vkGetPhysicalDeviceSurfacePresentModesKHR(m_gpu, m_surface, &presentModeCount, presentModes.data());
     PANIC_IF_NOT_SUCCESS(res);
 
     VkExtent2D swapchainExtent;
@@ -529,8 +1258,12 @@ void VulkanRHI::initSwapChain(VkImageUsageFlags usageFlags)
         swapchainInfo.pQueueFamilyIndices = queueFamilyIndices;
     }
 
-    res = vkCreateSwapchainKHR(m_device, &swapchainInfo, nullptr, &m_swapChain);
+    {
+        STARTUP_PHASE(m_startupProfiler, "vkCreateSwapchainKHR");
+        res = vkCreateSwapchainKHR(m_device, &swapchainInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_SWAPCHAIN_KHR), &m_swapChain);
+    }
     PANIC_IF_NOT_SUCCESS(res);
+    FLIGHT_RECORD(FlightEventType::ResourceCreate, VK_OBJECT_TYPE_SWAPCHAIN_KHR, (uint64_t)m_swapChain);
 
     res = vkGetSwapchainImagesKHR(m_device, m_swapChain, &m_swapChainImageCount, nullptr);
     PANIC_IF_NOT_SUCCESS(res);
@@ -566,7 +1299,7 @@ void VulkanRHI::initSwapChain(VkImageUsageFlags usageFlags)
         swapChainBuf.image = swapChainImages[i];
         imageViewInfo.image = swapChainBuf.image;
 
-        res = vkCreateImageView(m_device, &imageViewInfo, nullptr, &swapChainBuf.view);
+        res = vkCreateImageView(m_device, &imageViewInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW), &swapChainBuf.view);
         PANIC_IF_NOT_SUCCESS(res);
         m_swapChainBuffers.push_back(swapChainBuf);
     }
@@ -581,7 +1314,8 @@ void VulkanRHI::initSwapChain(VkImageUsageFlags usageFlags)
 
 void VulkanRHI::initDepthBuffer()
 {
-    spdlog::info("initDepthBuffer");
+    RC_INFO("initDepthBuffer");
+    STARTUP_PHASE(m_startupProfiler, "initDepthBuffer");
     // LOG("initDepthBuffer");
 
     VkResult res;
@@ -591,13 +1325,13 @@ void VulkanRHI::initDepthBuffer()
 
     if (m_depthBuf.format == VK_FORMAT_UNDEFINED)
     {
-        spdlog::info("depth buffer format: {}, change to: {}", m_depthBuf.format, VK_FORMAT_D16_UNORM);
+        RC_INFO("depth buffer format: {}, change to: {}", m_depthBuf.format, VK_FORMAT_D16_UNORM);
         m_depthBuf.format = VK_FORMAT_D16_UNORM;
     }
 
     const VkFormat depth_format = m_depthBuf.format;
-    spdlog::info("depth buffer format: {}", m_depthBuf.format);
-    vkGetPhysicalDeviceFormatProperties(m_gpus[0], m_depthBuf.format, &props);
+    RC_INFO("depth buffer format: {}", m_depthBuf.format);
+    vkGetPhysicalDeviceFormatProperties(m_gpu, m_depthBuf.format, &props);
     if (props.linearTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
     {
         imageCreateInfo.tiling = VK_IMAGE_TILING_LINEAR;
@@ -609,7 +1343,7 @@ void VulkanRHI::initDepthBuffer()
     else
     {
         /* Try other depth formats? */
-        spdlog::error("depth_format {} unsupported", depth_format);
+        RC_ERROR("depth_format {} unsupported", depth_format);
         // LOG(("depth_format " + std::to_string(depth_format) + " Unsupported").c_str());
         exit(-1);
     }
@@ -663,7 +1397,7 @@ void VulkanRHI::initDepthBuffer()
     VkMemoryRequirements memReqs;
 
     /* Create image */
-    res = vkCreateImage(m_device, &imageCreateInfo, NULL, &m_depthBuf.image);
+    res = vkCreateImage(m_device, &imageCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE), &m_depthBuf.image);
     assert(res == VK_SUCCESS);
 
     vkGetImageMemoryRequirements(m_device, m_depthBuf.image, &memReqs);
@@ -675,8 +1409,11 @@ void VulkanRHI::initDepthBuffer()
     assert(pass);
 
     /* Allocate memory */
-    res = vkAllocateMemory(m_device, &memAllocInfo, NULL, &m_depthBuf.mem);
+    res = vkAllocateMemory(m_device, &memAllocInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY), &m_depthBuf.mem);
     assert(res == VK_SUCCESS);
+    m_depthBuf.memSize = memAllocInfo.allocationSize;
+    FLIGHT_RECORD(FlightEventType::Allocation, memAllocInfo.memoryTypeIndex, (uint64_t)m_depthBuf.mem,
+                  m_depthBuf.memSize);
 
     /* Bind memory */
     res = vkBindImageMemory(m_device, m_depthBuf.image, m_depthBuf.mem, 0);
@@ -684,14 +1421,15 @@ void VulkanRHI::initDepthBuffer()
 
     /* Create image view */
     viewCreateInfo.image = m_depthBuf.image;
-    res = vkCreateImageView(m_device, &viewCreateInfo, NULL, &m_depthBuf.view);
+    res = vkCreateImageView(m_device, &viewCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_IMAGE_VIEW), &m_depthBuf.view);
     assert(res == VK_SUCCESS);
 }
 
 void VulkanRHI::initUniformBuffer()
 {
     // LOG("initUniformBuffer");
-    spdlog::info("initUniformBuffer");
+    RC_INFO("initUniformBuffer");
+    STARTUP_PHASE(m_startupProfiler, "initUniformBuffer");
 
     VkResult res;
     bool pass;
@@ -701,26 +1439,26 @@ void VulkanRHI::initUniformBuffer()
     {
         fov *= static_cast<float>(mHeight) / static_cast<float>(mWidth);
     }
-    mProjection = glm::perspective(fov, static_cast<float>(mHeight) / static_cast<float>(mWidth), 0.1f, 100.0f);
-    mView = glm::lookAt(glm::vec3(-5, 3, -10), glm::vec3(0, 0, 0), glm::vec3(0, -1, 0));
-    mModel = glm::mat4(1.0f);
-    mClip = glm::mat4(
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, -1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 0.5f, 0.0f, 
-        0.0f, 0.0f, 0.5f, 1.0f);
-    mMVP = mClip * mProjection * mView * mModel;
+    mCamera.SetPerspective(fov, static_cast<float>(mHeight) / static_cast<float>(mWidth), 0.1f, 100.0f);
+    mCamera.LookAt(glm::vec3(-5, 3, -10), glm::vec3(0, 0, 0), glm::vec3(0, -1, 0));
+    mCamera.SetModel(glm::mat4(1.0f));
+    mCamera.SetClip(Camera::VulkanClip());
+
+    // one slot per frame in flight so the cpu never writes a slot the gpu may still read
+    VkDeviceSize alignment = m_gpuProps.limits.minUniformBufferOffsetAlignment;
+    alignment = alignment > 0 ? alignment : 1;
+    mUniformStride = static_cast<uint32_t>((sizeof(glm::mat4) + alignment - 1) / alignment * alignment);
 
     VkBufferCreateInfo bufCreateInfo = {};
     bufCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufCreateInfo.pNext = nullptr;
     bufCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-    bufCreateInfo.size = sizeof(mMVP);
+    bufCreateInfo.size = static_cast<VkDeviceSize>(mUniformStride) * MaxFramesInFlight;
     bufCreateInfo.queueFamilyIndexCount = 0;
     bufCreateInfo.pQueueFamilyIndices = nullptr;
     bufCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     bufCreateInfo.flags = 0;
-    res = vkCreateBuffer(m_device, &bufCreateInfo, nullptr, &mUniformData.buf);
+    res = vkCreateBuffer(m_device, &bufCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_BUFFER), &mUniformData.buf);
     assert(res == VK_SUCCESS);
 
     VkMemoryRequirements memReqs;
@@ -736,30 +1474,38 @@ void VulkanRHI::initUniformBuffer()
                                     &allocInfo.memoryTypeIndex);
     assert(pass);
 
-    res = vkAllocateMemory(m_device, &allocInfo, nullptr, &mUniformData.mem);
+    res = vkAllocateMemory(m_device, &allocInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_DEVICE_MEMORY), &mUniformData.mem);
     assert(res == VK_SUCCESS);
+    mUniformData.memSize = allocInfo.allocationSize;
+    FLIGHT_RECORD(FlightEventType::Allocation, allocInfo.memoryTypeIndex, (uint64_t)mUniformData.mem,
+                  mUniformData.memSize);
 
-    uint8_t *pData;
-    res = vkMapMemory(m_device, mUniformData.mem, 0, memReqs.size, 0, (void **)&pData);
+    // coherent memory stays mapped, the camera writes straight into it
+    res = vkMapMemory(m_device, mUniformData.mem, 0, memReqs.size, 0, (void **)&mUniformMapped);
     assert(res == VK_SUCCESS);
-    memcpy(pData, &mMVP, sizeof(mMVP));
-    vkUnmapMemory(m_device, mUniformData.mem);
+    for (uint32_t i = 0; i < MaxFramesInFlight; i++)
+    {
+        mUniformVersions[i] = 0;
+        UpdateUniforms(i);
+    }
 
     res = vkBindBufferMemory(m_device, mUniformData.buf, mUniformData.mem, 0);
     assert(res == VK_SUCCESS);
 
+    // the frame's slot is selected with a dynamic offset, see GetUniformOffset
     mUniformData.bufferInfo.buffer = mUniformData.buf;
     mUniformData.bufferInfo.offset = 0;
-    mUniformData.bufferInfo.range = sizeof(mMVP);
+    mUniformData.bufferInfo.range = sizeof(glm::mat4);
 }
 
 void VulkanRHI::initDescriptorAndPipelineLayouts()
 {
     // LOG("initDescriptorAndPipelineLayouts");
-    spdlog::info("initDescriptorAndPipelineLayouts");
+    RC_INFO("initDescriptorAndPipelineLayouts");
+    STARTUP_PHASE(m_startupProfiler, "initDescriptorAndPipelineLayouts");
     VkDescriptorSetLayoutBinding layoutBindings[2];
     layoutBindings[0].binding = 0;
-    layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    layoutBindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
     layoutBindings[0].descriptorCount = 1;
     layoutBindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     layoutBindings[0].pImmutableSamplers = nullptr;
@@ -773,7 +1519,8 @@ void VulkanRHI::initDescriptorAndPipelineLayouts()
 
     VkResult res;
     mDescLayout.resize(1);
-    res = vkCreateDescriptorSetLayout(m_device, &descSetLayoutInfo, nullptr, mDescLayout.data());
+    res = vkCreateDescriptorSetLayout(m_device, &descSetLayoutInfo,
+                                      VK_ALLOCATOR(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT), mDescLayout.data());
     assert(res == VK_SUCCESS);
 
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
@@ -784,14 +1531,17 @@ void VulkanRHI::initDescriptorAndPipelineLayouts()
     pipelineLayoutCreateInfo.setLayoutCount = 1;
     pipelineLayoutCreateInfo.pSetLayouts = mDescLayout.data();
 
-    res = vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout);
+    res = vkCreatePipelineLayout(m_device, &pipelineLayoutCreateInfo,
+                                 VK_ALLOCATOR(VK_OBJECT_TYPE_PIPELINE_LAYOUT), &mPipelineLayout);
     assert(res == VK_SUCCESS);
+    FLIGHT_RECORD(FlightEventType::PipelineCreate, VK_OBJECT_TYPE_PIPELINE_LAYOUT, (uint64_t)mPipelineLayout);
 }
 
 void VulkanRHI::initRenderpass(bool includePath,bool clear, VkImageLayout finalLayout, VkImageLayout initialLayout)
 {
     // LOG("initRenderpass");
-    spdlog::info("initRenderpass");
+    RC_INFO("initRenderpass");
+    STARTUP_PHASE(m_startupProfiler, "initRenderpass");
     assert(clear || (initialLayout != VK_IMAGE_LAYOUT_UNDEFINED));
 
     VkResult res;
@@ -857,8 +1607,9 @@ void VulkanRHI::initRenderpass(bool includePath,bool clear, VkImageLayout finalL
     renderPassCreateInfo.dependencyCount = 1;
     renderPassCreateInfo.pDependencies = &subpassDep;
 
-    res = vkCreateRenderPass(m_device, &renderPassCreateInfo, NULL, &mRenderPass);
+    res = vkCreateRenderPass(m_device, &renderPassCreateInfo, VK_ALLOCATOR(VK_OBJECT_TYPE_RENDER_PASS), &mRenderPass);
     assert(res == VK_SUCCESS);
+    FLIGHT_RECORD(FlightEventType::PipelineCreate, VK_OBJECT_TYPE_RENDER_PASS, (uint64_t)mRenderPass);
 }
 
 bool VulkanRHI::memoryTypeFromProperties(uint32_t typeBits, VkFlags requirementsMask, uint32_t *typeIndex)
@@ -0,0 +1,227 @@
+#ifndef VULKAN_CORE_WATER_KERNELS_H
+#define VULKAN_CORE_WATER_KERNELS_H
+
+#include "ShallowWater.hpp"
+#include "SimdLanes.hpp"
+
+// Row kernels behind ShallowWater, instantiated per ISA like TransformKernels. They use no
+// MulAdd and evaluate every expression in the same order for every lane type, so all ISAs
+// produce the scalar results bit for bit.
+
+// Per cell terms of one row: conserved values, the flux components that are not conserved
+// values themselves, and the wave speed along each axis. F = (hu, fxx, fxy), G = (hv, fxy, fyy).
+struct RowTerms
+{
+    float *h;
+    float *hu;
+    float *hv;
+    float *fxx;
+    float *fxy;
+    float *fyy;
+    float *ax;
+    float *ay;
+};
+
+struct FaceFlux
+{
+    float *h;
+    float *hu;
+    float *hv;
+};
+
+struct WaterKernels
+{
+    SimdIsa isa;
+    void (*computeTerms)(const float *h, const float *hu, const float *hv, size_t count, float gravity,
+                         const RowTerms &out);
+    // faces between cells i and i + 1 of one row
+    void (*fluxX)(const RowTerms &t, size_t count, const FaceFlux &out);
+    // faces between row a above and row b below
+    void (*fluxY)(const RowTerms &a, const RowTerms &b, size_t count, const FaceFlux &out);
+    // one row of cells from its x faces (count + 1), top and bottom faces (count)
+    void (*updateRow)(const RowTerms &t, const FaceFlux &x, const FaceFlux &top, const FaceFlux &bottom, float r,
+                      size_t count, float *h, float *hu, float *hv);
+    float (*maxSpeed)(const RowTerms &t, size_t count);
+};
+
+// null when RenderCore was built without the matching translation unit
+const WaterKernels *GetAvx2WaterKernels();
+const WaterKernels *GetAvx512WaterKernels();
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+// below this depth velocities are computed as if the cell held MinDepth of water
+static const float WaterMinDepth = 1e-3f;
+
+template <typename V>
+void ComputeTermsBlock(const float *h, const float *hu, const float *hv, typename V::Type gravity,
+                       typename V::Type halfGravity, const RowTerms &out, size_t i)
+{
+    typedef typename V::Type T;
+    T vh = V::Load(h + i);
+    T vhu = V::Load(hu + i);
+    T vhv = V::Load(hv + i);
+    T depth = V::Max(vh, V::Set1(WaterMinDepth));
+    T inv = V::Div(V::Set1(1.0f), depth);
+    T u = V::Mul(vhu, inv);
+    T v = V::Mul(vhv, inv);
+    T pressure = V::Mul(V::Mul(halfGravity, vh), vh);
+    T c = V::Sqrt(V::Mul(gravity, depth));
+    V::Store(out.h + i, vh);
+    V::Store(out.hu + i, vhu);
+    V::Store(out.hv + i, vhv);
+    V::Store(out.fxx + i, V::Add(V::Mul(vhu, u), pressure));
+    V::Store(out.fxy + i, V::Mul(vhu, v));
+    V::Store(out.fyy + i, V::Add(V::Mul(vhv, v), pressure));
+    V::Store(out.ax + i, V::Add(V::Abs(u), c));
+    V::Store(out.ay + i, V::Add(V::Abs(v), c));
+}
+
+// Rusanov flux of one component: (fl + fr) / 2 - s / 2 * (ur - ul)
+template <typename V>
+typename V::Type RusanovFlux(typename V::Type fl, typename V::Type fr, typename V::Type ul, typename V::Type ur,
+                             typename V::Type halfSpeed)
+{
+    return V::Sub(V::Mul(V::Set1(0.5f), V::Add(fl, fr)), V::Mul(halfSpeed, V::Sub(ur, ul)));
+}
+
+template <typename V> void FluxXBlock(const RowTerms &t, const FaceFlux &out, size_t i)
+{
+    typedef typename V::Type T;
+    T h0 = V::Load(t.h + i), h1 = V::Load(t.h + i + 1);
+    T hu0 = V::Load(t.hu + i), hu1 = V::Load(t.hu + i + 1);
+    T hv0 = V::Load(t.hv + i), hv1 = V::Load(t.hv + i + 1);
+    T s = V::Mul(V::Set1(0.5f), V::Max(V::Load(t.ax + i), V::Load(t.ax + i + 1)));
+    V::Store(out.h + i, RusanovFlux<V>(hu0, hu1, h0, h1, s));
+    V::Store(out.hu + i, RusanovFlux<V>(V::Load(t.fxx + i), V::Load(t.fxx + i + 1), hu0, hu1, s));
+    V::Store(out.hv + i, RusanovFlux<V>(V::Load(t.fxy + i), V::Load(t.fxy + i + 1), hv0, hv1, s));
+}
+
+template <typename V> void FluxYBlock(const RowTerms &a, const RowTerms &b, const FaceFlux &out, size_t i)
+{
+    typedef typename V::Type T;
+    T h0 = V::Load(a.h + i), h1 = V::Load(b.h + i);
+    T hu0 = V::Load(a.hu + i), hu1 = V::Load(b.hu + i);
+    T hv0 = V::Load(a.hv + i), hv1 = V::Load(b.hv + i);
+    T s = V::Mul(V::Set1(0.5f), V::Max(V::Load(a.ay + i), V::Load(b.ay + i)));
+    V::Store(out.h + i, RusanovFlux<V>(hv0, hv1, h0, h1, s));
+    V::Store(out.hu + i, RusanovFlux<V>(V::Load(a.fxy + i), V::Load(b.fxy + i), hu0, hu1, s));
+    V::Store(out.hv + i, RusanovFlux<V>(V::Load(a.fyy + i), V::Load(b.fyy + i), hv0, hv1, s));
+}
+
+// u - r * (x[i + 1] - x[i] + bottom - top)
+template <typename V>
+typename V::Type UpdateValue(const float *u, const float *x, const float *top, const float *bottom,
+                             typename V::Type r, size_t i)
+{
+    typename V::Type net = V::Sub(V::Add(V::Sub(V::Load(x + i + 1), V::Load(x + i)), V::Load(bottom + i)),
+                                  V::Load(top + i));
+    return V::Sub(V::Load(u + i), V::Mul(r, net));
+}
+
+template <typename V>
+void UpdateRowBlock(const RowTerms &t, const FaceFlux &x, const FaceFlux &top, const FaceFlux &bottom,
+                    typename V::Type r, float *h, float *hu, float *hv, size_t i)
+{
+    V::Store(h + i, UpdateValue<V>(t.h, x.h, top.h, bottom.h, r, i));
+    V::Store(hu + i, UpdateValue<V>(t.hu, x.hu, top.hu, bottom.hu, r, i));
+    V::Store(hv + i, UpdateValue<V>(t.hv, x.hv, top.hv, bottom.hv, r, i));
+}
+
+template <typename V>
+void ComputeTermsKernel(const float *h, const float *hu, const float *hv, size_t count, float gravity,
+                        const RowTerms &out)
+{
+    typename V::Type g = V::Set1(gravity);
+    typename V::Type halfG = V::Set1(0.5f * gravity);
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        ComputeTermsBlock<V>(h, hu, hv, g, halfG, out, i);
+    }
+    for (; i < count; i++)
+    {
+        ComputeTermsBlock<ScalarLanes>(h, hu, hv, gravity, 0.5f * gravity, out, i);
+    }
+}
+
+template <typename V> void FluxXKernel(const RowTerms &t, size_t count, const FaceFlux &out)
+{
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        FluxXBlock<V>(t, out, i);
+    }
+    for (; i < count; i++)
+    {
+        FluxXBlock<ScalarLanes>(t, out, i);
+    }
+}
+
+template <typename V> void FluxYKernel(const RowTerms &a, const RowTerms &b, size_t count, const FaceFlux &out)
+{
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        FluxYBlock<V>(a, b, out, i);
+    }
+    for (; i < count; i++)
+    {
+        FluxYBlock<ScalarLanes>(a, b, out, i);
+    }
+}
+
+template <typename V>
+void UpdateRowKernel(const RowTerms &t, const FaceFlux &x, const FaceFlux &top, const FaceFlux &bottom, float r,
+                     size_t count, float *h, float *hu, float *hv)
+{
+    typename V::Type wide = V::Set1(r);
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        UpdateRowBlock<V>(t, x, top, bottom, wide, h, hu, hv, i);
+    }
+    for (; i < count; i++)
+    {
+        UpdateRowBlock<ScalarLanes>(t, x, top, bottom, r, h, hu, hv, i);
+    }
+}
+
+template <typename V> float MaxSpeedKernel(const RowTerms &t, size_t count)
+{
+    typename V::Type wide = V::Set1(0.0f);
+    size_t i = 0;
+    for (; i + V::Width <= count; i += V::Width)
+    {
+        wide = V::Max(wide, V::Max(V::Load(t.ax + i), V::Load(t.ay + i)));
+    }
+    float lanes[V::Width];
+    V::Store(lanes, wide);
+    float speed = 0.0f;
+    for (size_t k = 0; k < V::Width; k++)
+    {
+        speed = ScalarLanes::Max(speed, lanes[k]);
+    }
+    for (; i < count; i++)
+    {
+        speed = ScalarLanes::Max(speed, ScalarLanes::Max(t.ax[i], t.ay[i]));
+    }
+    return speed;
+}
+
+template <typename V> WaterKernels MakeWaterKernels(SimdIsa isa)
+{
+    WaterKernels kernels;
+    kernels.isa = isa;
+    kernels.computeTerms = ComputeTermsKernel<V>;
+    kernels.fluxX = FluxXKernel<V>;
+    kernels.fluxY = FluxYKernel<V>;
+    kernels.updateRow = UpdateRowKernel<V>;
+    kernels.maxSpeed = MaxSpeedKernel<V>;
+    return kernels;
+}
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_WATER_KERNELS_H
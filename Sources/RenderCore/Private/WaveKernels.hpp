@@ -0,0 +1,180 @@
+#ifndef VULKAN_CORE_WAVE_KERNELS_H
+#define VULKAN_CORE_WAVE_KERNELS_H
+
+#include <assert.h>
+
+#include "SimdLanes.hpp"
+#include "WaveQuery.hpp"
+
+// Gerstner wave sums behind WaveQuery, instantiated per ISA like FftKernels. Every lane holds
+// one query point and the waves are broadcast. Coordinates are reduced to one period of their
+// cascade, where every wave repeats, so phases stay small whatever the distance from the origin;
+// sin and cos reduce by multiples of pi in three parts and evaluate Taylor polynomials. Rounding
+// adds and subtracts 1.5 * 2^23 instead of using an ISA specific instruction. No MulAdd, so every
+// ISA gives the scalar results bit for bit.
+
+struct WaveTable
+{
+    const float *kx;
+    const float *kz;
+    const float *phase;
+    const float *amplitude;
+    const float *dirX;
+    const float *dirZ;
+    // waves of cascade c are [first[c], first[c + 1])
+    const uint32_t *first;
+    const float *patchSize;
+    uint32_t cascadeCount;
+    float choppiness;
+};
+
+struct WaveKernels
+{
+    SimdIsa isa;
+    // horizontal displacement and height of count points, count a multiple of the widest lanes
+    void (*displace)(const WaveTable &table, const float *x, const float *z, size_t count, float *dx, float *height,
+                     float *dz);
+    // height alone
+    void (*height)(const WaveTable &table, const float *x, const float *z, size_t count, float *height);
+};
+
+// null when RenderCore was built without the matching translation unit
+const WaveKernels *GetAvx2WaveKernels();
+const WaveKernels *GetAvx512WaveKernels();
+
+namespace RENDERCORE_LANES_NAMESPACE
+{
+
+// nearest integer for |v| below 2^22, ties to even
+template <typename V> typename V::Type RoundLanes(typename V::Type v)
+{
+    const typename V::Type magic = V::Set1(12582912.0f);
+    return V::Sub(V::Add(v, magic), magic);
+}
+
+// theta - q pi in [-pi / 2, pi / 2], and the sign (-1)^q
+template <typename V>
+typename V::Type ReducePi(typename V::Type theta, typename V::Type *sign)
+{
+    typedef typename V::Type T;
+    const T q = RoundLanes<V>(V::Mul(theta, V::Set1(0.318309886183790672f)));
+    // q * 3.140625 is exact for the q a reduced phase can reach
+    T r = V::Sub(theta, V::Mul(q, V::Set1(3.140625f)));
+    r = V::Sub(r, V::Mul(q, V::Set1(9.67502593994140625e-4f)));
+    r = V::Sub(r, V::Mul(q, V::Set1(1.509957990978376432e-7f)));
+    // q - 2 round(q / 2) is -1, 0 or 1
+    const T half = RoundLanes<V>(V::Mul(q, V::Set1(0.5f)));
+    const T parity = V::Sub(q, V::Add(half, half));
+    *sign = V::Sub(V::Set1(1.0f), V::Mul(V::Set1(2.0f), V::Mul(parity, parity)));
+    return r;
+}
+
+// sin and cos on [-pi / 2, pi / 2], truncation below 6e-8
+template <typename V> typename V::Type SinPoly(typename V::Type r, typename V::Type r2)
+{
+    typedef typename V::Type T;
+    T p = V::Add(V::Mul(r2, V::Set1(-2.50521083854417188e-8f)), V::Set1(2.75573192239858907e-6f));
+    p = V::Add(V::Mul(r2, p), V::Set1(-1.98412698412698413e-4f));
+    p = V::Add(V::Mul(r2, p), V::Set1(8.33333333333333333e-3f));
+    p = V::Add(V::Mul(r2, p), V::Set1(-1.66666666666666667e-1f));
+    return V::Add(r, V::Mul(V::Mul(r, r2), p));
+}
+
+template <typename V> typename V::Type CosPoly(typename V::Type r2)
+{
+    typedef typename V::Type T;
+    T p = V::Add(V::Mul(r2, V::Set1(2.08767569878680990e-9f)), V::Set1(-2.75573192239858907e-7f));
+    p = V::Add(V::Mul(r2, p), V::Set1(2.48015873015873016e-5f));
+    p = V::Add(V::Mul(r2, p), V::Set1(-1.38888888888888889e-3f));
+    p = V::Add(V::Mul(r2, p), V::Set1(4.16666666666666667e-2f));
+    p = V::Add(V::Mul(r2, p), V::Set1(-0.5f));
+    return V::Add(V::Set1(1.0f), V::Mul(r2, p));
+}
+
+// v minus the nearest multiple of period
+template <typename V>
+typename V::Type ReducePeriod(typename V::Type v, typename V::Type period, typename V::Type inversePeriod)
+{
+    return V::Sub(v, V::Mul(period, RoundLanes<V>(V::Mul(v, inversePeriod))));
+}
+
+template <typename V>
+void DisplaceKernel(const WaveTable &table, const float *x, const float *z, size_t count, float *dx, float *height,
+                    float *dz)
+{
+    typedef typename V::Type T;
+    assert(count % V::Width == 0);
+    for (size_t p = 0; p < count; p += V::Width)
+    {
+        const T px = V::Load(x + p);
+        const T pz = V::Load(z + p);
+        T sumX = V::Set1(0.0f), sumH = V::Set1(0.0f), sumZ = V::Set1(0.0f);
+        for (uint32_t cascade = 0; cascade < table.cascadeCount; cascade++)
+        {
+            const T period = V::Set1(table.patchSize[cascade]);
+            const T inversePeriod = V::Set1(1.0f / table.patchSize[cascade]);
+            const T cx = ReducePeriod<V>(px, period, inversePeriod);
+            const T cz = ReducePeriod<V>(pz, period, inversePeriod);
+            for (uint32_t w = table.first[cascade]; w < table.first[cascade + 1]; w++)
+            {
+                T theta = V::Add(V::Mul(V::Set1(table.kx[w]), cx), V::Mul(V::Set1(table.kz[w]), cz));
+                theta = V::Add(theta, V::Set1(table.phase[w]));
+                T sign;
+                const T r = ReducePi<V>(theta, &sign);
+                const T r2 = V::Mul(r, r);
+                const T s = V::Mul(sign, SinPoly<V>(r, r2));
+                const T c = V::Mul(sign, CosPoly<V>(r2));
+                sumH = V::Add(sumH, V::Mul(V::Set1(table.amplitude[w]), c));
+                sumX = V::Add(sumX, V::Mul(V::Set1(table.dirX[w]), s));
+                sumZ = V::Add(sumZ, V::Mul(V::Set1(table.dirZ[w]), s));
+            }
+        }
+        const T choppiness = V::Set1(table.choppiness);
+        V::Store(dx + p, V::Mul(sumX, choppiness));
+        V::Store(height + p, sumH);
+        V::Store(dz + p, V::Mul(sumZ, choppiness));
+    }
+}
+
+template <typename V>
+void HeightKernel(const WaveTable &table, const float *x, const float *z, size_t count, float *height)
+{
+    typedef typename V::Type T;
+    assert(count % V::Width == 0);
+    for (size_t p = 0; p < count; p += V::Width)
+    {
+        const T px = V::Load(x + p);
+        const T pz = V::Load(z + p);
+        T sumH = V::Set1(0.0f);
+        for (uint32_t cascade = 0; cascade < table.cascadeCount; cascade++)
+        {
+            const T period = V::Set1(table.patchSize[cascade]);
+            const T inversePeriod = V::Set1(1.0f / table.patchSize[cascade]);
+            const T cx = ReducePeriod<V>(px, period, inversePeriod);
+            const T cz = ReducePeriod<V>(pz, period, inversePeriod);
+            for (uint32_t w = table.first[cascade]; w < table.first[cascade + 1]; w++)
+            {
+                T theta = V::Add(V::Mul(V::Set1(table.kx[w]), cx), V::Mul(V::Set1(table.kz[w]), cz));
+                theta = V::Add(theta, V::Set1(table.phase[w]));
+                T sign;
+                const T r = ReducePi<V>(theta, &sign);
+                const T c = V::Mul(sign, CosPoly<V>(V::Mul(r, r)));
+                sumH = V::Add(sumH, V::Mul(V::Set1(table.amplitude[w]), c));
+            }
+        }
+        V::Store(height + p, sumH);
+    }
+}
+
+template <typename V> WaveKernels MakeWaveKernels(SimdIsa isa)
+{
+    WaveKernels kernels;
+    kernels.isa = isa;
+    kernels.displace = DisplaceKernel<V>;
+    kernels.height = HeightKernel<V>;
+    return kernels;
+}
+
+} // namespace RENDERCORE_LANES_NAMESPACE
+
+#endif // VULKAN_CORE_WAVE_KERNELS_H
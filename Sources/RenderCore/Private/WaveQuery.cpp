@@ -0,0 +1,233 @@
+#include "WaveQuery.hpp"
+
+#include <algorithm>
+#include <math.h>
+
+#include "CpuProfiler.hpp"
+#include "SimdDispatch.hpp"
+#include "TaskPool.hpp"
+#include "WaveKernels.hpp"
+
+using namespace RENDERCORE_LANES_NAMESPACE;
+
+static SimdDispatch<WaveKernels> sDispatch(MakeWaveKernels<ScalarLanes>, MakeWaveKernels<DefaultLanes>,
+                                           GetAvx2WaveKernels, GetAvx512WaveKernels);
+
+static const WaveKernels &Kernels()
+{
+    return sDispatch.Get();
+}
+
+// points per kernel call, a multiple of every lane width; blocks are also the unit of the
+// TaskPool's chunks, each is a few thousand waves times the points
+static const size_t BlockSize = 64;
+
+static const double Pi = 3.14159265358979323846;
+
+WaveQuery::WaveQuery(const OceanSettings &settings, uint32_t maxWaves)
+    : mSettings(settings), mIterations(3), mResidualRms(0.0f)
+{
+    const uint32_t n = mSettings.size;
+    assert(n >= 16 && n <= 1024 && (n & (n - 1)) == 0);
+    assert(mSettings.cascadeCount >= 1 && mSettings.cascadeCount <= OceanSettings::MaxCascades);
+
+    struct Wave
+    {
+        float amplitude;
+        uint32_t cascade;
+        uint32_t texel;
+    };
+
+    const size_t area = static_cast<size_t>(n) * n;
+    std::vector<OceanSpectrumTexel> spectrum(area * mSettings.cascadeCount);
+    std::vector<Wave> waves;
+    for (uint32_t cascade = 0; cascade < mSettings.cascadeCount; cascade++)
+    {
+        OceanSpectrumTexel *texels = spectrum.data() + area * cascade;
+        GenerateOceanSpectrum(mSettings, cascade, texels);
+        for (size_t i = 0; i < area; i++)
+        {
+            // the conj(h0(-k)) half of a texel is the wave of texel -k, counted there
+            float amplitude = 2.0f * sqrtf(texels[i].h0.x * texels[i].h0.x + texels[i].h0.y * texels[i].h0.y);
+            if (amplitude > 0.0f)
+            {
+                Wave wave = {amplitude, cascade, static_cast<uint32_t>(i)};
+                waves.push_back(wave);
+            }
+        }
+    }
+
+    if (maxWaves != 0 && maxWaves < waves.size())
+    {
+        // strongest first, ties in texel order so the selection does not depend on the sort
+        std::nth_element(waves.begin(), waves.begin() + maxWaves, waves.end(), [](const Wave &a, const Wave &b) {
+            if (a.amplitude != b.amplitude)
+            {
+                return a.amplitude > b.amplitude;
+            }
+            return a.cascade != b.cascade ? a.cascade < b.cascade : a.texel < b.texel;
+        });
+        // a cosine of amplitude a has a mean square of a^2 / 2
+        double residual = 0.0;
+        for (size_t i = maxWaves; i < waves.size(); i++)
+        {
+            residual += 0.5 * static_cast<double>(waves[i].amplitude) * waves[i].amplitude;
+        }
+        mResidualRms = static_cast<float>(sqrt(residual));
+        waves.resize(maxWaves);
+    }
+    std::sort(waves.begin(), waves.end(), [](const Wave &a, const Wave &b) {
+        return a.cascade != b.cascade ? a.cascade < b.cascade : a.texel < b.texel;
+    });
+
+    const size_t count = waves.size();
+    mKx.resize(count);
+    mKz.resize(count);
+    mFrequency.resize(count);
+    mBasePhase.resize(count);
+    mAmplitude.resize(count);
+    mDirX.resize(count);
+    mDirZ.resize(count);
+    mPhase.resize(count);
+    for (uint32_t cascade = 0; cascade <= OceanSettings::MaxCascades; cascade++)
+    {
+        mFirst[cascade] = 0;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        const Wave &wave = waves[i];
+        const OceanSpectrumTexel &texel = spectrum[area * wave.cascade + wave.texel];
+        mKx[i] = texel.k.x;
+        mKz[i] = texel.k.y;
+        mFrequency[i] = texel.k.z;
+        // linear filtering puts texel i's center at (i + 0.5) / n, so the shaders see the field
+        // half a texel behind the position they sample at
+        const double halfTexel = 0.5 * mSettings.patchSize[wave.cascade] / n;
+        mBasePhase[i] = atan2(static_cast<double>(texel.h0.y), static_cast<double>(texel.h0.x)) -
+                        (static_cast<double>(texel.k.x) + texel.k.y) * halfTexel;
+        mAmplitude[i] = wave.amplitude;
+        // D(k) = -i k / |k| h(k): the displacement is the sine of the height's phase along k
+        mDirX[i] = wave.amplitude * texel.k.x * texel.k.w;
+        mDirZ[i] = wave.amplitude * texel.k.y * texel.k.w;
+        mFirst[wave.cascade + 1] = static_cast<uint32_t>(i + 1);
+    }
+    // cascades without waves start where the previous one ended
+    for (uint32_t cascade = 1; cascade <= OceanSettings::MaxCascades; cascade++)
+    {
+        mFirst[cascade] = std::max(mFirst[cascade], mFirst[cascade - 1]);
+    }
+
+    Update(0.0);
+}
+
+void WaveQuery::SetChoppiness(float choppiness)
+{
+    mSettings.choppiness = choppiness;
+}
+
+void WaveQuery::Update(double seconds)
+{
+    // the phase of every wave in double, reduced to [-pi, pi) so the kernels add small numbers
+    const double time = WrapOceanTime(mSettings, seconds);
+    for (size_t i = 0; i < mPhase.size(); i++)
+    {
+        double phase = mFrequency[i] * time + mBasePhase[i];
+        phase -= 2.0 * Pi * floor((phase + Pi) / (2.0 * Pi));
+        mPhase[i] = static_cast<float>(phase);
+    }
+}
+
+void WaveQuery::QueryHeights(const float *x, const float *z, size_t count, float *heights) const
+{
+    CPU_ZONE("WaveQuery::QueryHeights");
+    TaskPool::Instance().ParallelFor((count + BlockSize - 1) / BlockSize, 1, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; block++)
+        {
+            size_t first = block * BlockSize;
+            size_t points = std::min(BlockSize, count - first);
+            queryBlock(x + first, z + first, points, heights + first, nullptr);
+        }
+    });
+}
+
+void WaveQuery::QueryDisplacements(const float *x, const float *z, size_t count, glm::vec3 *displacements) const
+{
+    CPU_ZONE("WaveQuery::QueryDisplacements");
+    TaskPool::Instance().ParallelFor((count + BlockSize - 1) / BlockSize, 1, [&](size_t begin, size_t end) {
+        for (size_t block = begin; block < end; block++)
+        {
+            size_t first = block * BlockSize;
+            size_t points = std::min(BlockSize, count - first);
+            queryBlock(x + first, z + first, points, nullptr, displacements + first);
+        }
+    });
+}
+
+void WaveQuery::queryBlock(const float *x, const float *z, size_t count, float *heights,
+                           glm::vec3 *displacements) const
+{
+    WaveTable table;
+    table.kx = mKx.data();
+    table.kz = mKz.data();
+    table.phase = mPhase.data();
+    table.amplitude = mAmplitude.data();
+    table.dirX = mDirX.data();
+    table.dirZ = mDirZ.data();
+    table.first = mFirst;
+    table.patchSize = mSettings.patchSize;
+    table.cascadeCount = mSettings.cascadeCount;
+    table.choppiness = mSettings.choppiness;
+
+    // the tail is padded with zeros up to whole lanes of the widest ISA
+    const size_t padded = (count + 15) & ~static_cast<size_t>(15);
+    float px[BlockSize], pz[BlockSize];
+    float dx[BlockSize], height[BlockSize], dz[BlockSize];
+    for (size_t i = 0; i < padded; i++)
+    {
+        px[i] = i < count ? x[i] : 0.0f;
+        pz[i] = i < count ? z[i] : 0.0f;
+    }
+
+    const WaveKernels &kernels = Kernels();
+    if (displacements != nullptr)
+    {
+        kernels.displace(table, px, pz, padded, dx, height, dz);
+        for (size_t i = 0; i < count; i++)
+        {
+            displacements[i] = glm::vec3(dx[i], height[i], dz[i]);
+        }
+        return;
+    }
+
+    // find the undisplaced point p with p + D(p) = (x, z), starting from (x, z) itself
+    const uint32_t iterations = mSettings.choppiness != 0.0f ? mIterations : 0;
+    for (uint32_t iteration = 0; iteration < iterations; iteration++)
+    {
+        kernels.displace(table, px, pz, padded, dx, height, dz);
+        for (size_t i = 0; i < count; i++)
+        {
+            px[i] = x[i] - dx[i];
+            pz[i] = z[i] - dz[i];
+        }
+    }
+    kernels.height(table, px, pz, padded, height);
+    for (size_t i = 0; i < count; i++)
+    {
+        heights[i] = height[i];
+    }
+}
+
+SimdIsa WaveQuery::GetIsa()
+{
+    return Kernels().isa;
+}
+
+const char *WaveQuery::GetIsaName()
+{
+    return GetSimdIsaName(GetIsa());
+}
+
+SimdIsa WaveQuery::LimitIsa(SimdIsa isa)
+{
+    return sDispatch.Limit(isa);
+}
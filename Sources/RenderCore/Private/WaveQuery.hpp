@@ -0,0 +1,90 @@
+#ifndef VULKAN_CORE_WAVE_QUERY_H
+#define VULKAN_CORE_WAVE_QUERY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "CpuFeatures.hpp"
+#include "OceanSpectrum.hpp"
+#include "glm/glm.hpp"
+
+// Water heights for gameplay and physics (buoys, boats, particles) without reading back the
+// gpu's maps. Every texel of a cascade's spectrum is one Gerstner wave: the map GpuOcean renders
+// is exactly the sum over k of 2 |h0(k)| cos(k x + w t + arg h0(k)) for the height, and
+// choppiness times the same amplitudes along k / |k| with sin for the horizontal displacement.
+// Summing the waves directly instead of transforming them costs nothing per point for the waves
+// that are not kept, so the strongest maxWaves of all cascades are summed and the rest is
+// reported as GetResidualRms. With every wave kept the sums match CpuOcean's maps at the texels
+// to float rounding, and the surface the shaders sample up to its linear filtering.
+//
+// Lanes run across query points and waves are broadcast, so a point's result does not depend on
+// the batch it came in or on the ISA; phases are reduced to one period of their cascade and
+// sin and cos are polynomials without MulAdd, every ISA gives the scalar results bit for bit.
+// Large batches are spread over the TaskPool.
+class WaveQuery
+{
+  public:
+    // instruction set of the wave sums, picked at first use
+    static SimdIsa GetIsa();
+    static const char *GetIsaName();
+    // see SimdDispatch::Limit
+    static SimdIsa LimitIsa(SimdIsa isa);
+
+    // keeps the maxWaves waves of largest amplitude over all cascades, 0 keeps all of them
+    WaveQuery(const OceanSettings &settings, uint32_t maxWaves);
+
+    const OceanSettings &GetSettings() const
+    {
+        return mSettings;
+    }
+    void SetChoppiness(float choppiness);
+
+    uint32_t GetWaveCount() const
+    {
+        return static_cast<uint32_t>(mKx.size());
+    }
+    // root mean square height of the dropped waves, the typical error of a query
+    float GetResidualRms() const
+    {
+        return mResidualRms;
+    }
+
+    // fixed point steps undoing the horizontal displacement in QueryHeights; each divides the
+    // error by about the steepness of the chop, 3 is plenty unless the surface folds over
+    void SetIterations(uint32_t iterations)
+    {
+        mIterations = iterations;
+    }
+
+    // the surface at seconds, like GpuOcean::Update; queries between updates see the same time
+    void Update(double seconds);
+
+    // height of the water above world (x, z): the displaced point that lands on (x, z), not the
+    // height at the undisplaced (x, z). Safe to call from several threads at once.
+    void QueryHeights(const float *x, const float *z, size_t count, float *heights) const;
+    // displacement of the undisplaced surface point (x, z), like CpuOcean::SampleDisplacement
+    void QueryDisplacements(const float *x, const float *z, size_t count, glm::vec3 *displacements) const;
+
+  private:
+    void queryBlock(const float *x, const float *z, size_t count, float *heights, glm::vec3 *displacements) const;
+
+    OceanSettings mSettings;
+    uint32_t mIterations;
+    float mResidualRms;
+    // waves grouped by cascade, [mFirst[c], mFirst[c + 1]) belong to cascade c
+    uint32_t mFirst[OceanSettings::MaxCascades + 1];
+    std::vector<float> mKx;
+    std::vector<float> mKz;
+    // angular frequency, phase of h0 minus the half texel the maps are sampled off by
+    std::vector<double> mFrequency;
+    std::vector<double> mBasePhase;
+    // height amplitude, and the amplitude along k / |k| of the horizontal displacement
+    std::vector<float> mAmplitude;
+    std::vector<float> mDirX;
+    std::vector<float> mDirZ;
+    // phase of every wave at the updated time, in [-pi, pi)
+    std::vector<float> mPhase;
+};
+
+#endif // VULKAN_CORE_WAVE_QUERY_H
@@ -0,0 +1,23 @@
+// Built with AVX2 and FMA enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx2WaveLanes
+
+#include "WaveKernels.hpp"
+
+#if defined(__AVX2__)
+
+const WaveKernels *GetAvx2WaveKernels()
+{
+    static const WaveKernels kernels =
+        Avx2WaveLanes::MakeWaveKernels<Avx2WaveLanes::Avx2Lanes>(SimdIsa::Avx2);
+    return &kernels;
+}
+
+#else
+
+const WaveKernels *GetAvx2WaveKernels()
+{
+    return nullptr;
+}
+
+#endif
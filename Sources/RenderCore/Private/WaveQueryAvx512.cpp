@@ -0,0 +1,23 @@
+// Built with AVX-512F enabled on x86 (see CMakeLists.txt), only reached after the cpu check
+// in SimdDispatch.hpp.
+#define RENDERCORE_LANES_NAMESPACE Avx512WaveLanes
+
+#include "WaveKernels.hpp"
+
+#if defined(__AVX512F__)
+
+const WaveKernels *GetAvx512WaveKernels()
+{
+    static const WaveKernels kernels =
+        Avx512WaveLanes::MakeWaveKernels<Avx512WaveLanes::Avx512Lanes>(SimdIsa::Avx512);
+    return &kernels;
+}
+
+#else
+
+const WaveKernels *GetAvx512WaveKernels()
+{
+    return nullptr;
+}
+
+#endif
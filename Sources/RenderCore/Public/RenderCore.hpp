@@ -2,6 +2,8 @@
 #define RENDER_CORE_H
 
 #include <memory>
+#include <string>
+#include <vector>
 
 class VulkanRHI;
 
@@ -11,8 +13,15 @@ class RenderCore{
 	RenderCore(RenderCore&);
 	void Init(void *view);
 
+	// Add an isolated render context for offscreen work. Contexts share the VkInstance of
+	// this core and, if shareDevice is set, its VkDevice; each one owns its queue and pools.
+	size_t CreateContext(bool shareDevice = true, const std::string &preferredDevice = "");
+	std::shared_ptr<VulkanRHI> GetContext(size_t index) const;
+	size_t GetContextCount() const;
+
 	private:
 	std::shared_ptr<VulkanRHI> rhi;
+	std::vector<std::shared_ptr<VulkanRHI>> contexts;
 };
 
-#endif
\ No newline at end of file
+#endif
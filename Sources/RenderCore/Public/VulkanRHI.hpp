@@ -4,10 +4,19 @@
 #include <MoltenVK/vk_mvk_moltenvk.h>
 #include <vulkan/vulkan.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "Camera.hpp"
+#include "GpuCuller.hpp"
+#include "GpuOcean.hpp"
+#include "GpuProfiler.hpp"
+#include "InstanceStream.hpp"
+#include "OceanSurface.hpp"
 #include "Resources.hpp"
+#include "StartupProfiler.hpp"
 #include "Utils.hpp"
 
 struct QueueFamilyIndex
@@ -22,13 +31,30 @@ struct QueueFamilyIndex
 struct layerProperties
 {
     VkLayerProperties properties;
+    // extension lists are filled lazily, the flags tell whether they were queried
+    bool instanceExtensionsQueried = false;
+    bool deviceExtensionsQueried = false;
     std::vector<VkExtensionProperties> instanceExtensions;
     std::vector<VkExtensionProperties> deviceExtensions;
 };
 
+struct DeviceScore
+{
+    uint32_t index = 0;
+    int64_t score = -1;
+    std::string name;
+    std::string uuid;
+    VkPhysicalDeviceType deviceType = VK_PHYSICAL_DEVICE_TYPE_OTHER;
+    uint64_t deviceLocalMB = 0;
+    bool preferred = false;
+    std::string rejectReason;
+};
+
 class VulkanRHI
 {
   public:
+    static const uint32_t MaxFramesInFlight = 2;
+
     VulkanRHI();
     ~VulkanRHI();
 
@@ -39,7 +65,56 @@ class VulkanRHI
     void Init(void *view);
 #endif
 
+    // enumerate and log every layer and extension, diagnostic only
+    void DumpCapabilities();
+
+    // Create an isolated render context that reuses this instance and, when shareDevice is set, its
+    // VkDevice. The context owns its own queue, command pool and resources and renders headless.
+    // Must be called after Init2.
+    std::shared_ptr<VulkanRHI> CreateContext(bool shareDevice = true, const std::string &preferredDevice = "");
+
+    // lock held while submitting to m_graphicsQueue, queues may be shared between contexts
+    std::mutex &GetQueueMutex();
+
+    // device name substring or VkPhysicalDeviceIDProperties::deviceUUID in hex, must be set before Init
+    void SetPreferredDevice(const std::string &nameOrUuid);
+    const std::vector<DeviceScore> &GetDeviceScores() const;
+
+    // timestamp zones per pass, call BeginFrame on it at the start of each frame's commands
+    GpuProfiler &GetGpuProfiler();
+    // Creates the culler's buffers and compute pipeline for the given capacity, after Init2. Returns
+    // false when the device cannot draw gpu culled commands, the caller keeps its cpu path then.
+    bool InitGpuCuller(const GpuCuller::Limits &limits);
+    GpuCuller &GetGpuCuller();
+    bool IsDeviceExtensionEnabled(const char *extensionName) const;
+
+    // per-phase timings of Init/Init2, see StartupProfiler
+    const StartupProfiler &GetStartupProfiler() const;
+    bool WriteStartupReport(const std::string &path) const;
+
+    // The uniform buffer holds one mvp slot per frame in flight, bound as a dynamic uniform buffer.
+    // UpdateUniforms copies the camera's mvp into the frame's slot only if the camera changed
+    // since that slot was last written.
+    Camera &GetCamera();
+    void UpdateUniforms(uint32_t frameIndex);
+    uint32_t GetUniformOffset(uint32_t frameIndex) const;
+
+    // per-instance vertex data for instanced draws, one slot per frame in flight, after Init2
+    void InitInstanceStream(uint32_t maxInstances);
+    InstanceStream &GetInstanceStream();
+
+    // Spectral ocean maps updated by compute passes, after Init2. Returns false when RenderCore
+    // was built without shaders.
+    bool InitOcean(const OceanSettings &settings);
+    GpuOcean &GetOcean();
+
+    // level of detail and patch stream of the ocean's surface, after InitOcean; its Tessellation
+    // mode is available when the device has tessellation shaders
+    void InitOceanSurface(const OceanSurface::Settings &settings);
+    OceanSurface &GetOceanSurface();
+
   private:
+    void init2();
     void initGlobalLayerProperties();
     void initInstanceExtensionNames();
     void initDeviceExtensionNames();
@@ -47,11 +122,13 @@ class VulkanRHI
     void initEnumerateDevice();
     void initWindowSize();
     void initSwapchainExtension();
+    void initHeadlessQueueFamily();
     void initDevice();
     void initCommandPool();
     void initCommandBuffer();
     void executeBeginCommandBuffer();
     void initDeviceQueue();
+    void initGpuProfiler();
     void initSwapChain(VkImageUsageFlags usageFlags);
     void initDepthBuffer();
     void initUniformBuffer();
@@ -63,6 +140,18 @@ class VulkanRHI
     void initDeviceExtensionProperties(layerProperties &layer_props);
     void initGlobalExtensionProperties(layerProperties &layer_props);
 
+    layerProperties *findInstanceLayer(const char *layerName);
+    bool isInstanceExtensionSupported(const char *extensionName);
+    bool isDeviceExtensionSupported(const char *extensionName);
+    void enumerateInstanceExtensions(const char *layerName, std::vector<VkExtensionProperties> &extensions);
+    void enumerateDeviceExtensions(VkPhysicalDevice gpu, const char *layerName,
+                                   std::vector<VkExtensionProperties> &extensions);
+
+    void initPhysicalDeviceProperties();
+    void selectPhysicalDevice();
+    int64_t scorePhysicalDevice(VkPhysicalDevice gpu, DeviceScore &score);
+    std::string getDeviceUuid(VkPhysicalDevice gpu);
+
     bool memoryTypeFromProperties(uint32_t typeBits, VkFlags requirements_mask, uint32_t *typeIndex);
 
 #ifdef VK_USE_PLATFORM_METAL_EXT
@@ -80,24 +169,34 @@ class VulkanRHI
     VkInstance m_inst;
 
     std::vector<const char *> m_instanceLayerNames;
+    bool m_instanceLayerPropertiesQueried;
     std::vector<layerProperties> m_instanceLayerProperties;
     std::vector<const char *> m_instanceExtensionNames;
+    bool m_instanceExtensionPropertiesQueried;
     std::vector<VkExtensionProperties> m_instanceExtensionProperties;
 
     std::vector<const char *> m_deviceExtensionNames;
+    // enabled only when the selected device supports them
+    std::vector<const char *> m_optionalDeviceExtensionNames;
+    std::vector<const char *> m_enabledDeviceExtensionNames;
+    bool m_deviceExtensionPropertiesQueried;
     std::vector<VkExtensionProperties> m_deviceExtensionProperties;
 
     uint32_t m_queueFamilyCount;
     std::vector<VkQueueFamilyProperties> m_queueProps;
 
     std::vector<VkPhysicalDevice> m_gpus;
+    VkPhysicalDevice m_gpu;
+    uint32_t m_gpuIndex;
     VkPhysicalDeviceMemoryProperties m_memoryProperties;
     VkPhysicalDeviceProperties m_gpuProps;
 
     uint32_t m_graphicsQueueFamilyIndex;
     uint32_t m_presentQueueFamilyIndex;
+    uint32_t m_graphicsQueueIndex;
     VkQueue m_graphicsQueue;
     VkQueue m_presentQueue;
+    VkPhysicalDeviceFeatures m_enabledFeatures;
     VkDevice m_device;
 
     VkCommandPool m_cmdPool;
@@ -114,15 +213,29 @@ class VulkanRHI
 
     ImageResource m_depthBuf;
 
-    glm::mat4 mProjection;
-    glm::mat4 mView;
-    glm::mat4 mModel;
-    glm::mat4 mClip;
-    glm::mat4 mMVP;
+    Camera mCamera;
     BufferResource mUniformData;
+    uint8_t *mUniformMapped;
+    uint32_t mUniformStride;
+    uint64_t mUniformVersions[MaxFramesInFlight];
+    InstanceStream mInstanceStream;
+    GpuOcean mOcean;
+    OceanSurface mOceanSurface;
 
     std::vector<VkDescriptorSetLayout> mDescLayout;
     VkPipelineLayout mPipelineLayout;
+    VkRenderPass mRenderPass;
+
+  private:
+    std::shared_ptr<SharedInstance> m_sharedInstance;
+    std::shared_ptr<SharedDevice> m_sharedDevice;
+
+    StartupProfiler m_startupProfiler;
+    GpuProfiler m_gpuProfiler;
+    GpuCuller m_gpuCuller;
+
+    std::string m_preferredDevice;
+    std::vector<DeviceScore> m_deviceScores;
 };
 
 #endif // VULKAN_CORE_RHI_H
\ No newline at end of file
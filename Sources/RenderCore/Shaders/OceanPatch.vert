@@ -0,0 +1,26 @@
+#version 450
+
+// Corners of the Tessellation mode's coarse patches. The grid is centered on the camera in
+// whole patch steps, so every corner stays where it is in the world as the camera moves.
+
+layout(location = 0) in uvec2 inCorner;
+
+layout(location = 0) out vec2 outWorld;
+
+layout(push_constant) uniform Params
+{
+    vec4 eye;
+    vec4 cascadeScale;
+    // pixels per unit at unit distance, target edge pixels, slope weight, max factor
+    vec4 tessellation;
+    // patch size, patches per side, horizontal and vertical displacement bounds
+    vec4 tessPatches;
+    uint cascadeCount;
+} params;
+
+void main()
+{
+    float size = params.tessPatches.x;
+    vec2 origin = (floor(params.eye.xz / size) - floor(params.tessPatches.y * 0.5)) * size;
+    outWorld = origin + vec2(inCorner) * size;
+}
@@ -0,0 +1,64 @@
+#version 450
+
+// One instance per patch selected by OceanSurface. Odd grid vertices slide onto the coarser
+// grid as their distance approaches the end of the patch's lod range, then every cascade of
+// GpuOcean's maps displaces the vertex.
+
+layout(location = 0) in uvec2 inGrid;
+// x, z of the min corner, side, level
+layout(location = 1) in vec4 inPlacement;
+// morph start distance, 1 / morph length
+layout(location = 2) in vec4 inMorph;
+
+layout(location = 0) out vec3 outPosition;
+layout(location = 1) out vec3 outNormal;
+// jacobian of the summed horizontal displacement, below 0 the surface folds over
+layout(location = 2) out float outJacobian;
+
+layout(std140, set = 0, binding = 0) uniform Camera
+{
+    mat4 mvp;
+} camera;
+
+layout(set = 1, binding = 0) uniform sampler2DArray displacementMap;
+layout(set = 1, binding = 1) uniform sampler2DArray normalMap;
+
+layout(push_constant) uniform Params
+{
+    // xyz camera position, w 1 / quads per patch side
+    vec4 eye;
+    vec4 cascadeScale;
+    // used by the Tessellation mode's shaders
+    vec4 tessellation;
+    vec4 tessPatches;
+    uint cascadeCount;
+} params;
+
+void main()
+{
+    float step = inPlacement.z * params.eye.w;
+    vec2 grid = vec2(inGrid);
+    vec2 world = inPlacement.xy + grid * step;
+    float morph = clamp((distance(params.eye.xyz, vec3(world.x, 0.0, world.y)) - inMorph.x) * inMorph.y, 0.0, 1.0);
+    grid -= vec2(inGrid & 1u) * morph;
+    world = inPlacement.xy + grid * step;
+
+    vec3 displacement = vec3(0.0);
+    vec2 slope = vec2(0.0);
+    float jacobian = 1.0;
+    for (uint c = 0u; c < params.cascadeCount; c++)
+    {
+        vec3 uv = vec3(world * params.cascadeScale[c], float(c));
+        vec4 d = textureLod(displacementMap, uv, 0.0);
+        vec3 n = textureLod(normalMap, uv, 0.0).xyz;
+        displacement += d.xyz;
+        slope += n.xz / n.y;
+        jacobian += d.w - 1.0;
+    }
+
+    vec3 position = vec3(world.x, 0.0, world.y) + displacement;
+    outPosition = position;
+    outNormal = normalize(vec3(slope.x, 1.0, slope.y));
+    outJacobian = jacobian;
+    gl_Position = camera.mvp * vec4(position, 1.0);
+}